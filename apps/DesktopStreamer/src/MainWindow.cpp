@@ -39,58 +39,20 @@
 #include "MainWindow.h"
 #include "main.h"
 #include "../../../src/log.h"
-#include "../../../src/MessageHeader.h"
 #include "DesktopSelectionRectangle.h"
-#include <turbojpeg.h>
+#include <algorithm>
 
 #ifdef _WIN32
-    typedef __int32 int32_t;
     #include <windows.h>
-#else
-    #include <stdint.h>
 #endif
 
-ParallelPixelStreamSegment computeSegmentJpeg(const ParallelPixelStreamSegment & segment)
-{
-    ParallelPixelStreamSegment newSegment = segment;
-
-    QImage image = g_mainWindow->getImage();
-
-    // use libjpeg-turbo for JPEG conversion
-    tjhandle handle = tjInitCompress();
-    int pixelFormat = TJPF_BGRX;
-    unsigned char ** jpegBuf;
-    unsigned char * jpegBufPtr = NULL;
-    jpegBuf = &jpegBufPtr;
-    unsigned long jpegSize = 0;
-    int jpegSubsamp = TJSAMP_444;
-    int jpegQual = JPEG_QUALITY;
-    int flags = 0;
-
-    int success = tjCompress2(handle, image.scanLine(newSegment.parameters.y) + newSegment.parameters.x * image.depth()/8, newSegment.parameters.width, image.bytesPerLine(), newSegment.parameters.height, pixelFormat, jpegBuf, &jpegSize, jpegSubsamp, jpegQual, flags);
-
-    if(success != 0)
-    {
-        put_flog(LOG_ERROR, "libjpeg-turbo image conversion failure");
-
-        return newSegment;
-    }
-
-    // move the JPEG buffer to a byte array and free the libjpeg-turbo allocated memory
-    QByteArray byteArray((char *)jpegBufPtr, jpegSize);
-    free(jpegBufPtr);
-
-    // copy byte array to new segment
-    newSegment.imageData = byteArray;
-
-    return newSegment;
-}
-
 MainWindow::MainWindow()
 {
     // defaults
-    updatedDimensions_ = true;
     parallelStreaming_ = false;
+    previousImageHash_ = 0;
+    dcSocket_ = NULL;
+    encoderOptions_ = dcStreamGetDefaultEncoderOptions();
 
     QWidget * widget = new QWidget();
     QFormLayout * layout = new QFormLayout();
@@ -125,6 +87,17 @@ MainWindow::MainWindow()
     frameRateSpinBox_.setRange(1, 60);
     frameRateSpinBox_.setValue(24);
 
+    // encoder settings; in adaptive mode the quality is a maximum
+    qualitySpinBox_.setRange(1, 100);
+    qualitySpinBox_.setValue(JPEG_QUALITY);
+
+    subsamplingComboBox_.addItem("4:4:4", DC_STREAM_SUBSAMPLING_444);
+    subsamplingComboBox_.addItem("4:2:2", DC_STREAM_SUBSAMPLING_422);
+    subsamplingComboBox_.addItem("4:2:0", DC_STREAM_SUBSAMPLING_420);
+
+    fastDCTCheckBox_.setText("Fast DCT");
+    adaptiveQualityCheckBox_.setText("Adapt quality to frame rate");
+
     // add widgets to UI
     layout->addRow("Hostname", &hostnameLineEdit_);
     layout->addRow("Stream name", &uriLineEdit_);
@@ -134,6 +107,11 @@ MainWindow::MainWindow()
     layout->addRow("Height", &heightSpinBox_);
     layout->addRow("Max frame rate", &frameRateSpinBox_);
     layout->addRow("Actual frame rate", &frameRateLabel_);
+    layout->addRow("JPEG quality", &qualitySpinBox_);
+    layout->addRow("Chroma subsampling", &subsamplingComboBox_);
+    layout->addRow("", &fastDCTCheckBox_);
+    layout->addRow("", &adaptiveQualityCheckBox_);
+    layout->addRow("Actual quality", &qualityLabel_);
 
     // share desktop action
     shareDesktopAction_ = new QAction("Share Desktop", this);
@@ -185,11 +163,6 @@ void MainWindow::getCoordinates(int &x, int &y, int &width, int &height)
 
 void MainWindow::setCoordinates(int x, int y, int width, int height)
 {
-    if(width != width_ || height != height_)
-    {
-        updatedDimensions_ = true;
-    }
-
     xSpinBox_.setValue(x);
     ySpinBox_.setValue(y);
     widthSpinBox_.setValue(width);
@@ -199,11 +172,6 @@ void MainWindow::setCoordinates(int x, int y, int width, int height)
     updateCoordinates();
 }
 
-QImage MainWindow::getImage()
-{
-    return image_;
-}
-
 void MainWindow::shareDesktop(bool set)
 {
     if(set == true)
@@ -213,10 +181,11 @@ void MainWindow::shareDesktop(bool set)
         uri_ = uriLineEdit_.text().toStdString();
 
         // open connection (disconnecting from an existing connection if necessary)
-        tcpSocket_.disconnectFromHost();
-        tcpSocket_.connectToHost(hostname_.c_str(), 1701);
+        // the protocol handshake and version checks are done by the library
+        dcStreamDisconnect(dcSocket_);
+        dcSocket_ = dcStreamConnect(hostname_.c_str());
 
-        if(tcpSocket_.waitForConnected() != true)
+        if(dcSocket_ == NULL)
         {
             put_flog(LOG_ERROR, "could not connect");
             QMessageBox::warning(this, "Error", "Could not connect.", QMessageBox::Ok, QMessageBox::Ok);
@@ -225,36 +194,18 @@ void MainWindow::shareDesktop(bool set)
             return;
         }
 
-        // handshake
-        while(tcpSocket_.waitForReadyRead() && tcpSocket_.bytesAvailable() < (int)sizeof(int32_t))
-        {
-#ifndef _WIN32
-            usleep(10);
-#endif
-        }
+        // the server doesn't have our image yet
+        previousImageHash_ = 0;
 
-        int32_t protocolVersion = -1;
-        tcpSocket_.read((char *)&protocolVersion, sizeof(int32_t));
-
-        if(protocolVersion != SUPPORTED_NETWORK_PROTOCOL_VERSION)
-        {
-            tcpSocket_.disconnectFromHost();
-            shareDesktopAction_->setChecked(false);
-
-            put_flog(LOG_ERROR, "unsupported protocol version %i > %i", protocolVersion, SUPPORTED_NETWORK_PROTOCOL_VERSION);
-            QMessageBox::warning(this, "Error", "This version is incompatible with the DisplayCluster instance you connected to. (" + QString::number(protocolVersion) + " != " + QString::number(SUPPORTED_NETWORK_PROTOCOL_VERSION) + ")", QMessageBox::Ok, QMessageBox::Ok);
-
-            return;
-        }
-
-        // make sure dimensions get updated
-        updatedDimensions_ = true;
+        // the new connection has the default encoder options
+        encoderOptions_ = dcStreamGetEncoderOptions(dcSocket_);
 
         shareDesktopUpdateTimer_.start(SHARE_DESKTOP_UPDATE_DELAY);
     }
     else
     {
-        tcpSocket_.disconnectFromHost();
+        dcStreamDisconnect(dcSocket_);
+        dcSocket_ = NULL;
 
         shareDesktopUpdateTimer_.stop();
 
@@ -291,7 +242,7 @@ void MainWindow::shareDesktopUpdate()
     QTime frameTime;
     frameTime.start();
 
-    if(tcpSocket_.state() != QAbstractSocket::ConnectedState)
+    if(dcSocket_ == NULL)
     {
         put_flog(LOG_ERROR, "socket is not connected");
         QMessageBox::warning(this, "Error", "Socket is not connected.", QMessageBox::Ok, QMessageBox::Ok);
@@ -308,75 +259,27 @@ void MainWindow::shareDesktopUpdate()
         put_flog(LOG_ERROR, "got NULL desktop pixmap");
         QMessageBox::warning(this, "Error", "Got NULL desktop pixmap.", QMessageBox::Ok, QMessageBox::Ok);
 
-        tcpSocket_.disconnectFromHost();
         shareDesktopAction_->setChecked(false);
         return;
     }
 
-    // convert to QImage
-    image_ = desktopPixmap.toImage();
+    // convert to QImage, flipped since the library expects the bottom row first
+    image_ = desktopPixmap.toImage().mirrored();
+
+    // encoder settings for this frame
+    updateEncoderSettings();
 
     bool success;
 
     if(parallelStreaming_ == false)
     {
-        // stream as one big image
+        // stream as one big image; the library sends the dimensions when they change
         success = serialStream();
-
-        // check if we updated dimensions
-        if(updatedDimensions_ == true)
-        {
-            // updated dimensions
-            int dimensions[2];
-            dimensions[0] = width_;
-            dimensions[1] = height_;
-
-            int dimensionsSize = 2 * sizeof(int);
-
-            // header
-            MessageHeader mh;
-            mh.size = dimensionsSize;
-            mh.type = MESSAGE_TYPE_PIXELSTREAM_DIMENSIONS_CHANGED;
-
-            // add the truncated URI to the header
-            size_t len = uri_.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
-            mh.uri[len] = '\0';
-
-            // send the header
-            int sent = tcpSocket_.write((const char *)&mh, sizeof(MessageHeader));
-
-            while(sent < (int)sizeof(MessageHeader))
-            {
-                sent += tcpSocket_.write((const char *)&mh + sent, sizeof(MessageHeader) - sent);
-            }
-
-            // send the message
-            sent = tcpSocket_.write((const char *)dimensions, dimensionsSize);
-
-            while(sent < dimensionsSize)
-            {
-                sent += tcpSocket_.write((const char *)dimensions + sent, dimensionsSize - sent);
-            }
-
-            updatedDimensions_ = false;
-
-            // wait for acknowledgment
-            while(tcpSocket_.waitForReadyRead() && tcpSocket_.bytesAvailable() < 3)
-            {
-    #ifndef _WIN32
-                usleep(10);
-    #endif
-            }
-
-            tcpSocket_.read(3);
-        }
     }
     else
     {
         // stream in segments
         success = parallelStream();
-
-        // no need to watch for dimension changes; server handles it automatically
     }
 
     // check for failure
@@ -385,7 +288,6 @@ void MainWindow::shareDesktopUpdate()
         put_flog(LOG_ERROR, "streaming failure");
         QMessageBox::warning(this, "Error", "Streaming failure.", QMessageBox::Ok, QMessageBox::Ok);
 
-        tcpSocket_.disconnectFromHost();
         shareDesktopAction_->setChecked(false);
         return;
     }
@@ -426,11 +328,6 @@ void MainWindow::shareDesktopUpdate()
 
 void MainWindow::updateCoordinates()
 {
-    if(widthSpinBox_.value() != width_ || heightSpinBox_.value() != height_)
-    {
-        updatedDimensions_ = true;
-    }
-
     x_ = xSpinBox_.value();
     y_ = ySpinBox_.value();
     width_ = widthSpinBox_.value();
@@ -441,173 +338,63 @@ void MainWindow::updateCoordinates()
     {
         g_desktopSelectionWindow->getDesktopSelectionView()->getDesktopSelectionRectangle()->setCoordinates(x_, y_, width_, height_);
     }
-
-    // update ParallelPixelStreamSegment parameters, whether or not we are currently streaming in parallel
-    // users can toggle parallel streaming at any time
-    segments_.clear();
-
-    // segment dimensions will be approximately this
-    int nominalSegmentSize = 512;
-
-    // number of subdivisions in each dimensions
-    int numSubdivisionsX = (int)floor((float)width_ / (float)nominalSegmentSize + 0.5);
-    int numSubdivisionsY = (int)floor((float)height_ / (float)nominalSegmentSize + 0.5);
-
-    // now, create segments with appropriate parameters
-    for(int i=0; i<numSubdivisionsX; i++)
-    {
-        for(int j=0; j<numSubdivisionsY; j++)
-        {
-            ParallelPixelStreamSegment segment;
-
-            segment.parameters.sourceIndex = i*numSubdivisionsY + j;
-            segment.parameters.x = i * (int)((float)width_ / (float)numSubdivisionsX);
-            segment.parameters.y = j * (int)((float)height_ / (float)numSubdivisionsY);
-            segment.parameters.width = (int)((float)width_ / (float)numSubdivisionsX);
-            segment.parameters.height = (int)((float)height_ / (float)numSubdivisionsY);
-            segment.parameters.totalWidth = width_;
-            segment.parameters.totalHeight = height_;
-
-            segments_.push_back(segment);
-        }
-    }
 }
 
 bool MainWindow::serialStream()
 {
-    // use libjpeg-turbo for JPEG conversion
-    tjhandle handle = tjInitCompress();
-    int pixelFormat = TJPF_BGRX;
-    unsigned char ** jpegBuf;
-    unsigned char * jpegBufPtr = NULL;
-    jpegBuf = &jpegBufPtr;
-    unsigned long jpegSize = 0;
-    int jpegSubsamp = TJSAMP_444;
-    int jpegQual = JPEG_QUALITY;
-    int flags = 0;
-
-    int success = tjCompress2(handle, image_.scanLine(0), image_.width(), image_.bytesPerLine(), image_.height(), pixelFormat, jpegBuf, &jpegSize, jpegSubsamp, jpegQual, flags);
-
-    if(success != 0)
-    {
-        put_flog(LOG_ERROR, "libjpeg-turbo image conversion failure");
-        QMessageBox::warning(this, "Error", "Image conversion failure.", QMessageBox::Ok, QMessageBox::Ok);
+    // don't encode or send the image if it didn't change
+    uint64_t imageHash = computeImageHash(image_.bits(), image_.width() * image_.depth() / 8, image_.bytesPerLine(), image_.height());
 
-        return false;
+    if(imageHash == previousImageHash_)
+    {
+        return true;
     }
 
-    // move the JPEG buffer to a byte array and free the libjpeg-turbo allocated memory
-    QByteArray byteArray((char *)jpegBufPtr, jpegSize);
-    free(jpegBufPtr);
-
-    if(byteArray != previousImageData_)
+    // QImage::Format_RGB32 pixels are BGRA in memory
+    if(dcStreamSendPixelStream(dcSocket_, uri_, image_.bits(), image_.width(), image_.bytesPerLine(), image_.height(), BGRA) != true)
     {
-        MessageHeader mh;
-        mh.size = byteArray.size();
-        mh.type = MESSAGE_TYPE_PIXELSTREAM;
-
-        // add the truncated URI to the header
-        size_t len = uri_.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
-        mh.uri[len] = '\0';
-
-        // send the header
-        int sent = tcpSocket_.write((const char *)&mh, sizeof(MessageHeader));
-
-        while(sent < (int)sizeof(MessageHeader))
-        {
-            sent += tcpSocket_.write((const char *)&mh + sent, sizeof(MessageHeader) - sent);
-        }
-
-        // send the message
-        sent = tcpSocket_.write((const char *)byteArray.data(), byteArray.size());
-
-        while(sent < byteArray.size())
-        {
-            sent += tcpSocket_.write((const char *)byteArray.data() + sent, byteArray.size() - sent);
-        }
-
-        previousImageData_ = byteArray;
-
-        // wait for acknowledgment
-        while(tcpSocket_.waitForReadyRead() && tcpSocket_.bytesAvailable() < 3)
-        {
-#ifndef _WIN32
-            usleep(10);
-#endif
-        }
-
-        tcpSocket_.read(3);
+        return false;
     }
 
+    previousImageHash_ = imageHash;
+
     return true;
 }
 
 bool MainWindow::parallelStream()
 {
-    // frame index
-    static int frameIndex = 0;
-
-    // create JPEGs for each segment, in parallel
-    std::vector<ParallelPixelStreamSegment> segments = QtConcurrent::blockingMapped<std::vector<ParallelPixelStreamSegment> >(segments_, &computeSegmentJpeg);
-
-    // stream segments
-    // we have to stream all of them in case stream synchronization is on (we can't ignore unchanged segments... todo: fix this)
-    for(unsigned int i=0; i<segments.size(); i++)
-    {
-        // update frame index
-        segments[i].parameters.frameIndex = frameIndex;
-
-        // send the parameters and image data
-        MessageHeader mh;
-        mh.size = sizeof(ParallelPixelStreamSegmentParameters) + segments[i].imageData.size();
-        mh.type = MESSAGE_TYPE_PARALLEL_PIXELSTREAM;
-
-        // add the truncated URI to the header
-        size_t len = uri_.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
-        mh.uri[len] = '\0';
-
-        // send the header
-        int sent = tcpSocket_.write((const char *)&mh, sizeof(MessageHeader));
+    // segments are compressed in parallel; unchanged segments are skipped, and resent periodically, by the library
+    std::vector<DcStreamParameters> parameters = dcStreamGenerateParameters(uri_, 0, SEGMENT_SIZE, SEGMENT_SIZE, 0, 0, image_.width(), image_.height(), image_.width(), image_.height());
 
-        while(sent < (int)sizeof(MessageHeader))
-        {
-            sent += tcpSocket_.write((const char *)&mh + sent, sizeof(MessageHeader) - sent);
-        }
-
-        // send the message
-
-        // part 1: parameters
-        sent = tcpSocket_.write((const char *)&(segments[i].parameters), sizeof(ParallelPixelStreamSegmentParameters));
-
-        while(sent < (int)sizeof(ParallelPixelStreamSegmentParameters))
-        {
-            sent += tcpSocket_.write((const char *)&(segments[i].parameters) + sent, sizeof(ParallelPixelStreamSegmentParameters) - sent);
-        }
+    bool success = dcStreamSend(dcSocket_, image_.bits(), 0, 0, image_.width(), image_.bytesPerLine(), image_.height(), BGRA, parameters);
 
-        // part 2: image data
-        sent = tcpSocket_.write((const char *)segments[i].imageData.data(), segments[i].imageData.size());
+    // increment frame index
+    dcStreamIncrementFrameIndex();
 
-        while(sent < segments[i].imageData.size())
-        {
-            sent += tcpSocket_.write((const char *)segments[i].imageData.data() + sent, segments[i].imageData.size() - sent);
-        }
+    return success;
+}
 
-        // wait for acknowledgment
-        while(tcpSocket_.waitForReadyRead() && tcpSocket_.bytesAvailable() < 3)
-        {
-#ifndef _WIN32
-            usleep(10);
-#endif
-        }
+void MainWindow::updateEncoderSettings()
+{
+    // the library adapts the quality to the frame rate, with the quality spin box giving the maximum quality
+    DcStreamEncoderOptions options = encoderOptions_;
+
+    options.codec = DC_STREAM_CODEC_JPEG;
+    options.quality = qualitySpinBox_.value();
+    options.subsampling = (DC_STREAM_SUBSAMPLING)subsamplingComboBox_.itemData(subsamplingComboBox_.currentIndex()).toInt();
+    options.fastDCT = fastDCTCheckBox_.isChecked();
+    options.adaptive = adaptiveQualityCheckBox_.isChecked();
+    options.targetFrameRate = frameRateSpinBox_.value();
+    options.minQuality = std::min(dcStreamGetDefaultEncoderOptions().minQuality, options.quality);
+
+    // only set changed options, since that restarts adaptation from the maximum quality
+    if(options.quality != encoderOptions_.quality || options.subsampling != encoderOptions_.subsampling || options.fastDCT != encoderOptions_.fastDCT || options.adaptive != encoderOptions_.adaptive || options.targetFrameRate != encoderOptions_.targetFrameRate || options.minQuality != encoderOptions_.minQuality || options.codec != encoderOptions_.codec)
+    {
+        dcStreamSetEncoderOptions(dcSocket_, options);
 
-        tcpSocket_.read(3);
+        encoderOptions_ = options;
     }
 
-    // update segments vector
-    segments_ = segments;
-
-    // increment frame index
-    frameIndex++;
-
-    return true;
+    // the quality actually used
+    qualityLabel_.setText(QString::number(dcStreamGetEncoderOptions(dcSocket_).quality));
 }
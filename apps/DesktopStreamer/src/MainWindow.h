@@ -39,21 +39,20 @@
 #ifndef MAIN_WINDOW_H
 #define MAIN_WINDOW_H
 
-#define SUPPORTED_NETWORK_PROTOCOL_VERSION 3
-
 #define SHARE_DESKTOP_UPDATE_DELAY 1
 
 #define FRAME_RATE_AVERAGE_NUM_FRAMES 10
 
+// nominal dimensions of segments for parallel streaming
+#define SEGMENT_SIZE 512
+
 #define JPEG_QUALITY 75
 
-#include "../../../src/ParallelPixelStream.h"
+#include "../../../src/lib/dcStream.h"
+#include "../../../src/ImageHash.h"
 #include <QtGui>
-#include <QtNetwork/QTcpSocket>
 #include <string>
 
-ParallelPixelStreamSegment computeSegmentJpeg(const ParallelPixelStreamSegment & segment);
-
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -64,8 +63,6 @@ class MainWindow : public QMainWindow {
         void getCoordinates(int &x, int &y, int &width, int &height);
         void setCoordinates(int x, int y, int width, int height);
 
-        QImage getImage();
-
     public slots:
 
         void shareDesktop(bool set);
@@ -76,8 +73,6 @@ class MainWindow : public QMainWindow {
 
     private:
 
-        bool updatedDimensions_;
-
         QLineEdit hostnameLineEdit_;
         QLineEdit uriLineEdit_;
         QSpinBox xSpinBox_;
@@ -86,6 +81,11 @@ class MainWindow : public QMainWindow {
         QSpinBox heightSpinBox_;
         QSpinBox frameRateSpinBox_;
         QLabel frameRateLabel_;
+        QSpinBox qualitySpinBox_;
+        QComboBox subsamplingComboBox_;
+        QCheckBox fastDCTCheckBox_;
+        QCheckBox adaptiveQualityCheckBox_;
+        QLabel qualityLabel_;
 
         QAction * shareDesktopAction_;
         QAction * showDesktopSelectionWindowAction_;
@@ -99,21 +99,24 @@ class MainWindow : public QMainWindow {
 
         bool parallelStreaming_;
 
-        // full image
-        QImage image_;
+        // encoder options last set on the connection; setting them restarts quality adaptation
+        DcStreamEncoderOptions encoderOptions_;
 
-        // for regular pixel streaming
-        QByteArray previousImageData_;
+        // full image, bottom row first
+        QImage image_;
 
-        // for parallel pixel streaming
-        std::vector<ParallelPixelStreamSegment> segments_;
+        // for regular pixel streaming: hash of the last image sent
+        uint64_t previousImageHash_;
 
         QTimer shareDesktopUpdateTimer_;
 
         // used for frame rate calculations
         std::vector<QTime> frameSentTimes_;
 
-        QTcpSocket tcpSocket_;
+        // connection to the DisplayCluster instance, which handles flow control and unchanged segments
+        DcSocket * dcSocket_;
+
+        void updateEncoderSettings();
 
         bool serialStream();
         bool parallelStream();
@@ -0,0 +1,399 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include <mpi.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// how long rank 0 is blocked handing off display group updates to the render processes, while one render process
+// is deliberately slow, comparing the synchronous hand-off DisplayCluster used to do (a send of the header to each
+// render process, a broadcast of the payload and a barrier, all on MPI_COMM_WORLD) with the asynchronous one (a
+// non-blocking send to rank 1, which broadcasts to the other render processes at the start of their next frame)
+// the render processes only emulate the frame loop: they receive updates at the start of each frame, sleep for the
+// frame time, and synchronize with a barrier at the end of the frame, like updateGLWindows()
+
+#define HANDOFF_BENCHMARK_TAG 0
+
+#define HANDOFF_BENCHMARK_UPDATE 0
+#define HANDOFF_BENCHMARK_QUIT 1
+
+struct HandoffBenchmarkHeader {
+    int type;
+    int size;
+};
+
+void syntax(char * app);
+
+int g_mpiRank;
+int g_mpiSize;
+MPI_Comm g_mpiRenderComm;
+
+bool g_synchronous = false;
+int g_numUpdates = 200;
+int g_updateInterval = 5;
+int g_payloadSize = 16384;
+int g_frameTime = 16;
+int g_slowTime = 50;
+
+// rank 0: the time (ms) spent handing off each update
+std::vector<double> g_handoffTimes;
+
+void sendSynchronous(int type, std::vector<char> & payload)
+{
+    HandoffBenchmarkHeader header;
+    header.type = type;
+    header.size = payload.size();
+
+    for(int i=1; i<g_mpiSize; i++)
+    {
+        MPI_Send((void *)&header, sizeof(header), MPI_BYTE, i, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD);
+    }
+
+    if(type == HANDOFF_BENCHMARK_QUIT)
+    {
+        return;
+    }
+
+    MPI_Bcast((void *)&payload[0], payload.size(), MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+// returns false when the quit message was received
+bool receiveSynchronous()
+{
+    // only receive messages all render processes have, so they stay synchronized
+    int flag;
+    MPI_Status status;
+    MPI_Iprobe(0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &flag, &status);
+
+    int allFlag;
+    MPI_Allreduce(&flag, &allFlag, 1, MPI_INT, MPI_LAND, g_mpiRenderComm);
+
+    while(allFlag != 0)
+    {
+        HandoffBenchmarkHeader header;
+        MPI_Recv((void *)&header, sizeof(header), MPI_BYTE, 0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &status);
+
+        if(header.type == HANDOFF_BENCHMARK_QUIT)
+        {
+            return false;
+        }
+
+        std::vector<char> payload(header.size);
+        MPI_Bcast((void *)&payload[0], payload.size(), MPI_BYTE, 0, MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        MPI_Iprobe(0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &flag, &status);
+        MPI_Allreduce(&flag, &allFlag, 1, MPI_INT, MPI_LAND, g_mpiRenderComm);
+    }
+
+    return true;
+}
+
+// rank 0: outstanding asynchronous sends and their buffers
+std::vector<MPI_Request> g_sendRequests;
+std::vector<std::vector<char> *> g_sendBuffers;
+
+void testSendRequests()
+{
+    for(unsigned int i=0; i<g_sendRequests.size(); )
+    {
+        int flag;
+        MPI_Status status;
+        MPI_Test(&g_sendRequests[i], &flag, &status);
+
+        if(flag != 0)
+        {
+            delete g_sendBuffers[i];
+
+            g_sendRequests.erase(g_sendRequests.begin() + i);
+            g_sendBuffers.erase(g_sendBuffers.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void sendAsynchronous(int type, std::vector<char> & payload)
+{
+    HandoffBenchmarkHeader header;
+    header.type = type;
+    header.size = payload.size();
+
+    std::vector<char> * buffer = new std::vector<char>(sizeof(header) + payload.size());
+    memcpy(&(*buffer)[0], &header, sizeof(header));
+
+    if(payload.size() > 0)
+    {
+        memcpy(&(*buffer)[sizeof(header)], &payload[0], payload.size());
+    }
+
+    MPI_Request request;
+    MPI_Isend((void *)&(*buffer)[0], buffer->size(), MPI_BYTE, 1, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &request);
+
+    g_sendRequests.push_back(request);
+    g_sendBuffers.push_back(buffer);
+
+    testSendRequests();
+}
+
+// returns false when the quit message was received
+bool receiveAsynchronous()
+{
+    // rank 1 collects all messages from rank 0 and broadcasts them to the other render processes
+    std::vector<char> batch;
+
+    if(g_mpiRank == 1)
+    {
+        int flag;
+        MPI_Status status;
+        MPI_Iprobe(0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &flag, &status);
+
+        while(flag != 0)
+        {
+            int count;
+            MPI_Get_count(&status, MPI_BYTE, &count);
+
+            std::vector<char> message(count);
+            MPI_Recv((void *)&message[0], count, MPI_BYTE, 0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &status);
+
+            batch.insert(batch.end(), message.begin(), message.end());
+
+            MPI_Iprobe(0, HANDOFF_BENCHMARK_TAG, MPI_COMM_WORLD, &flag, &status);
+        }
+    }
+
+    int batchSize = batch.size();
+    MPI_Bcast((void *)&batchSize, 1, MPI_INT, 0, g_mpiRenderComm);
+
+    if(batchSize == 0)
+    {
+        return true;
+    }
+
+    batch.resize(batchSize);
+    MPI_Bcast((void *)&batch[0], batchSize, MPI_BYTE, 0, g_mpiRenderComm);
+
+    for(unsigned int offset=0; offset<batch.size(); )
+    {
+        HandoffBenchmarkHeader header;
+        memcpy(&header, &batch[offset], sizeof(header));
+
+        if(header.type == HANDOFF_BENCHMARK_QUIT)
+        {
+            return false;
+        }
+
+        offset += sizeof(header) + header.size;
+    }
+
+    return true;
+}
+
+void runRank0()
+{
+    std::vector<char> payload(g_payloadSize, 'x');
+    std::vector<char> empty;
+
+    for(int i=0; i<g_numUpdates; i++)
+    {
+        usleep(g_updateInterval * 1000);
+
+        double start = MPI_Wtime();
+
+        if(g_synchronous == true)
+        {
+            sendSynchronous(HANDOFF_BENCHMARK_UPDATE, payload);
+        }
+        else
+        {
+            sendAsynchronous(HANDOFF_BENCHMARK_UPDATE, payload);
+        }
+
+        g_handoffTimes.push_back((MPI_Wtime() - start) * 1000.);
+    }
+
+    if(g_synchronous == true)
+    {
+        sendSynchronous(HANDOFF_BENCHMARK_QUIT, empty);
+    }
+    else
+    {
+        sendAsynchronous(HANDOFF_BENCHMARK_QUIT, empty);
+
+        std::vector<MPI_Status> statuses(g_sendRequests.size());
+        MPI_Waitall(g_sendRequests.size(), &g_sendRequests[0], &statuses[0]);
+
+        for(unsigned int i=0; i<g_sendBuffers.size(); i++)
+        {
+            delete g_sendBuffers[i];
+        }
+    }
+}
+
+void runRenderProcess()
+{
+    int frames = 0;
+
+    while(true)
+    {
+        bool running = (g_synchronous == true) ? receiveSynchronous() : receiveAsynchronous();
+
+        if(running != true)
+        {
+            break;
+        }
+
+        // the last render process is the slow one
+        usleep((g_frameTime + (g_mpiRank == g_mpiSize - 1 ? g_slowTime : 0)) * 1000);
+
+        MPI_Barrier(g_mpiRenderComm);
+
+        frames++;
+    }
+
+    if(g_mpiRank == 1)
+    {
+        std::cout << "render processes: " << frames << " frames" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &g_mpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &g_mpiSize);
+
+    // read command-line arguments
+    for(int i=1; i<argc; i++)
+    {
+        if(argv[i][0] == '-' && argv[i][1] == 'b')
+        {
+            g_synchronous = true;
+        }
+        else if(argv[i][0] == '-' && i+1 < argc)
+        {
+            switch(argv[i][1])
+            {
+                case 'u':
+                    g_numUpdates = atoi(argv[i+1]);
+                    break;
+                case 'i':
+                    g_updateInterval = atoi(argv[i+1]);
+                    break;
+                case 'p':
+                    g_payloadSize = atoi(argv[i+1]);
+                    break;
+                case 'f':
+                    g_frameTime = atoi(argv[i+1]);
+                    break;
+                case 's':
+                    g_slowTime = atoi(argv[i+1]);
+                    break;
+                default:
+                    syntax(argv[0]);
+            }
+
+            i++;
+        }
+        else
+        {
+            syntax(argv[0]);
+        }
+    }
+
+    if(g_mpiSize < 2 || g_numUpdates <= 0 || g_payloadSize <= 0)
+    {
+        syntax(argv[0]);
+    }
+
+    // the render processes' communicator, as in DisplayCluster
+    MPI_Comm_split(MPI_COMM_WORLD, g_mpiRank != 0, g_mpiRank, &g_mpiRenderComm);
+
+    if(g_mpiRank == 0)
+    {
+        runRank0();
+
+        std::vector<double> times = g_handoffTimes;
+        std::sort(times.begin(), times.end());
+
+        double total = 0.;
+
+        for(unsigned int i=0; i<times.size(); i++)
+        {
+            total += times[i];
+        }
+
+        std::cout << (g_synchronous == true ? "synchronous (barrier)" : "asynchronous") << " hand-off, " << g_mpiSize - 1 << " render processes, frame time " << g_frameTime << " ms, slowest process +" << g_slowTime << " ms" << std::endl;
+        std::cout << "rank 0 blocked per update (ms): mean " << total / (double)times.size() << ", p50 " << times[times.size() / 2] << ", p95 " << times[(times.size() - 1) * 95 / 100] << ", max " << times.back() << std::endl;
+    }
+    else
+    {
+        runRenderProcess();
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
+
+void syntax(char * app)
+{
+    if(g_mpiRank == 0)
+    {
+        std::cerr << "syntax: mpirun -np <processes> " << app << " [options]" << std::endl;
+        std::cerr << "at least 2 processes are needed: rank 0 and one or more render processes" << std::endl;
+        std::cerr << "options:" << std::endl;
+        std::cerr << " -b                   use the synchronous hand-off with a barrier (default asynchronous)" << std::endl;
+        std::cerr << " -u <updates>         set number of updates (default 200)" << std::endl;
+        std::cerr << " -i <interval>        set interval (ms) between updates (default 5)" << std::endl;
+        std::cerr << " -p <bytes>           set update payload size (default 16384)" << std::endl;
+        std::cerr << " -f <frame time>      set render process frame time (ms) (default 16)" << std::endl;
+        std::cerr << " -s <slow time>       set additional frame time (ms) of the last render process (default 50)" << std::endl;
+    }
+
+    MPI_Finalize();
+
+    exit(1);
+}
@@ -0,0 +1,197 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "dcStream.h"
+#include <QtCore>
+#include <turbojpeg.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+// segments/sec of JPEG compression, comparing a new libjpeg-turbo handle and output buffer for each segment
+// (as dcStreamComputeJpeg() used to do) with the reused handle and caller-owned buffer of dcStreamComputeJpeg()
+
+void syntax(char * app);
+
+// the previous implementation: new handle, buffer allocated by libjpeg-turbo and copied to the caller's buffer
+bool computeJpegNewHandle(unsigned char * imageBuffer, int width, int pitch, int height, char ** jpegData, int & jpegSize)
+{
+    tjhandle tjHandle = tjInitCompress();
+
+    unsigned char * tjJpegBuf = NULL;
+    unsigned long tjJpegSize = 0;
+
+    if(tjCompress2(tjHandle, imageBuffer, width, pitch, height, TJPF_RGBX, &tjJpegBuf, &tjJpegSize, TJSAMP_444, 75, TJFLAG_BOTTOMUP) != 0)
+    {
+        tjDestroy(tjHandle);
+        return false;
+    }
+
+    *jpegData = (char *)realloc((void *)*jpegData, tjJpegSize);
+    memcpy(*jpegData, tjJpegBuf, tjJpegSize);
+    tjFree(tjJpegBuf);
+
+    jpegSize = tjJpegSize;
+
+    tjDestroy(tjHandle);
+
+    return true;
+}
+
+// a test image with smooth gradients and some noise, so it compresses like typical content
+std::vector<unsigned char> generateImage(int width, int height)
+{
+    std::vector<unsigned char> image(width * height * 4);
+
+    srand(1);
+
+    for(int y=0; y<height; y++)
+    {
+        for(int x=0; x<width; x++)
+        {
+            unsigned char * pixel = &image[(y * width + x) * 4];
+
+            int noise = rand() % 16;
+
+            pixel[0] = (unsigned char)((x * 255 / width + noise) % 256);
+            pixel[1] = (unsigned char)((y * 255 / height + noise) % 256);
+            pixel[2] = (unsigned char)(((x + y) * 127 / (width + height) + noise) % 256);
+            pixel[3] = 255;
+        }
+    }
+
+    return image;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 200;
+
+    // read command-line arguments
+    for(int i=1; i<argc; i++)
+    {
+        if(argv[i][0] == '-')
+        {
+            switch(argv[i][1])
+            {
+                case 'i':
+                    if(i+1 < argc)
+                    {
+                        iterations = atoi(argv[i+1]);
+                        i++;
+                    }
+                    break;
+                default:
+                    syntax(argv[0]);
+            }
+        }
+        else
+        {
+            syntax(argv[0]);
+        }
+    }
+
+    if(iterations <= 0)
+    {
+        syntax(argv[0]);
+    }
+
+    int sizes[2][2] = { { 512, 512 }, { 1920, 1080 } };
+
+    for(int s=0; s<2; s++)
+    {
+        int width = sizes[s][0];
+        int height = sizes[s][1];
+
+        std::vector<unsigned char> image = generateImage(width, height);
+
+        // new handle and buffer per segment
+        char * jpegData = NULL;
+        int jpegSize = 0;
+
+        QTime time;
+        time.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            if(computeJpegNewHandle(&image[0], width, width * 4, height, &jpegData, jpegSize) != true)
+            {
+                std::cerr << "compression failed" << std::endl;
+                return 1;
+            }
+        }
+
+        int newHandleTime = time.elapsed();
+
+        free(jpegData);
+
+        // reused handle and buffer
+        std::vector<char> jpegBuffer(dcStreamGetMaxJpegSize(width, height));
+
+        time.start();
+
+        for(int i=0; i<iterations; i++)
+        {
+            if(dcStreamComputeJpeg(&image[0], width, width * 4, height, RGBA, &jpegBuffer[0], jpegBuffer.size(), jpegSize) != true)
+            {
+                std::cerr << "compression failed" << std::endl;
+                return 1;
+            }
+        }
+
+        int reusedTime = time.elapsed();
+
+        std::cout << width << "x" << height << " (" << jpegSize << " bytes): ";
+        std::cout << "new handle " << (double)iterations / ((double)std::max(newHandleTime, 1) / 1000.) << " segments/second, ";
+        std::cout << "reused handle " << (double)iterations / ((double)std::max(reusedTime, 1) / 1000.) << " segments/second" << std::endl;
+    }
+
+    return 0;
+}
+
+void syntax(char * app)
+{
+    std::cerr << "syntax: " << app << " [options]" << std::endl;
+    std::cerr << "compresses 512x512 and 1920x1080 segments and reports segments/second" << std::endl;
+    std::cerr << "options:" << std::endl;
+    std::cerr << " -i <iterations>      set number of segments compressed per size (default 200)" << std::endl;
+
+    exit(1);
+}
@@ -0,0 +1,164 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "../../../src/ImagePyramidBuilder.h"
+#include <QtCore>
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+
+void syntax(char * app);
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    std::string imageFilename;
+    std::string imagePyramidPath;
+    int jpegQuality = IMAGE_PYRAMID_JPEG_QUALITY;
+    bool convert = false;
+
+    // read command-line arguments
+    for(int i=1; i<argc; i++)
+    {
+        if(argv[i][0] == '-')
+        {
+            switch(argv[i][1])
+            {
+                case 'c':
+                    convert = true;
+                    break;
+                case 'q':
+                    if(i+1 < argc)
+                    {
+                        jpegQuality = atoi(argv[i+1]);
+                        i++;
+                    }
+                    break;
+                case 't':
+                    if(i+1 < argc)
+                    {
+                        QThreadPool::globalInstance()->setMaxThreadCount(atoi(argv[i+1]));
+                        i++;
+                    }
+                    break;
+                default:
+                    syntax(argv[0]);
+            }
+        }
+        else if(imageFilename.empty() == true)
+        {
+            imageFilename = argv[i];
+        }
+        else if(imagePyramidPath.empty() == true)
+        {
+            imagePyramidPath = argv[i];
+        }
+        else
+        {
+            syntax(argv[0]);
+        }
+    }
+
+    if(imageFilename.empty() == true)
+    {
+        syntax(argv[0]);
+    }
+
+    // convert between an image pyramid directory and a container
+    if(convert == true)
+    {
+        if(imagePyramidPath.empty() == true)
+        {
+            syntax(argv[0]);
+        }
+
+        return convertImagePyramid(imageFilename, imagePyramidPath) == true ? 0 : 1;
+    }
+
+    // same default as the "Compute Image Pyramid" action
+    if(imagePyramidPath.empty() == true)
+    {
+        if(imageFilename.find("synthetic:") == 0)
+        {
+            imagePyramidPath = "synthetic.pyramid/";
+        }
+        else
+        {
+            imagePyramidPath = imageFilename + ".pyramid/";
+        }
+    }
+
+    boost::shared_ptr<ImagePyramidSource> source = openImagePyramidSource(imageFilename);
+
+    if(source == NULL)
+    {
+        return 1;
+    }
+
+    ImagePyramidBuilder builder(source);
+    builder.setJpegQuality(jpegQuality);
+
+    if(builder.build(imagePyramidPath) != true)
+    {
+        return 1;
+    }
+
+    ImagePyramidBuilderStatistics statistics = builder.getStatistics();
+
+    std::cout << imageFilename << ": " << source->getWidth() << "x" << source->getHeight() << ", " << statistics.depth + 1 << " levels, " << statistics.tiles << " tiles" << std::endl;
+    std::cout << statistics.seconds << " seconds, " << statistics.megapixelsPerSecond << " megapixels/second with " << QThreadPool::globalInstance()->maxThreadCount() << " threads" << std::endl;
+
+    return 0;
+}
+
+void syntax(char * app)
+{
+    std::cerr << "syntax: " << app << " [options] <image> [image pyramid path]" << std::endl;
+    std::cerr << "       " << app << " -c <.pyr or .pyrc file> <.pyrc file or image pyramid directory>" << std::endl;
+    std::cerr << "the image may be any format Qt can read, a binary PPM file (read in strips)," << std::endl;
+    std::cerr << "or synthetic:<width>x<height> for a generated test pattern" << std::endl;
+    std::cerr << "JPEG and PPM images are read in strips; other formats (e.g. PNG, TIFF) are decoded whole into memory" << std::endl;
+    std::cerr << "an image pyramid path ending with .pyrc gives a single-file container" << std::endl;
+    std::cerr << "options:" << std::endl;
+    std::cerr << " -c                   convert an image pyramid directory to a container, or back" << std::endl;
+    std::cerr << " -q <quality>         set JPEG quality (default 75)" << std::endl;
+    std::cerr << " -t <threads>         set number of threads (default number of cores)" << std::endl;
+
+    exit(1);
+}
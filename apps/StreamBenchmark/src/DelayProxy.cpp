@@ -0,0 +1,124 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DelayProxy.h"
+
+DelayProxyConnection::DelayProxyConnection(int socketDescriptor, std::string hostname, int port, int delay, int stallTime)
+{
+    delay_ = delay;
+    stallTime_ = stallTime;
+
+    time_.start();
+
+    connect(&clientSocket_, SIGNAL(readyRead()), this, SLOT(readClient()));
+    connect(&serverSocket_, SIGNAL(readyRead()), this, SLOT(readServer()));
+    connect(&clientSocket_, SIGNAL(disconnected()), this, SLOT(close()));
+    connect(&serverSocket_, SIGNAL(disconnected()), this, SLOT(close()));
+
+    clientSocket_.setSocketDescriptor(socketDescriptor);
+    serverSocket_.connectToHost(hostname.c_str(), port);
+
+    // forward due data about every ms
+    connect(&forwardTimer_, SIGNAL(timeout()), this, SLOT(forward()));
+    forwardTimer_.start(1);
+}
+
+DelayProxyConnection::~DelayProxyConnection()
+{
+    forwardTimer_.stop();
+}
+
+void DelayProxyConnection::readClient()
+{
+    toServer_.push_back(DelayedData(time_.elapsed() + delay_, clientSocket_.readAll()));
+}
+
+void DelayProxyConnection::readServer()
+{
+    QByteArray data = serverSocket_.readAll();
+
+    if(stallTime_ >= 0 && time_.elapsed() >= stallTime_)
+    {
+        return;
+    }
+
+    toClient_.push_back(DelayedData(time_.elapsed() + delay_, data));
+}
+
+void DelayProxyConnection::forward()
+{
+    int time = time_.elapsed();
+
+    // nothing can be written to the server until the connection is made
+    while(toServer_.size() > 0 && toServer_.front().first <= time && serverSocket_.state() == QAbstractSocket::ConnectedState)
+    {
+        serverSocket_.write(toServer_.front().second);
+        toServer_.pop_front();
+    }
+
+    while(toClient_.size() > 0 && toClient_.front().first <= time)
+    {
+        clientSocket_.write(toClient_.front().second);
+        toClient_.pop_front();
+    }
+}
+
+void DelayProxyConnection::close()
+{
+    // aborting one socket disconnects it too; only close once
+    clientSocket_.disconnect(this);
+    serverSocket_.disconnect(this);
+
+    clientSocket_.abort();
+    serverSocket_.abort();
+
+    deleteLater();
+}
+
+DelayProxy::DelayProxy(std::string hostname, int port, int delay, int stallTime)
+{
+    hostname_ = hostname;
+    port_ = port;
+    delay_ = delay;
+    stallTime_ = stallTime;
+}
+
+void DelayProxy::incomingConnection(int socketDescriptor)
+{
+    new DelayProxyConnection(socketDescriptor, hostname_, port_, delay_, stallTime_);
+}
@@ -0,0 +1,106 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DELAY_PROXY_H
+#define DELAY_PROXY_H
+
+#include <QtCore>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <deque>
+#include <string>
+
+// data received from one side of a proxied connection, forwarded once its time (ms) is reached
+typedef std::pair<int, QByteArray> DelayedData;
+
+// a connection through the DelayProxy: forwards data in both directions, each after the proxy's delay
+class DelayProxyConnection : public QObject {
+    Q_OBJECT
+
+    public:
+
+        // stallTime is the time (ms) after which data from the server is no longer forwarded, or -1 to always forward
+        DelayProxyConnection(int socketDescriptor, std::string hostname, int port, int delay, int stallTime);
+        ~DelayProxyConnection();
+
+    private slots:
+
+        void readClient();
+        void readServer();
+        void forward();
+        void close();
+
+    private:
+
+        QTcpSocket clientSocket_;
+        QTcpSocket serverSocket_;
+
+        int delay_;
+        int stallTime_;
+
+        // time since the connection was made
+        QTime time_;
+
+        std::deque<DelayedData> toServer_;
+        std::deque<DelayedData> toClient_;
+
+        QTimer forwardTimer_;
+};
+
+// listens on a local port and forwards each connection to hostname:port, adding a delay in each direction
+// this emulates the latency of a wide-area link over loopback; optionally, the server's replies (acknowledgments)
+// stop being forwarded after a while, to emulate a receiver that stopped responding
+class DelayProxy : public QTcpServer {
+
+    public:
+
+        DelayProxy(std::string hostname, int port, int delay, int stallTime);
+
+    protected:
+
+        void incomingConnection(int socketDescriptor);
+
+    private:
+
+        std::string hostname_;
+        int port_;
+        int delay_;
+        int stallTime_;
+};
+
+#endif
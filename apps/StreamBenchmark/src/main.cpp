@@ -0,0 +1,331 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DelayProxy.h"
+#include "dcStream.h"
+#include <QtCore>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+// segments/sec and frame latency of parallel pixel streaming to a DisplayCluster instance with concurrent streams,
+// optionally through a local proxy adding latency; the proxy can also stop forwarding acknowledgments, so the
+// clients' flow control windows stay full
+
+#define STREAM_BENCHMARK_WIDTH 1920
+#define STREAM_BENCHMARK_HEIGHT 1080
+
+void syntax(char * app);
+
+std::string g_hostname;
+int g_numFrames = 100;
+int g_segmentSize = 512;
+std::vector<int> g_numStreams;
+
+// the image all streams send
+std::vector<unsigned char> g_image;
+
+// streams frames on its own connection
+class StreamBenchmarkThread : public QThread {
+
+    public:
+
+        StreamBenchmarkThread(int index);
+
+        int getFramesSent();
+
+        // time (ms) each sent frame took, from the call to dcStreamSend() until it returned
+        std::vector<int> getFrameTimes();
+
+    protected:
+
+        void run();
+
+    private:
+
+        int index_;
+        int framesSent_;
+        std::vector<int> frameTimes_;
+};
+
+// runs the benchmark for each number of streams, so the proxy can run in the main thread's event loop
+class StreamBenchmarkRunner : public QThread {
+
+    protected:
+
+        void run();
+};
+
+// percentile of a set of values (nearest rank)
+int getPercentile(std::vector<int> values, float percentile)
+{
+    if(values.size() == 0)
+    {
+        return 0;
+    }
+
+    unsigned int index = (unsigned int)(percentile / 100. * (float)(values.size() - 1) + 0.5);
+
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+
+    return values[index];
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    int delay = -1;
+    int stallTime = -1;
+    int proxyPort = 1702;
+
+    // read command-line arguments
+    for(int i=1; i<argc; i++)
+    {
+        if(argv[i][0] == '-' && i+1 < argc)
+        {
+            switch(argv[i][1])
+            {
+                case 'f':
+                    g_numFrames = atoi(argv[i+1]);
+                    break;
+                case 's':
+                    g_segmentSize = atoi(argv[i+1]);
+                    break;
+                case 'n':
+                    {
+                        // comma-separated list
+                        std::istringstream iss(argv[i+1]);
+                        std::string value;
+
+                        while(std::getline(iss, value, ','))
+                        {
+                            g_numStreams.push_back(atoi(value.c_str()));
+                        }
+                    }
+                    break;
+                case 'd':
+                    delay = atoi(argv[i+1]);
+                    break;
+                case 'x':
+                    stallTime = atoi(argv[i+1]) * 1000;
+                    break;
+                case 'p':
+                    proxyPort = atoi(argv[i+1]);
+                    break;
+                default:
+                    syntax(argv[0]);
+            }
+
+            i++;
+        }
+        else if(i == argc-1 && argv[i][0] != '-')
+        {
+            g_hostname = argv[i];
+        }
+        else
+        {
+            syntax(argv[0]);
+        }
+    }
+
+    if(g_numStreams.size() == 0)
+    {
+        g_numStreams.push_back(1);
+    }
+
+    if(g_hostname.empty() == true || g_numFrames <= 0 || g_segmentSize <= 0 || *std::min_element(g_numStreams.begin(), g_numStreams.end()) <= 0)
+    {
+        syntax(argv[0]);
+    }
+
+    // stream through the proxy if it is used
+    DelayProxy * proxy = NULL;
+
+    if(delay >= 0 || stallTime >= 0)
+    {
+        proxy = new DelayProxy(g_hostname, 1701, std::max(delay, 0), stallTime);
+
+        if(proxy->listen(QHostAddress::LocalHost, proxyPort) != true)
+        {
+            std::cerr << "could not listen on port " << proxyPort << std::endl;
+            return 1;
+        }
+
+        g_hostname = "localhost:" + QString::number(proxyPort).toStdString();
+    }
+
+    StreamBenchmarkRunner runner;
+    runner.start();
+
+    app.exec();
+
+    runner.wait();
+
+    delete proxy;
+
+    return 0;
+}
+
+StreamBenchmarkThread::StreamBenchmarkThread(int index)
+{
+    index_ = index;
+    framesSent_ = 0;
+}
+
+int StreamBenchmarkThread::getFramesSent()
+{
+    return framesSent_;
+}
+
+std::vector<int> StreamBenchmarkThread::getFrameTimes()
+{
+    return frameTimes_;
+}
+
+void StreamBenchmarkThread::run()
+{
+    DcSocket * socket = dcStreamConnect(g_hostname.c_str());
+
+    if(socket == NULL)
+    {
+        std::cerr << "stream " << index_ << ": could not connect to " << g_hostname << std::endl;
+        return;
+    }
+
+    // every frame sends all segments
+    DcStreamEncoderOptions encoderOptions = dcStreamGetDefaultEncoderOptions();
+    encoderOptions.skipUnchangedSegments = false;
+    dcStreamSetEncoderOptions(socket, encoderOptions);
+
+    // each stream is a separate window; the frame index is left undefined, since streams aren't synchronized
+    std::string name = "StreamBenchmark" + QString::number(index_).toStdString();
+
+    std::vector<DcStreamParameters> parameters = dcStreamGenerateParameters(name, 0, g_segmentSize, g_segmentSize, 0, 0, STREAM_BENCHMARK_WIDTH, STREAM_BENCHMARK_HEIGHT, STREAM_BENCHMARK_WIDTH, STREAM_BENCHMARK_HEIGHT);
+
+    QTime time;
+    time.start();
+
+    for(framesSent_=0; framesSent_<g_numFrames; framesSent_++)
+    {
+        int frameStart = time.elapsed();
+
+        // with a full window, a send fails once the acknowledgments time out
+        if(dcStreamSend(socket, &g_image[0], 0, 0, STREAM_BENCHMARK_WIDTH, 0, STREAM_BENCHMARK_HEIGHT, RGBA, parameters) != true)
+        {
+            std::cout << "stream " << index_ << ": frame " << framesSent_ << " failed after " << time.elapsed() << " ms; the connection was closed" << std::endl;
+            break;
+        }
+
+        frameTimes_.push_back(time.elapsed() - frameStart);
+    }
+
+    dcStreamDisconnect(socket);
+}
+
+void StreamBenchmarkRunner::run()
+{
+    g_image.resize(STREAM_BENCHMARK_WIDTH * STREAM_BENCHMARK_HEIGHT * 4);
+
+    for(unsigned int i=0; i<g_image.size(); i++)
+    {
+        g_image[i] = (unsigned char)(i % 251);
+    }
+
+    int numSegments = (int)dcStreamGenerateParameters("", 0, g_segmentSize, g_segmentSize, 0, 0, STREAM_BENCHMARK_WIDTH, STREAM_BENCHMARK_HEIGHT, STREAM_BENCHMARK_WIDTH, STREAM_BENCHMARK_HEIGHT).size();
+
+    for(unsigned int i=0; i<g_numStreams.size(); i++)
+    {
+        std::vector<StreamBenchmarkThread *> threads;
+
+        for(int j=0; j<g_numStreams[i]; j++)
+        {
+            threads.push_back(new StreamBenchmarkThread(j));
+        }
+
+        QTime time;
+        time.start();
+
+        for(unsigned int j=0; j<threads.size(); j++)
+        {
+            threads[j]->start();
+        }
+
+        int frames = 0;
+        std::vector<int> frameTimes;
+
+        for(unsigned int j=0; j<threads.size(); j++)
+        {
+            threads[j]->wait();
+
+            frames += threads[j]->getFramesSent();
+
+            std::vector<int> threadFrameTimes = threads[j]->getFrameTimes();
+            frameTimes.insert(frameTimes.end(), threadFrameTimes.begin(), threadFrameTimes.end());
+
+            delete threads[j];
+        }
+
+        int elapsed = std::max(time.elapsed(), 1);
+
+        std::cout << g_numStreams[i] << " streams, " << frames << " frames of " << numSegments << " segments in " << elapsed << " ms: ";
+        std::cout << (double)frames * (double)numSegments / ((double)elapsed / 1000.) << " segments/second, ";
+        std::cout << "frame time p50 / p95 / p99 " << getPercentile(frameTimes, 50.) << " / " << getPercentile(frameTimes, 95.) << " / " << getPercentile(frameTimes, 99.) << " ms" << std::endl;
+    }
+
+    QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+}
+
+void syntax(char * app)
+{
+    std::cerr << "syntax: " << app << " [options] <hostname>" << std::endl;
+    std::cerr << "streams " << STREAM_BENCHMARK_WIDTH << "x" << STREAM_BENCHMARK_HEIGHT << " frames to DisplayCluster and reports segments/second and frame times" << std::endl;
+    std::cerr << "options:" << std::endl;
+    std::cerr << " -f <frames>          set number of frames per stream (default 100)" << std::endl;
+    std::cerr << " -s <segment size>    set segment size (default 512)" << std::endl;
+    std::cerr << " -n <streams,...>     set numbers of concurrent streams to run in turn, e.g. 1,16,64,256 (default 1)" << std::endl;
+    std::cerr << " -d <delay>           stream through a local proxy adding delay (ms) in each direction" << std::endl;
+    std::cerr << " -x <seconds>         stream through a local proxy that stops forwarding acknowledgments after this time" << std::endl;
+    std::cerr << " -p <port>            set local proxy port (default 1702)" << std::endl;
+
+    exit(1);
+}
@@ -92,7 +92,75 @@ Configuration::Configuration(const char * filename)
         fullscreen_ = 0;
     }
 
+    // maximum rate at which display group updates are sent to the render processes (optional)
+    query_.setQuery("string(/configuration/synchronization/@displayGroupMaxUpdateRate)");
+
+    if(query_.evaluateTo(&qstring) == true && qstring.isEmpty() == false)
+    {
+        displayGroupMaxUpdateRate_ = qstring.toDouble();
+    }
+    else
+    {
+        displayGroupMaxUpdateRate_ = DEFAULT_DISPLAY_GROUP_MAX_UPDATE_RATE;
+    }
+
+    // GPU memory budget (MB) for DynamicTexture tiles in each process, shared by all of its windows (optional)
+    query_.setQuery("string(/configuration/textures/@residencyBudget)");
+
+    if(query_.evaluateTo(&qstring) == true && qstring.isEmpty() == false)
+    {
+        textureResidencyBudget_ = qstring.toInt();
+    }
+    else
+    {
+        textureResidencyBudget_ = DEFAULT_TEXTURE_RESIDENCY_BUDGET;
+    }
+
+    // host memory (MB) for decoded image pyramid tiles in each process (optional)
+    query_.setQuery("string(/configuration/textures/@tileCacheSize)");
+
+    if(query_.evaluateTo(&qstring) == true && qstring.isEmpty() == false)
+    {
+        decodedTileCacheSize_ = qstring.toInt();
+    }
+    else
+    {
+        decodedTileCacheSize_ = DEFAULT_DECODED_TILE_CACHE_SIZE;
+    }
+
     put_flog(LOG_INFO, "dimensions: numTilesWidth = %i, numTilesHeight = %i, screenWidth = %i, screenHeight = %i, mullionWidth = %i, mullionHeight = %i. fullscreen = %i", numTilesWidth_, numTilesHeight_, screenWidth_, screenHeight_, mullionWidth_, mullionHeight_, fullscreen_);
+    put_flog(LOG_INFO, "synchronization: displayGroupMaxUpdateRate = %f", displayGroupMaxUpdateRate_);
+    put_flog(LOG_INFO, "textures: residencyBudget = %i MB, tileCacheSize = %i MB", textureResidencyBudget_, decodedTileCacheSize_);
+
+    // get tile indices for all processes, so rank 0 can determine which processes a screen rectangle is visible on
+    // process i corresponds to rank i; rank 0 has no tiles
+    query_.setQuery("string(count(//process))");
+    query_.evaluateTo(&qstring);
+    int numProcesses = qstring.toInt();
+
+    processTileI_.resize(numProcesses + 1);
+    processTileJ_.resize(numProcesses + 1);
+
+    for(int processIndex=1; processIndex<=numProcesses; processIndex++)
+    {
+        sprintf(string, "string(count(//process[%i]/screen))", processIndex);
+        query_.setQuery(string);
+        query_.evaluateTo(&qstring);
+        int numTiles = qstring.toInt();
+
+        for(int i=1; i<=numTiles; i++)
+        {
+            sprintf(string, "string(//process[%i]/screen[%i]/@i)", processIndex, i);
+            query_.setQuery(string);
+            query_.evaluateTo(&qstring);
+            processTileI_[processIndex].push_back(qstring.toInt());
+
+            sprintf(string, "string(//process[%i]/screen[%i]/@j)", processIndex, i);
+            query_.setQuery(string);
+            query_.evaluateTo(&qstring);
+            processTileJ_[processIndex].push_back(qstring.toInt());
+        }
+    }
 
     // get tile parameters (if we're not rank 0)
     if(g_mpiRank > 0)
@@ -204,6 +272,21 @@ bool Configuration::getFullscreen()
     return (fullscreen_ != 0);
 }
 
+double Configuration::getDisplayGroupMaxUpdateRate()
+{
+    return displayGroupMaxUpdateRate_;
+}
+
+int Configuration::getTextureResidencyBudget()
+{
+    return textureResidencyBudget_;
+}
+
+int Configuration::getDecodedTileCacheSize()
+{
+    return decodedTileCacheSize_;
+}
+
 int Configuration::getTotalWidth()
 {
     return numTilesWidth_ * screenWidth_ + (numTilesWidth_ - 1) * getMullionWidth();
@@ -248,3 +331,35 @@ int Configuration::getTileJ(int i)
 {
     return tileJ_[i];
 }
+
+QRectF Configuration::getNormalizedTileRect(int tileI, int tileJ)
+{
+    // works in "screen space" where the rectangle for the entire tiled display is (0,0,1,1)
+    double left = (double)tileI * (double)(screenWidth_ + getMullionWidth());
+    double bottom = (double)tileJ * (double)(screenHeight_ + getMullionHeight());
+
+    double totalWidth = (double)getTotalWidth();
+    double totalHeight = (double)getTotalHeight();
+
+    return QRectF(left / totalWidth, bottom / totalHeight, (double)screenWidth_ / totalWidth, (double)screenHeight_ / totalHeight);
+}
+
+bool Configuration::isScreenRectangleVisible(int rank, double x, double y, double w, double h)
+{
+    if(rank < 0 || rank >= (int)processTileI_.size())
+    {
+        return false;
+    }
+
+    QRectF rect(x, y, w, h);
+
+    for(unsigned int i=0; i<processTileI_[rank].size(); i++)
+    {
+        if(getNormalizedTileRect(processTileI_[rank][i], processTileJ_[rank][i]).intersects(rect) == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -39,6 +39,15 @@
 #ifndef CONFIGURATION_H
 #define CONFIGURATION_H
 
+// display group updates per second; 0 means once per event loop iteration
+#define DEFAULT_DISPLAY_GROUP_MAX_UPDATE_RATE 60.
+
+// GPU memory budget (MB) for DynamicTexture tiles in each process, shared by all of its windows
+#define DEFAULT_TEXTURE_RESIDENCY_BUDGET 512
+
+// host memory (MB) for decoded image pyramid tiles in each process
+#define DEFAULT_DECODED_TILE_CACHE_SIZE 1024
+
 #include <QtGui>
 #include <QtXmlPatterns>
 
@@ -55,6 +64,9 @@ class Configuration {
         int getMullionWidth();
         int getMullionHeight();
         bool getFullscreen();
+        double getDisplayGroupMaxUpdateRate();
+        int getTextureResidencyBudget();
+        int getDecodedTileCacheSize();
         int getTotalWidth();
         int getTotalHeight();
 
@@ -67,6 +79,12 @@ class Configuration {
         int getTileI(int i);
         int getTileJ(int i);
 
+        // normalized screen-space rectangle of the tile with the given tile indices
+        QRectF getNormalizedTileRect(int tileI, int tileJ);
+
+        // whether the screen-space rectangle is visible on any of the tiles of the given rank
+        bool isScreenRectangleVisible(int rank, double x, double y, double w, double h);
+
     private:
 
         QXmlQuery query_;
@@ -78,6 +96,9 @@ class Configuration {
         int mullionWidth_;
         int mullionHeight_;
         int fullscreen_;
+        double displayGroupMaxUpdateRate_;
+        int textureResidencyBudget_;
+        int decodedTileCacheSize_;
 
         std::string host_;
         std::string display_;
@@ -87,6 +108,10 @@ class Configuration {
         std::vector<int> tileY_;
         std::vector<int> tileI_;
         std::vector<int> tileJ_;
+
+        // tile indices for all processes, indexed by rank
+        std::vector<std::vector<int> > processTileI_;
+        std::vector<std::vector<int> > processTileJ_;
 };
 
 #endif
@@ -225,7 +225,7 @@ boost::shared_ptr<Content> Content::getContent(std::string uri)
         return c;
     }
     // see if this is an image pyramid
-    else if(fileTypeString.endsWith(".pyr"))
+    else if(fileTypeString.endsWith(".pyr") || fileTypeString.endsWith(".pyrc"))
     {
         boost::shared_ptr<Content> c(new DynamicTextureContent(uri));
 
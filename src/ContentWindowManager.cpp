@@ -130,6 +130,40 @@ void ContentWindowManager::close(ContentWindowInterface * source)
     }
 }
 
+ContentWindowState ContentWindowManager::getState()
+{
+    ContentWindowState state;
+
+    state.contentWidth = contentWidth_;
+    state.contentHeight = contentHeight_;
+    state.x = x_;
+    state.y = y_;
+    state.w = w_;
+    state.h = h_;
+    state.centerX = centerX_;
+    state.centerY = centerY_;
+    state.zoom = zoom_;
+    state.selected = selected_;
+    state.highlightedTimestamp = highlightedTimestamp_;
+
+    return state;
+}
+
+void ContentWindowManager::setState(ContentWindowState state)
+{
+    contentWidth_ = state.contentWidth;
+    contentHeight_ = state.contentHeight;
+    x_ = state.x;
+    y_ = state.y;
+    w_ = state.w;
+    h_ = state.h;
+    centerX_ = state.centerX;
+    centerY_ = state.centerY;
+    zoom_ = state.zoom;
+    selected_ = state.selected;
+    highlightedTimestamp_ = state.highlightedTimestamp;
+}
+
 void ContentWindowManager::render()
 {
     content_->render(shared_from_this());
@@ -41,6 +41,7 @@
 
 #include "ContentWindowInterface.h"
 #include "Content.h" // need pyContent for pyContentWindowManager
+#include "DisplayGroupDelta.h"
 #include <QtGui>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -68,6 +69,11 @@ class ContentWindowManager : public ContentWindowInterface, public boost::enable
         void moveToFront(ContentWindowInterface * source=NULL);
         void close(ContentWindowInterface * source=NULL);
 
+        // window state used for display group deltas
+        // setState() sets the state directly and does not emit any signals
+        ContentWindowState getState();
+        void setState(ContentWindowState state);
+
         // GLWindow rendering
         void render();
 
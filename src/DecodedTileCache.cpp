@@ -0,0 +1,145 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DecodedTileCache.h"
+
+DecodedTileCache::DecodedTileCache(size_t capacityBytes)
+{
+    shardCapacityBytes_ = capacityBytes / DECODED_TILE_CACHE_SHARDS;
+
+    for(int i=0; i<DECODED_TILE_CACHE_SHARDS; i++)
+    {
+        shards_[i].bytes = 0;
+        shards_[i].hits = 0;
+        shards_[i].misses = 0;
+    }
+}
+
+QImage DecodedTileCache::get(const DecodedTileKey &key)
+{
+    Shard & shard = getShard(key);
+
+    QMutexLocker locker(&shard.mutex);
+
+    std::map<DecodedTileKey, std::list<std::pair<DecodedTileKey, QImage> >::iterator>::iterator it = shard.tileEntries.find(key);
+
+    if(it == shard.tileEntries.end())
+    {
+        shard.misses++;
+        return QImage();
+    }
+
+    // move to the front of the list
+    shard.tiles.splice(shard.tiles.begin(), shard.tiles, it->second);
+    shard.hits++;
+
+    return it->second->second;
+}
+
+void DecodedTileCache::insert(const DecodedTileKey &key, const QImage &image)
+{
+    size_t bytes = image.byteCount();
+
+    // don't let a single tile flush a whole shard
+    if(image.isNull() == true || bytes > shardCapacityBytes_)
+    {
+        return;
+    }
+
+    Shard & shard = getShard(key);
+
+    QMutexLocker locker(&shard.mutex);
+
+    std::map<DecodedTileKey, std::list<std::pair<DecodedTileKey, QImage> >::iterator>::iterator it = shard.tileEntries.find(key);
+
+    if(it != shard.tileEntries.end())
+    {
+        // another thread inserted the same tile; replace it
+        shard.bytes -= it->second->second.byteCount();
+        shard.tiles.erase(it->second);
+        shard.tileEntries.erase(it);
+    }
+
+    shard.tiles.push_front(std::pair<DecodedTileKey, QImage>(key, image));
+    shard.tileEntries[key] = shard.tiles.begin();
+    shard.bytes += bytes;
+
+    // evict least recently used tiles until we're within capacity
+    while(shard.bytes > shardCapacityBytes_)
+    {
+        shard.bytes -= shard.tiles.back().second.byteCount();
+        shard.tileEntries.erase(shard.tiles.back().first);
+        shard.tiles.pop_back();
+    }
+}
+
+DecodedTileCacheStatistics DecodedTileCache::getStatistics()
+{
+    DecodedTileCacheStatistics statistics;
+
+    statistics.hits = 0;
+    statistics.misses = 0;
+    statistics.tiles = 0;
+    statistics.bytes = 0;
+    statistics.capacityBytes = shardCapacityBytes_ * DECODED_TILE_CACHE_SHARDS;
+
+    for(int i=0; i<DECODED_TILE_CACHE_SHARDS; i++)
+    {
+        QMutexLocker locker(&shards_[i].mutex);
+
+        statistics.hits += shards_[i].hits;
+        statistics.misses += shards_[i].misses;
+        statistics.tiles += (int)shards_[i].tiles.size();
+        statistics.bytes += shards_[i].bytes;
+    }
+
+    return statistics;
+}
+
+DecodedTileCache::Shard & DecodedTileCache::getShard(const DecodedTileKey &key)
+{
+    // combine the hashes of the pyramid and the tree path
+    uint hash = qHash(QString::fromStdString(key.first));
+
+    for(unsigned int i=0; i<key.second.size(); i++)
+    {
+        hash = hash * 31 + (uint)key.second[i];
+    }
+
+    return shards_[hash % DECODED_TILE_CACHE_SHARDS];
+}
@@ -0,0 +1,103 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DECODED_TILE_CACHE_H
+#define DECODED_TILE_CACHE_H
+
+// number of independently locked shards; the capacity is divided evenly between them
+#define DECODED_TILE_CACHE_SHARDS 16
+
+#include <QtCore>
+#include <QImage>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// identifies a tile: the pyramid it belongs to and its path through the tree
+typedef std::pair<std::string, std::vector<int> > DecodedTileKey;
+
+struct DecodedTileCacheStatistics {
+
+    long hits;
+    long misses;
+
+    int tiles;
+    size_t bytes;
+    size_t capacityBytes;
+};
+
+// process-wide cache of decoded image pyramid tiles, shared by all DynamicTexture trees and windows
+// tiles are kept as implicitly shared QImages, so a hit doesn't copy pixels
+// the cache is split into shards with their own locks and least recently used eviction to limit contention between loader threads
+class DecodedTileCache {
+
+    public:
+
+        DecodedTileCache(size_t capacityBytes);
+
+        // returns a null image if the tile isn't cached
+        QImage get(const DecodedTileKey &key);
+
+        void insert(const DecodedTileKey &key, const QImage &image);
+
+        DecodedTileCacheStatistics getStatistics();
+
+    private:
+
+        struct Shard {
+
+            QMutex mutex;
+
+            // cached tiles, most recently used first
+            std::list<std::pair<DecodedTileKey, QImage> > tiles;
+            std::map<DecodedTileKey, std::list<std::pair<DecodedTileKey, QImage> >::iterator> tileEntries;
+
+            size_t bytes;
+            long hits;
+            long misses;
+        };
+
+        Shard shards_[DECODED_TILE_CACHE_SHARDS];
+
+        size_t shardCapacityBytes_;
+
+        Shard & getShard(const DecodedTileKey &key);
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DISPLAY_GROUP_DELTA_H
+#define DISPLAY_GROUP_DELTA_H
+
+// a full display group (keyframe) is sent after this many consecutive deltas
+#define DISPLAY_GROUP_KEYFRAME_INTERVAL 100
+
+#include "Marker.h"
+#include "config.h"
+#include <vector>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/posix_time/time_serialize.hpp>
+
+#if ENABLE_SKELETON_SUPPORT
+    #include "SkeletonState.h"
+#endif
+
+// the per-window state which changes when windows are moved, resized, zoomed, etc.
+// the Content object of a window never changes, so it is only sent with a full display group
+struct ContentWindowState {
+
+    int contentWidth;
+    int contentHeight;
+
+    double x;
+    double y;
+    double w;
+    double h;
+
+    double centerX;
+    double centerY;
+
+    double zoom;
+
+    bool selected;
+
+    boost::posix_time::ptime highlightedTimestamp;
+
+    bool operator==(const ContentWindowState &other) const
+    {
+        return contentWidth == other.contentWidth && contentHeight == other.contentHeight &&
+            x == other.x && y == other.y && w == other.w && h == other.h &&
+            centerX == other.centerX && centerY == other.centerY && zoom == other.zoom &&
+            selected == other.selected && highlightedTimestamp == other.highlightedTimestamp;
+    }
+
+    bool operator!=(const ContentWindowState &other) const
+    {
+        return !(*this == other);
+    }
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int)
+    {
+        ar & contentWidth;
+        ar & contentHeight;
+        ar & x;
+        ar & y;
+        ar & w;
+        ar & h;
+        ar & centerX;
+        ar & centerY;
+        ar & zoom;
+        ar & selected;
+        ar & highlightedTimestamp;
+    }
+};
+
+// the changes to a display group since the display group with sequence number baseSequenceNumber
+// a delta can only be applied to a display group with that exact sequence number; otherwise the
+// render processes wait for the next full display group
+struct DisplayGroupDelta {
+
+    unsigned int baseSequenceNumber;
+    unsigned int sequenceNumber;
+
+    // for each content window, its index in the base display group (the windows may have been reordered)
+    std::vector<int> order;
+
+    // (index, state) pairs for the content windows which have changed, indexed by the new order
+    std::vector<std::pair<int, ContentWindowState> > states;
+
+    // markers are small and change frequently, so they're always sent
+    std::vector<boost::shared_ptr<Marker> > markers;
+
+#if ENABLE_SKELETON_SUPPORT
+    std::vector<boost::shared_ptr<SkeletonState> > skeletons;
+#endif
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int)
+    {
+        ar & baseSequenceNumber;
+        ar & sequenceNumber;
+        ar & order;
+        ar & states;
+        ar & markers;
+
+#if ENABLE_SKELETON_SUPPORT
+        ar & skeletons;
+#endif
+    }
+};
+
+#endif
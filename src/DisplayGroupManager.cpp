@@ -47,6 +47,8 @@
 #include "ParallelPixelStreamContent.h"
 #include "SVGStreamSource.h"
 #include "SVGContent.h"
+#include "MessageBufferPool.h"
+#include "MessageReceiverThread.h"
 #include <sstream>
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -58,26 +60,42 @@
 #include <mpi.h>
 #include <QDomDocument>
 #include <fstream>
-
-#include <pthread.h>
-pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
-
-int 
-ptid()
-{
-	return (((long long)pthread_self()) & 0xfffffff);
-}
+#include <algorithm>
 
 DisplayGroupManager::DisplayGroupManager()
 {
 		synchronization_suspended = false;
 
+    // the first display group sent is always a full display group
+    sequenceNumber_ = 0;
+    deltasSinceFullDisplayGroup_ = 0;
+    fullDisplayGroupRequired_ = true;
+
+    // display group updates are coalesced and sent by flushDisplayGroup()
+    displayGroupDirty_ = 0;
+    displayGroupUpdatesRequested_ = 0;
+    displayGroupUpdatesSent_ = 0;
+
+    sendPixelStreamsPending_ = 0;
+    sendSVGStreamsPending_ = 0;
+
+    displayGroupFlushTimer_.setSingleShot(true);
+    connect(&displayGroupFlushTimer_, SIGNAL(timeout()), this, SLOT(flushDisplayGroup()));
+
+    // messages are batched and sent once per event loop iteration
+    messageBatchTimer_.setSingleShot(true);
+    connect(&messageBatchTimer_, SIGNAL(timeout()), this, SLOT(sendMessageBatch()));
+
+    // sends are non-blocking; this timer completes them
+    connect(&sendRequestsTimer_, SIGNAL(timeout()), this, SLOT(testSendRequests()));
+
     // create new Options object
     boost::shared_ptr<Options> options(new Options());
     options_ = options;
 
-    // make Options trigger sendDisplayGroup() when it is updated
-    connect(options_.get(), SIGNAL(updated()), this, SLOT(sendDisplayGroup()), Qt::QueuedConnection);
+    // make Options trigger sendFullDisplayGroup() when it is updated
+    // options aren't part of display group deltas
+    connect(options_.get(), SIGNAL(updated()), this, SLOT(sendFullDisplayGroup()), Qt::QueuedConnection);
 
     // register types for use in signals/slots
     qRegisterMetaType<boost::shared_ptr<ContentWindowManager> >("boost::shared_ptr<ContentWindowManager>");
@@ -175,6 +193,16 @@ void DisplayGroupManager::moveContentWindowManagerToFront(boost::shared_ptr<Cont
     }
 }
 
+int DisplayGroupManager::getDisplayGroupUpdatesRequested()
+{
+    return (int)displayGroupUpdatesRequested_;
+}
+
+int DisplayGroupManager::getDisplayGroupUpdatesSent()
+{
+    return displayGroupUpdatesSent_;
+}
+
 void DisplayGroupManager::calibrateTimestampOffset()
 {
     // can't calibrate timestamps unless we have at least 2 processes
@@ -542,77 +570,255 @@ void DisplayGroupManager::receiveMessages()
         exit(-1);
     }
 
-    // check to see if we have a message (non-blocking)
-    int flag;
-    MPI_Status status;
-    MPI_Iprobe(0, 0, MPI_COMM_WORLD, &flag, &status);
+    // this display group may be replaced by g_displayGroupManager while we're receiving; keep it around until we're done
+    boost::shared_ptr<DisplayGroupManager> displayGroupManager = shared_from_this();
 
-    // check to see if all render processes have a message
-    int allFlag;
-    MPI_Allreduce(&flag, &allFlag, 1, MPI_INT, MPI_LAND, g_mpiRenderComm);
+    // message batches to apply in this frame
+    std::vector<boost::shared_ptr<MessageBatch> > batches;
 
-    // message header
-    MessageHeader mh;
+    if(g_messageReceiverThread != NULL)
+    {
+        // the batches were already received and preprocessed while the previous frame was rendered
+        // all render processes apply the same batches in the same frame: the number of batches ready on every process
+        int numBatches = g_messageReceiverThread->getNumReadyBatches();
+        MPI_Allreduce(MPI_IN_PLACE, (void *)&numBatches, 1, MPI_INT, MPI_MIN, g_mpiRenderComm);
 
-    // if all render processes have a message...
-    if(allFlag != 0)
+        batches = g_messageReceiverThread->takeReadyBatches(numBatches);
+    }
+    else
     {
-        // continue receiving messages until we get to the last one which all render processes have
-        // this will "drop frames" and keep all processes synchronized
-        while(allFlag)
+        boost::shared_ptr<MessageBatch> batch = receiveMessageBatch(g_mpiRenderComm, false);
+
+        if(batch != NULL)
         {
-            // first, get message header
-            MPI_Recv((void *)&mh, sizeof(MessageHeader), MPI_BYTE, 0, 0, MPI_COMM_WORLD, &status);
+            batches.push_back(batch);
+        }
+    }
 
-            if(mh.type == MESSAGE_TYPE_CONTENTS)
-            {
-                receiveDisplayGroup(mh);
-            }
-            else if(mh.type == MESSAGE_TYPE_CONTENTS_DIMENSIONS)
-            {
-                receiveContentsDimensionsRequest(mh);
-            }
-            else if(mh.type == MESSAGE_TYPE_PIXELSTREAM)
-            {
-                receivePixelStreams(mh);
-            }
-            else if(mh.type == MESSAGE_TYPE_PARALLEL_PIXELSTREAM)
+    // display group updates are applied together: only the newest full display group and the deltas following it
+    std::vector<std::pair<MessageHeader, const char *> > displayGroupUpdates;
+
+    for(unsigned int i=0; i<batches.size(); i++)
+    {
+        boost::shared_ptr<MessageBatch> batch = batches[i];
+
+        // index of the next parallel pixel stream message, for the segments received by the message receiver thread
+        unsigned int parallelPixelStreamIndex = 0;
+
+        int offset = 0;
+
+        while(offset < batch->size)
+        {
+            // message header and payload
+            MessageHeader mh;
+            memcpy((void *)&mh, (void *)(batch->messages.get() + offset), sizeof(MessageHeader));
+
+            const char * buf = batch->messages.get() + offset + sizeof(MessageHeader);
+
+            offset += sizeof(MessageHeader) + mh.size;
+
+            if(mh.type == MESSAGE_TYPE_CONTENTS || mh.type == MESSAGE_TYPE_CONTENTS_DELTA)
             {
-                receiveParallelPixelStreams(mh);
+                if(mh.type == MESSAGE_TYPE_CONTENTS)
+                {
+                    displayGroupUpdates.clear();
+                }
+
+                displayGroupUpdates.push_back(std::pair<MessageHeader, const char *>(mh, buf));
             }
-            else if(mh.type == MESSAGE_TYPE_SVG_STREAM)
+            else
             {
-                receiveSVGStreams(mh);
+                // the other messages depend on the current display group
+                receiveDisplayGroupUpdates(displayGroupUpdates);
+
+                if(mh.type == MESSAGE_TYPE_CONTENTS_DIMENSIONS)
+                {
+                    receiveContentsDimensionsRequest(mh);
+                }
+                else if(mh.type == MESSAGE_TYPE_FRAME_TIMINGS)
+                {
+                    receiveFrameTimingsRequest(mh);
+                }
+                else if(mh.type == MESSAGE_TYPE_PIXELSTREAM)
+                {
+                    // decoding was already started if the batch was preprocessed
+                    if(batch->preprocessed != true)
+                    {
+                        receivePixelStreams(mh, buf, batch->messages);
+                    }
+                }
+                else if(mh.type == MESSAGE_TYPE_PARALLEL_PIXELSTREAM)
+                {
+                    boost::shared_ptr<char> segmentsBuffer;
+
+                    if(batch->preprocessed == true)
+                    {
+                        segmentsBuffer = batch->parallelPixelStreamSegments[parallelPixelStreamIndex++];
+                    }
+                    else
+                    {
+                        segmentsBuffer = receiveParallelPixelStreamSegments(mh, buf);
+                    }
+
+                    receiveParallelPixelStreams(mh, buf, segmentsBuffer);
+                }
+                else if(mh.type == MESSAGE_TYPE_SVG_STREAM)
+                {
+                    receiveSVGStreams(mh, buf);
+                }
+                else if(mh.type == MESSAGE_TYPE_QUIT)
+                {
+                    g_app->quit();
+                    return;
+                }
             }
-            else if(mh.type == MESSAGE_TYPE_QUIT)
+        }
+    }
+
+    // at this point, we've received all messages available for this frame
+    receiveDisplayGroupUpdates(displayGroupUpdates);
+}
+
+boost::shared_ptr<MessageBatch> DisplayGroupManager::receiveMessageBatch(MPI_Comm comm, bool wait)
+{
+    // rank 0 sends batches of messages (each a header followed by its payload) to rank 1 only
+    // rank 1 receives all available batches and broadcasts them to all render processes as one buffer
+    // the buffer comes from the message buffer pool; payloads are used in place and keep a reference to it as long as they need
+    boost::shared_ptr<MessageBatch> batch(new MessageBatch());
+
+    if(g_mpiRank == 1)
+    {
+        int flag;
+        MPI_Status status;
+
+        if(wait == true)
+        {
+            MPI_Probe(0, 0, MPI_COMM_WORLD, &status);
+            flag = 1;
+        }
+        else
+        {
+            // check to see if we have a message batch (non-blocking)
+            MPI_Iprobe(0, 0, MPI_COMM_WORLD, &flag, &status);
+        }
+
+        while(flag != 0)
+        {
+            int count;
+            MPI_Get_count(&status, MPI_BYTE, &count);
+
+            boost::shared_ptr<char> buffer = g_messageBufferPool.getBuffer(batch->size + count);
+
+            // only needed if more than one batch is waiting
+            if(batch->size > 0)
             {
-                g_app->quit();
-                return;
+                memcpy((void *)buffer.get(), (void *)batch->messages.get(), batch->size);
             }
 
-            // check to see if we have another message waiting, for this process and for all render processes
+            batch->messages = buffer;
+
+            MPI_Recv((void *)(batch->messages.get() + batch->size), count, MPI_BYTE, 0, 0, MPI_COMM_WORLD, &status);
+            batch->size += count;
+
             MPI_Iprobe(0, 0, MPI_COMM_WORLD, &flag, &status);
-            MPI_Allreduce(&flag, &allFlag, 1, MPI_INT, MPI_LAND, g_mpiRenderComm);
         }
+    }
 
-        // at this point, we've received the last message available for all render processes
+    // all render processes get the same messages
+    MPI_Bcast((void *)&batch->size, 1, MPI_INT, 0, comm);
+
+    if(batch->size == 0)
+    {
+        return boost::shared_ptr<MessageBatch>();
     }
+
+    if(g_mpiRank != 1)
+    {
+        batch->messages = g_messageBufferPool.getBuffer(batch->size);
+    }
+
+    MPI_Bcast((void *)batch->messages.get(), batch->size, MPI_BYTE, 0, comm);
+
+    return batch;
 }
 
 void DisplayGroupManager::sendDisplayGroup()
 {
+    // mark the display group dirty; a single update will be sent for all changes made before the next flush
+    displayGroupUpdatesRequested_.ref();
+    displayGroupDirty_.fetchAndStoreOrdered(1);
+
+    // the flush timer belongs to the main thread
+    if(QThread::currentThread() != thread())
+    {
+        QMetaObject::invokeMethod(this, "scheduleDisplayGroupFlush", Qt::QueuedConnection);
+    }
+    else
+    {
+        scheduleDisplayGroupFlush();
+    }
+}
+
+void DisplayGroupManager::scheduleDisplayGroupFlush()
+{
+    if(displayGroupFlushTimer_.isActive() == true)
+    {
+        return;
+    }
+
+    // limit the flush rate; with no limit we still flush at most once per event loop iteration
+    int delay = 0;
+
+    double maxUpdateRate = g_configuration->getDisplayGroupMaxUpdateRate();
+
+    if(maxUpdateRate > 0. && displayGroupFlushTime_.isNull() == false)
+    {
+        delay = (int)(1000. / maxUpdateRate) - displayGroupFlushTime_.elapsed();
+
+        if(delay < 0)
+        {
+            delay = 0;
+        }
+    }
+
+    displayGroupFlushTimer_.start(delay);
+}
+
+void DisplayGroupManager::flushDisplayGroup()
+{
+    if(displayGroupDirty_ == 0)
+    {
+        return;
+    }
+
 		if (synchronization_suspended)
 			return;
 
-// std::cerr << "SDG going for lock " << ptid() << "\n";
-		pthread_mutex_lock(&lock);
-// std::cerr << "SDG got lock " << ptid() << "\n";
+    // cleared before serializing, so changes made from here on are sent by the next flush
+    displayGroupDirty_.fetchAndStoreOrdered(0);
+    displayGroupFlushTimer_.stop();
+    displayGroupFlushTime_.start();
+
+    displayGroupUpdatesSent_++;
+
+    if(displayGroupUpdatesSent_ % 1000 == 0)
+    {
+        put_flog(LOG_DEBUG, "display group updates requested = %i, sent = %i", (int)displayGroupUpdatesRequested_, displayGroupUpdatesSent_);
+    }
+
+    // send a delta against the last display group sent if possible, otherwise send the full display group
+    DisplayGroupDelta delta;
+
+    bool full = fullDisplayGroupRequired_ == true || deltasSinceFullDisplayGroup_ >= DISPLAY_GROUP_KEYFRAME_INTERVAL || getDisplayGroupDelta(delta) == false;
 
     // serialize state
     std::ostringstream oss(std::ostringstream::binary);
 
     // brace this so destructor is called on archive before we use the stream
+    if(full == true)
     {
+        sequenceNumber_++;
+
         QMutexLocker locker(&markersMutex_);
 
         boost::shared_ptr<DisplayGroupManager> dgm = shared_from_this();
@@ -620,28 +826,140 @@ void DisplayGroupManager::sendDisplayGroup()
         boost::archive::binary_oarchive oa(oss);
         oa << dgm;
     }
+    else
+    {
+        sequenceNumber_ = delta.sequenceNumber;
+
+        boost::archive::binary_oarchive oa(oss);
+        oa << delta;
+    }
+
+    // remember what the render processes now have
+    sentContentWindowManagers_ = contentWindowManagers_;
+    sentContentWindowStates_.clear();
+
+    for(unsigned int i=0; i<contentWindowManagers_.size(); i++)
+    {
+        sentContentWindowStates_.push_back(contentWindowManagers_[i]->getState());
+    }
+
+    if(full == true)
+    {
+        fullDisplayGroupRequired_ = false;
+        deltasSinceFullDisplayGroup_ = 0;
+    }
+    else
+    {
+        deltasSinceFullDisplayGroup_++;
+    }
 
     // serialized data to string
     std::string serializedString = oss.str();
-    int size = serializedString.size();
 
     // send the header and the message
     MessageHeader mh;
-    mh.size = size;
-    mh.type = MESSAGE_TYPE_CONTENTS;
+    mh.size = serializedString.size();
+    mh.type = (full == true) ? MESSAGE_TYPE_CONTENTS : MESSAGE_TYPE_CONTENTS_DELTA;
+
+    sendMessage(mh, serializedString.data());
+}
 
-    // the header is sent via a send, so that we can probe it on the render processes
-    for(int i=1; i<g_mpiSize; i++)
+void DisplayGroupManager::sendMessage(MessageHeader messageHeader, const char * data)
+{
+    if(g_mpiSize < 2)
     {
-        MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
+        return;
     }
 
-    // broadcast the message
-    MPI_Bcast((void *)serializedString.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
-		MPI_Barrier(MPI_COMM_WORLD);
+    // add the header and payload to the current batch; all messages queued during this event loop iteration are sent together
+    messageBatch_.append((const char *)&messageHeader, sizeof(MessageHeader));
 
-		pthread_mutex_unlock(&lock);
-// std::cerr << "SDG released lock " << ptid() << "\n";
+    if(messageHeader.size > 0)
+    {
+        messageBatch_.append(data, messageHeader.size);
+    }
+
+    if(messageBatchTimer_.isActive() == false)
+    {
+        messageBatchTimer_.start(0);
+    }
+}
+
+void DisplayGroupManager::sendMessageBatch()
+{
+    messageBatchTimer_.stop();
+
+    if(messageBatch_.empty() == true)
+    {
+        return;
+    }
+
+    // the batch is an immutable buffer which is released once its send completes
+    boost::shared_ptr<std::string> batch(new std::string());
+    batch->swap(messageBatch_);
+
+    // the batch is only sent to rank 1, which broadcasts it to the other render processes
+    // this is a non-blocking send; the render processes will receive it at the start of their next frame
+    MPI_Request request;
+    MPI_Isend((void *)batch->data(), batch->size(), MPI_BYTE, 1, 0, MPI_COMM_WORLD, &request);
+
+    sendRequests_.push_back(request);
+    sendRequestBuffers_.push_back(batch);
+
+    testSendRequests();
+}
+
+void DisplayGroupManager::testSendRequests()
+{
+    // release the buffers of completed sends
+    for(unsigned int i=0; i<sendRequests_.size(); )
+    {
+        int flag;
+        MPI_Status status;
+        MPI_Test(&sendRequests_[i], &flag, &status);
+
+        if(flag != 0)
+        {
+            sendRequests_.erase(sendRequests_.begin() + i);
+            sendRequestBuffers_.erase(sendRequestBuffers_.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    // keep calling into MPI until all sends are complete so they make progress
+    // sends are mostly tested when the next batch is sent; the timer only covers idle periods
+    if(sendRequests_.size() > 0 && sendRequestsTimer_.isActive() == false)
+    {
+        sendRequestsTimer_.start(SEND_REQUESTS_TEST_INTERVAL);
+    }
+    else if(sendRequests_.size() == 0)
+    {
+        sendRequestsTimer_.stop();
+    }
+}
+
+void DisplayGroupManager::waitForSendRequests()
+{
+    if(sendRequests_.size() > 0)
+    {
+        std::vector<MPI_Status> statuses(sendRequests_.size());
+        MPI_Waitall(sendRequests_.size(), &sendRequests_[0], &statuses[0]);
+    }
+
+    sendRequests_.clear();
+    sendRequestBuffers_.clear();
+
+    sendRequestsTimer_.stop();
+}
+
+void DisplayGroupManager::sendFullDisplayGroup()
+{
+    fullDisplayGroupRequired_ = true;
+
+    sendDisplayGroup();
 }
 
 void DisplayGroupManager::sendContentsDimensionsRequest()
@@ -652,15 +970,16 @@ void DisplayGroupManager::sendContentsDimensionsRequest()
         return;
     }
 
-    // send the header and the message
+    // rank 1 must have the current content windows before it can respond
+    flushDisplayGroup();
+
+    // send the header
     MessageHeader mh;
+    mh.size = 0;
     mh.type = MESSAGE_TYPE_CONTENTS_DIMENSIONS;
 
-    // the header is sent via a send, so that we can probe it on the render processes
-    for(int i=1; i<g_mpiSize; i++)
-    {
-        MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-    }
+    sendMessage(mh, NULL);
+    sendMessageBatch();
 
     // now, receive response from rank 1
     MPI_Status status;
@@ -693,8 +1012,48 @@ void DisplayGroupManager::sendContentsDimensionsRequest()
     delete [] buf;
 }
 
+std::map<int, std::vector<FrameTiming> > DisplayGroupManager::getFrameTimings()
+{
+    std::map<int, std::vector<FrameTiming> > timings;
+
+    if(g_mpiSize < 2)
+    {
+        put_flog(LOG_WARN, "cannot get frame timings for g_mpiSize == %i", g_mpiSize);
+        return timings;
+    }
+
+    // send the request
+    MessageHeader mh;
+    mh.size = 0;
+    mh.type = MESSAGE_TYPE_FRAME_TIMINGS;
+
+    sendMessage(mh, NULL);
+    sendMessageBatch();
+
+    // now, receive the frame timings from each render process
+    for(int rank=1; rank<g_mpiSize; rank++)
+    {
+        MPI_Status status;
+        MPI_Probe(rank, 0, MPI_COMM_WORLD, &status);
+
+        int count;
+        MPI_Get_count(&status, MPI_BYTE, &count);
+
+        std::vector<FrameTiming> frames(count / sizeof(FrameTiming));
+
+        MPI_Recv((void *)(frames.size() > 0 ? &frames[0] : NULL), count, MPI_BYTE, rank, 0, MPI_COMM_WORLD, &status);
+
+        timings[rank] = frames;
+    }
+
+    return timings;
+}
+
 void DisplayGroupManager::sendPixelStreams()
 {
+    // updates arriving from now on need another send
+    sendPixelStreamsPending_ = 0;
+
     // iterate through all pixel streams and send updates if needed
     std::map<std::string, boost::shared_ptr<PixelStreamSource> > map = g_pixelStreamSourceFactory.getMap();
 
@@ -734,14 +1093,7 @@ void DisplayGroupManager::sendPixelStreams()
             size_t len = uri.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
             mh.uri[len] = '\0';
 
-            // the header is sent via a send, so that we can probe it on the render processes
-            for(int i=1; i<g_mpiSize; i++)
-            {
-                MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-            }
-
-            // broadcast the message
-            MPI_Bcast((void *)imageData.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
+            sendMessage(mh, imageData.constData());
         }
 
         // check for updated dimensions
@@ -768,11 +1120,28 @@ void DisplayGroupManager::sendParallelPixelStreams()
     // iterate through all parallel pixel streams and send updates if needed
     std::map<std::string, boost::shared_ptr<ParallelPixelStream> > map = g_parallelPixelStreamSourceFactory.getMap();
 
+    // forget the image data of streams that no longer exist
+    std::map<std::string, std::map<int, ParallelPixelStreamSentSegment> >::iterator sentIt = sentParallelPixelStreamSegments_.begin();
+
+    while(sentIt != sentParallelPixelStreamSegments_.end())
+    {
+        if(map.count(sentIt->first) == 0)
+        {
+            sentParallelPixelStreamSegments_.erase(sentIt++);
+        }
+        else
+        {
+            sentIt++;
+        }
+    }
+
     for(std::map<std::string, boost::shared_ptr<ParallelPixelStream> >::iterator it = map.begin(); it != map.end(); it++)
     {
         std::string uri = (*it).first;
         boost::shared_ptr<ParallelPixelStream> parallelPixelStreamSource = (*it).second;
 
+        std::map<int, ParallelPixelStreamSentSegment> & sentSegments = sentParallelPixelStreamSegments_[uri];
+
         // get updated segments
         // if streaming synchronization is enabled, we need to send all segments; otherwise just the latest segments
         std::vector<ParallelPixelStreamSegment> segments;
@@ -802,43 +1171,126 @@ void DisplayGroupManager::sendParallelPixelStreams()
                 addContentWindowManager(cwm);
             }
 
-            // serialize the vector
-            std::ostringstream oss(std::ostringstream::binary);
+            boost::shared_ptr<ContentWindowManager> cwm = getContentWindowManager(uri, CONTENT_TYPE_PARALLEL_PIXEL_STREAM);
+
+            double x, y, w, h;
+            cwm->getCoordinates(x, y, w, h);
 
-            // brace this so destructor is called on archive before we use the stream
+            // serialize the segments for each render process: for each segment, its parameters, image data size and image data
+            // a segment is only sent to the processes with a tile it's visible on; blank segments are sent to all processes
+            // this lets the render processes use the image data in place
+            // a process that doesn't have the image data of an unchanged segment, e.g. because the window moved onto its tiles,
+            // gets the image data last sent for the segment instead
+            std::vector<std::string> serializedStrings(g_mpiSize);
+
+            for(unsigned int i=0; i<segments.size(); i++)
             {
-                boost::archive::binary_oarchive oa(oss);
-                oa << segments;
+                ParallelPixelStreamSegmentParameters & p = segments[i].parameters;
+
+                bool blank = (p.totalWidth == 0 && p.totalHeight == 0);
+                bool unchanged = (blank == false && segments[i].imageData.size() == 0);
+
+                if(blank == true)
+                {
+                    sentSegments.erase(p.sourceIndex);
+                }
+                else if(unchanged == false)
+                {
+                    ParallelPixelStreamSentSegment & sentSegment = sentSegments[p.sourceIndex];
+
+                    sentSegment.imageData = segments[i].imageData;
+                    sentSegment.imageDataBuffer = segments[i].imageDataBuffer;
+                    sentSegment.codec = p.codec;
+                    sentSegment.ranksWithImageData.assign(g_mpiSize, false);
+                }
+
+                // coordinates of segment in tiled display space
+                double segmentX = 0., segmentY = 0., segmentW = 0., segmentH = 0.;
+
+                if(blank == false)
+                {
+                    segmentX = x + (double)p.x / (double)p.totalWidth * w;
+                    segmentY = y + (double)p.y / (double)p.totalHeight * h;
+                    segmentW = (double)p.width / (double)p.totalWidth * w;
+                    segmentH = (double)p.height / (double)p.totalHeight * h;
+                }
+
+                for(int rank=1; rank<g_mpiSize; rank++)
+                {
+                    if(blank == true || g_configuration->isScreenRectangleVisible(rank, segmentX, segmentY, segmentW, segmentH) == true)
+                    {
+                        ParallelPixelStreamSegmentParameters rankParameters = p;
+                        const QByteArray * imageData = &segments[i].imageData;
+
+                        if(blank == false && sentSegments.count(p.sourceIndex) > 0)
+                        {
+                            ParallelPixelStreamSentSegment & sentSegment = sentSegments[p.sourceIndex];
+
+                            if(unchanged == true && sentSegment.ranksWithImageData[rank] == false)
+                            {
+                                rankParameters.codec = sentSegment.codec;
+                                imageData = &sentSegment.imageData;
+                            }
+
+                            sentSegment.ranksWithImageData[rank] = true;
+                        }
+
+                        int32_t imageDataSize = imageData->size();
+
+                        serializedStrings[rank].append((const char *)&rankParameters, sizeof(ParallelPixelStreamSegmentParameters));
+                        serializedStrings[rank].append((const char *)&imageDataSize, sizeof(int32_t));
+                        serializedStrings[rank].append(imageData->constData(), imageDataSize);
+                    }
+                    else if(blank == false && sentSegments.count(p.sourceIndex) > 0)
+                    {
+                        // the process may discard image data it no longer displays
+                        sentSegments[p.sourceIndex].ranksWithImageData[rank] = false;
+                    }
+                }
             }
 
-            // serialized data to string
-            std::string serializedString = oss.str();
-            int size = serializedString.size();
+            // the broadcast message only contains the total dimensions and the size of the segments for each process
+            // format: total width, total height, segments size for each rank
+            std::vector<int32_t> header(2 + g_mpiSize, 0);
+            header[0] = segments[0].parameters.totalWidth;
+            header[1] = segments[0].parameters.totalHeight;
+
+            // send the segments directly to each process (non-blocking)
+            // these are posted before the broadcast message is queued, so each process receives them in the same order as the broadcast messages
+            for(int rank=1; rank<g_mpiSize; rank++)
+            {
+                if(serializedStrings[rank].size() > 0)
+                {
+                    header[2 + rank] = serializedStrings[rank].size();
+
+                    boost::shared_ptr<std::string> buffer(new std::string());
+                    buffer->swap(serializedStrings[rank]);
+
+                    MPI_Request request;
+                    MPI_Isend((void *)buffer->data(), buffer->size(), MPI_BYTE, rank, PARALLEL_PIXEL_STREAM_SEGMENTS_TAG, MPI_COMM_WORLD, &request);
+
+                    sendRequests_.push_back(request);
+                    sendRequestBuffers_.push_back(buffer);
+                }
+            }
+
+            testSendRequests();
 
             // send the header and the message
             MessageHeader mh;
-            mh.size = size;
+            mh.size = header.size() * sizeof(int32_t);
             mh.type = MESSAGE_TYPE_PARALLEL_PIXELSTREAM;
 
             // add the truncated URI to the header
             size_t len = uri.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
             mh.uri[len] = '\0';
 
-            // the header is sent via a send, so that we can probe it on the render processes
-            for(int i=1; i<g_mpiSize; i++)
-            {
-                MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-            }
-
-            // broadcast the message
-            MPI_Bcast((void *)serializedString.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
+            sendMessage(mh, (const char *)&header[0]);
 
             // check for updated dimensions
             int newWidth = segments[0].parameters.totalWidth;
             int newHeight = segments[0].parameters.totalHeight;
 
-            boost::shared_ptr<ContentWindowManager> cwm = getContentWindowManager(uri, CONTENT_TYPE_PARALLEL_PIXEL_STREAM);
-
             if(cwm != NULL)
             {
                 boost::shared_ptr<Content> c = cwm->getContent();
@@ -855,8 +1307,27 @@ void DisplayGroupManager::sendParallelPixelStreams()
     }
 }
 
+void DisplayGroupManager::requestSendPixelStreams()
+{
+    if(sendPixelStreamsPending_.testAndSetOrdered(0, 1) == true)
+    {
+        QMetaObject::invokeMethod(this, "sendPixelStreams", Qt::QueuedConnection);
+    }
+}
+
+void DisplayGroupManager::requestSendSVGStreams()
+{
+    if(sendSVGStreamsPending_.testAndSetOrdered(0, 1) == true)
+    {
+        QMetaObject::invokeMethod(this, "sendSVGStreams", Qt::QueuedConnection);
+    }
+}
+
 void DisplayGroupManager::sendSVGStreams()
 {
+    // updates arriving from now on need another send
+    sendSVGStreamsPending_ = 0;
+
     // iterate through all SVG streams and send updates if needed
     std::map<std::string, boost::shared_ptr<SVGStreamSource> > map = g_SVGStreamSourceFactory.getMap();
 
@@ -923,14 +1394,7 @@ void DisplayGroupManager::sendSVGStreams()
             size_t len = uri.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
             mh.uri[len] = '\0';
 
-            // the header is sent via a send, so that we can probe it on the render processes
-            for(int i=1; i<g_mpiSize; i++)
-            {
-                MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-            }
-
-            // broadcast the message
-            MPI_Bcast((void *)imageData.data(), size, MPI_BYTE, 0, MPI_COMM_WORLD);
+            sendMessage(mh, imageData.constData());
         }
     }
 }
@@ -964,13 +1428,8 @@ void DisplayGroupManager::sendFrameClockUpdate()
     mh.size = size;
     mh.type = MESSAGE_TYPE_FRAME_CLOCK;
 
-    // the header is sent via a send, so that we can probe it on the render processes
-    for(int i=2; i<g_mpiSize; i++)
-    {
-        MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-    }
-
-    // broadcast it
+    // broadcast the header and the message to the other render processes
+    MPI_Bcast((void *)&mh, sizeof(MessageHeader), MPI_BYTE, 0, g_mpiRenderComm);
     MPI_Bcast((void *)serializedString.data(), size, MPI_BYTE, 0, g_mpiRenderComm);
 
     // update timestamp
@@ -987,8 +1446,7 @@ void DisplayGroupManager::receiveFrameClockUpdate()
 
     // receive the message header
     MessageHeader messageHeader;
-    MPI_Status status;
-    MPI_Recv((void *)&messageHeader, sizeof(MessageHeader), MPI_BYTE, 1, 0, MPI_COMM_WORLD, &status);
+    MPI_Bcast((void *)&messageHeader, sizeof(MessageHeader), MPI_BYTE, 0, g_mpiRenderComm);
 
     if(messageHeader.type != MESSAGE_TYPE_FRAME_CLOCK)
     {
@@ -1022,15 +1480,16 @@ void DisplayGroupManager::receiveFrameClockUpdate()
 
 void DisplayGroupManager::sendQuit()
 {
-    // send the header and the message
+    // send the header
     MessageHeader mh;
+    mh.size = 0;
     mh.type = MESSAGE_TYPE_QUIT;
 
-    // the header is sent via a send, so that we can probe it on the render processes
-    for(int i=1; i<g_mpiSize; i++)
-    {
-        MPI_Send((void *)&mh, sizeof(MessageHeader), MPI_BYTE, i, 0, MPI_COMM_WORLD);
-    }
+    sendMessage(mh, NULL);
+    sendMessageBatch();
+
+    // all sends must be complete before we finalize MPI
+    waitForSendRequests();
 }
 
 void DisplayGroupManager::advanceContents()
@@ -1052,18 +1511,25 @@ void DisplayGroupManager::setSkeletons(std::vector< boost::shared_ptr<SkeletonSt
 }
 #endif
 
-void DisplayGroupManager::receiveDisplayGroup(MessageHeader messageHeader)
+void DisplayGroupManager::receiveDisplayGroupUpdates(std::vector<std::pair<MessageHeader, const char *> > &displayGroupUpdates)
 {
-// std::cerr << "RDG going for lock\n";
-		pthread_mutex_lock(&lock);
-// std::cerr << "RDG got lock\n";
-
-    // receive serialized data
-    char * buf = new char[messageHeader.size];
+    for(unsigned int i=0; i<displayGroupUpdates.size(); i++)
+    {
+        if(displayGroupUpdates[i].first.type == MESSAGE_TYPE_CONTENTS)
+        {
+            receiveDisplayGroup(displayGroupUpdates[i].first, displayGroupUpdates[i].second);
+        }
+        else
+        {
+            receiveDisplayGroupDelta(displayGroupUpdates[i].first, displayGroupUpdates[i].second);
+        }
+    }
 
-    // read message into the buffer
-    MPI_Bcast((void *)buf, messageHeader.size, MPI_BYTE, 0, MPI_COMM_WORLD);
+    displayGroupUpdates.clear();
+}
 
+void DisplayGroupManager::receiveDisplayGroup(MessageHeader messageHeader, const char * buf)
+{
     // de-serialize...
 
 		boost::iostreams::basic_array_source<char> device(buf, messageHeader.size);
@@ -1077,14 +1543,56 @@ void DisplayGroupManager::receiveDisplayGroup(MessageHeader messageHeader)
 
     // overwrite old display group
     g_displayGroupManager = displayGroupManager;
+}
+
+void DisplayGroupManager::receiveDisplayGroupDelta(MessageHeader messageHeader, const char * buf)
+{
+    // de-serialize...
 
-		MPI_Barrier(MPI_COMM_WORLD);
+		boost::iostreams::basic_array_source<char> device(buf, messageHeader.size);
+		boost::iostreams::stream<boost::iostreams::basic_array_source<char> > iss(device);
 
-    // free mpi buffer
-    delete [] buf;
+    DisplayGroupDelta delta;
 
-		pthread_mutex_unlock(&lock);
-// std::cerr << "RDG released lock\n";
+    boost::archive::binary_iarchive ia(iss);
+    ia >> delta;
+
+    // apply the delta to the current display group
+    // note that we must use g_displayGroupManager since it may have been replaced earlier in this frame
+    boost::shared_ptr<DisplayGroupManager> dgm = g_displayGroupManager;
+
+    if(delta.baseSequenceNumber != dgm->sequenceNumber_ || delta.order.size() != dgm->contentWindowManagers_.size())
+    {
+        // we missed an update; ignore deltas until the next full display group
+        put_flog(LOG_DEBUG, "ignoring display group delta %u, have display group %u", delta.sequenceNumber, dgm->sequenceNumber_);
+    }
+    else
+    {
+        std::vector<boost::shared_ptr<ContentWindowManager> > contentWindowManagers;
+
+        for(unsigned int i=0; i<delta.order.size(); i++)
+        {
+            contentWindowManagers.push_back(dgm->contentWindowManagers_[delta.order[i]]);
+        }
+
+        for(unsigned int i=0; i<delta.states.size(); i++)
+        {
+            contentWindowManagers[delta.states[i].first]->setState(delta.states[i].second);
+        }
+
+        dgm->contentWindowManagers_ = contentWindowManagers;
+
+        {
+            QMutexLocker locker(&dgm->markersMutex_);
+            dgm->markers_ = delta.markers;
+        }
+
+#if ENABLE_SKELETON_SUPPORT
+        dgm->skeletons_ = delta.skeletons;
+#endif
+
+        dgm->sequenceNumber_ = delta.sequenceNumber;
+    }
 }
 
 void DisplayGroupManager::receiveContentsDimensionsRequest(MessageHeader messageHeader)
@@ -1127,77 +1635,156 @@ void DisplayGroupManager::receiveContentsDimensionsRequest(MessageHeader message
     }
 }
 
-void DisplayGroupManager::receivePixelStreams(MessageHeader messageHeader)
+void DisplayGroupManager::receiveFrameTimingsRequest(MessageHeader messageHeader)
 {
-    // receive serialized data
-    char * buf = new char[messageHeader.size];
+    // all render processes send the frames in their ring buffer directly to rank 0
+    std::vector<FrameTiming> frames = g_frameTimings.getSnapshot();
 
-    // read message into the buffer
-    MPI_Bcast((void *)buf, messageHeader.size, MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Send((void *)(frames.size() > 0 ? &frames[0] : NULL), frames.size() * sizeof(FrameTiming), MPI_BYTE, 0, 0, MPI_COMM_WORLD);
+}
 
+void DisplayGroupManager::receivePixelStreams(MessageHeader messageHeader, const char * buf, boost::shared_ptr<char> buffer)
+{
     // URI
     std::string uri = std::string(messageHeader.uri);
 
-    // de-serialize...
-    g_mainWindow->getGLWindow()->getPixelStreamFactory().getObject(uri)->setImageData(QByteArray(buf, messageHeader.size));
-
-    // free mpi buffer
-    delete [] buf;
+    // the image data is used in place; the pixel stream keeps a reference to the buffer until it's decoded
+    g_mainWindow->getGLWindow()->getPixelStreamFactory().getObject(uri)->setImageData(QByteArray::fromRawData(buf, messageHeader.size), buffer);
 }
 
-void DisplayGroupManager::receiveParallelPixelStreams(MessageHeader messageHeader)
+boost::shared_ptr<char> DisplayGroupManager::receiveParallelPixelStreamSegments(MessageHeader messageHeader, const char * buf)
 {
-    // receive serialized data
-    char * buf = new char[messageHeader.size];
+    // read the size of the segments sent directly to us (see sendParallelPixelStreams() for the format)
+    int32_t segmentsSize;
+    memcpy((void *)&segmentsSize, (void *)(buf + (2 + g_mpiRank) * sizeof(int32_t)), sizeof(int32_t));
 
-    // read message into the buffer
-    MPI_Bcast((void *)buf, messageHeader.size, MPI_BYTE, 0, MPI_COMM_WORLD);
+    if(segmentsSize <= 0)
+    {
+        return boost::shared_ptr<char>();
+    }
+
+    // the segments were sent before the broadcast message, so this doesn't wait long
+    boost::shared_ptr<char> segmentsBuffer = g_messageBufferPool.getBuffer(segmentsSize);
 
+    MPI_Status status;
+    MPI_Recv((void *)segmentsBuffer.get(), segmentsSize, MPI_BYTE, 0, PARALLEL_PIXEL_STREAM_SEGMENTS_TAG, MPI_COMM_WORLD, &status);
+
+    return segmentsBuffer;
+}
+
+void DisplayGroupManager::receiveParallelPixelStreams(MessageHeader messageHeader, const char * buf, boost::shared_ptr<char> segmentsBuffer)
+{
     // URI
     std::string uri = std::string(messageHeader.uri);
 
-    // de-serialize...
-
-		boost::iostreams::basic_array_source<char> device(buf, messageHeader.size);
-		boost::iostreams::stream<boost::iostreams::basic_array_source<char> > iss(device);
+    boost::shared_ptr<ParallelPixelStream> parallelPixelStream = g_mainWindow->getGLWindow()->getParallelPixelStreamFactory().getObject(uri);
 
-    // read to a new segments vector
-    std::vector<ParallelPixelStreamSegment> segments;
+    // read the total dimensions and the size of the segments sent directly to us (see sendParallelPixelStreams() for the format)
+    int32_t totalWidth, totalHeight, segmentsSize;
+    memcpy((void *)&totalWidth, (void *)buf, sizeof(int32_t));
+    memcpy((void *)&totalHeight, (void *)(buf + sizeof(int32_t)), sizeof(int32_t));
+    memcpy((void *)&segmentsSize, (void *)(buf + (2 + g_mpiRank) * sizeof(int32_t)), sizeof(int32_t));
 
-    boost::archive::binary_iarchive ia(iss);
-    ia >> segments;
+    // the dimensions are needed even if none of the segments are visible here, e.g. for contents dimensions requests
+    if(totalWidth != 0 && totalHeight != 0)
+    {
+        parallelPixelStream->setDimensions(totalWidth, totalHeight);
+    }
 
-    // now, insert all segments
-    for(unsigned int i=0; i<segments.size(); i++)
+    if(segmentsSize > 0 && segmentsBuffer != NULL)
     {
-        g_mainWindow->getGLWindow()->getParallelPixelStreamFactory().getObject(uri)->insertSegment(segments[i]);
+        // read the segments
+        // the image data of each segment is used in place and keeps a reference to the buffer
+        const char * segmentsBuf = segmentsBuffer.get();
+
+        int offset = 0;
+
+        while(offset < segmentsSize)
+        {
+            ParallelPixelStreamSegment segment;
+
+            memcpy((void *)&segment.parameters, (void *)(segmentsBuf + offset), sizeof(ParallelPixelStreamSegmentParameters));
+            offset += sizeof(ParallelPixelStreamSegmentParameters);
+
+            int32_t imageDataSize;
+            memcpy((void *)&imageDataSize, (void *)(segmentsBuf + offset), sizeof(int32_t));
+            offset += sizeof(int32_t);
+
+            segment.imageData = QByteArray::fromRawData(segmentsBuf + offset, imageDataSize);
+            segment.imageDataBuffer = segmentsBuffer;
+            offset += imageDataSize;
+
+            parallelPixelStream->insertSegment(segment);
+        }
     }
 
     // update pixel streams corresponding to new segments
-    g_mainWindow->getGLWindow()->getParallelPixelStreamFactory().getObject(uri)->updatePixelStreams();
+    // this is done on all render processes, even those that didn't receive any segments, since it may synchronize them
+    parallelPixelStream->updatePixelStreams();
+}
 
-    // free mpi buffer
-    delete [] buf;
+void DisplayGroupManager::receiveSVGStreams(MessageHeader messageHeader, const char * buf)
+{
+    // URI
+    std::string uri = std::string(messageHeader.uri);
+
+    // the SVG is parsed immediately, so the data can be used in place
+    g_mainWindow->getGLWindow()->getSVGFactory().getObject(uri)->setImageData(QByteArray::fromRawData(buf, messageHeader.size));
 }
 
-void DisplayGroupManager::receiveSVGStreams(MessageHeader messageHeader)
+
+bool DisplayGroupManager::getDisplayGroupDelta(DisplayGroupDelta &delta)
 {
-    // receive serialized data
-    char * buf = new char[messageHeader.size];
+    // a delta can only describe a reordering of the same set of content windows
+    if(contentWindowManagers_.size() != sentContentWindowManagers_.size())
+    {
+        return false;
+    }
 
-    // read message into the buffer
-    MPI_Bcast((void *)buf, messageHeader.size, MPI_BYTE, 0, MPI_COMM_WORLD);
+    delta.baseSequenceNumber = sequenceNumber_;
+    delta.sequenceNumber = sequenceNumber_ + 1;
 
-    // URI
-    std::string uri = std::string(messageHeader.uri);
+    delta.order.clear();
+    delta.states.clear();
 
-    // de-serialize...
-    g_mainWindow->getGLWindow()->getSVGFactory().getObject(uri)->setImageData(QByteArray(buf, messageHeader.size));
+    for(unsigned int i=0; i<contentWindowManagers_.size(); i++)
+    {
+        std::vector<boost::shared_ptr<ContentWindowManager> >::iterator it = std::find(sentContentWindowManagers_.begin(), sentContentWindowManagers_.end(), contentWindowManagers_[i]);
 
-    // free mpi buffer
-    delete [] buf;
-}
+        if(it == sentContentWindowManagers_.end())
+        {
+            return false;
+        }
+
+        int index = it - sentContentWindowManagers_.begin();
 
+        // the same window can't appear twice
+        if(std::find(delta.order.begin(), delta.order.end(), index) != delta.order.end())
+        {
+            return false;
+        }
+
+        delta.order.push_back(index);
+
+        ContentWindowState state = contentWindowManagers_[i]->getState();
+
+        if(state != sentContentWindowStates_[index])
+        {
+            delta.states.push_back(std::pair<int, ContentWindowState>(i, state));
+        }
+    }
+
+    {
+        QMutexLocker locker(&markersMutex_);
+        delta.markers = markers_;
+    }
+
+#if ENABLE_SKELETON_SUPPORT
+    delta.skeletons = skeletons_;
+#endif
+
+    return true;
+}
 
 void DisplayGroupManager::pushState()
 {
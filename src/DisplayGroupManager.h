@@ -39,19 +39,31 @@
 #ifndef DISPLAY_GROUP_MANAGER_H
 #define DISPLAY_GROUP_MANAGER_H
 
+// interval (milliseconds) at which outstanding non-blocking sends are tested for completion when nothing else is sent
+// they are also tested whenever a message batch or parallel pixel stream segments are sent
+#define SEND_REQUESTS_TEST_INTERVAL 10
+
+// MPI tag for parallel pixel stream segments sent directly from rank 0 to the render processes displaying them
+#define PARALLEL_PIXEL_STREAM_SEGMENTS_TAG 1
+
 #include "MessageHeader.h"
 #include "DisplayGroupInterface.h"
 #include "Options.h"
 #include "Marker.h"
+#include "DisplayGroupDelta.h"
+#include "FrameTimings.h"
+#include "MessageReceiverThread.h"
 #include "config.h"
 #include <QtGui>
 #include <vector>
+#include <map>
 #include <stack>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <mpi.h>
 
 #if ENABLE_SKELETON_SUPPORT
     #include "SkeletonState.h"
@@ -59,6 +71,18 @@
 
 class ContentWindowManager;
 
+// rank 0: the image data last sent for a parallel pixel stream segment, and the render processes that received it
+// unchanged segments refer to this image data, so processes without it get it instead of an unchanged segment
+struct ParallelPixelStreamSentSegment {
+
+    QByteArray imageData;
+    boost::shared_ptr<void> imageDataBuffer;
+    int32_t codec;
+
+    // indexed by rank
+    std::vector<bool> ranksWithImageData;
+};
+
 class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_shared_from_this<DisplayGroupManager> {
     Q_OBJECT
 
@@ -82,9 +106,25 @@ class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_s
         void removeContentWindowManager(boost::shared_ptr<ContentWindowManager> contentWindowManager, DisplayGroupInterface * source=NULL);
         void moveContentWindowManagerToFront(boost::shared_ptr<ContentWindowManager> contentWindowManager, DisplayGroupInterface * source=NULL);
 
+        // number of display group updates requested and actually sent to the render processes
+        // the difference is the number of updates saved by coalescing
+        int getDisplayGroupUpdatesRequested();
+        int getDisplayGroupUpdatesSent();
+
         // find the offset between the rank 0 clock and the rank 1 clock. recall the rank 1 clock is used across rank 1 - n.
         void calibrateTimestampOffset();
 
+        // receive the next batch of messages from rank 0 (render processes, collective over comm)
+        // if wait is true, rank 1 waits for a batch; otherwise NULL is returned if there wasn't one
+        static boost::shared_ptr<MessageBatch> receiveMessageBatch(MPI_Comm comm, bool wait);
+
+        // receive the parallel pixel stream segments sent directly to this process for a parallel pixel stream message
+        // returns NULL if there weren't any
+        static boost::shared_ptr<char> receiveParallelPixelStreamSegments(MessageHeader messageHeader, const char * buf);
+
+        // get the recorded frame timings of all render processes, indexed by rank (rank 0 only)
+        std::map<int, std::vector<FrameTiming> > getFrameTimings();
+
 				std::stack<QString> state_stack;
 
 				void pushState();
@@ -101,10 +141,17 @@ class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_s
         void receiveMessages();
 
         void sendDisplayGroup();
+        void sendFullDisplayGroup();
+        void flushDisplayGroup();
         void sendContentsDimensionsRequest();
         void sendPixelStreams();
         void sendParallelPixelStreams();
         void sendSVGStreams();
+
+        // queue a single sendPixelStreams() / sendSVGStreams() on the main thread, unless one is already queued
+        // thread needs access to these methods
+        void requestSendPixelStreams();
+        void requestSendSVGStreams();
         void sendFrameClockUpdate();
         void receiveFrameClockUpdate();
         void sendQuit();
@@ -118,6 +165,12 @@ class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_s
         void setSkeletons(std::vector<boost::shared_ptr<SkeletonState> > skeletons);
 #endif
 
+    private slots:
+
+        void scheduleDisplayGroupFlush();
+        void sendMessageBatch();
+        void testSendRequests();
+
     private:
 				bool synchronization_suspended;
 
@@ -126,6 +179,7 @@ class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_s
         template<class Archive>
         void serialize(Archive & ar, const unsigned int)
         {
+            ar & sequenceNumber_;
             ar & options_;
             ar & markers_;
             ar & contentWindowManagers_;
@@ -152,11 +206,52 @@ class DisplayGroupManager : public DisplayGroupInterface, public boost::enable_s
         // rank 1 - rank 0 timestamp offset
         boost::posix_time::time_duration timestampOffset_;
 
-        void receiveDisplayGroup(MessageHeader messageHeader);
+        // sequence number of the last display group sent / received
+        unsigned int sequenceNumber_;
+
+        // rank 0: the display group state last sent to the render processes, used to compute deltas
+        std::vector<boost::shared_ptr<ContentWindowManager> > sentContentWindowManagers_;
+        std::vector<ContentWindowState> sentContentWindowStates_;
+        int deltasSinceFullDisplayGroup_;
+        bool fullDisplayGroupRequired_;
+
+        // rank 0: display group updates are coalesced and sent at most once per flush interval
+        // the dirty flag is set from any thread and cleared by the main thread
+        QAtomicInt displayGroupDirty_;
+        QTimer displayGroupFlushTimer_;
+        QTime displayGroupFlushTime_;
+        QAtomicInt displayGroupUpdatesRequested_;
+        int displayGroupUpdatesSent_;
+
+        // rank 0: whether a sendPixelStreams() / sendSVGStreams() is queued; the send takes the latest data of all streams
+        QAtomicInt sendPixelStreamsPending_;
+        QAtomicInt sendSVGStreamsPending_;
+
+        // rank 0: messages to be sent to the render processes in the next batch
+        std::string messageBatch_;
+        QTimer messageBatchTimer_;
+
+        // rank 0: the image data last sent for each parallel pixel stream segment, by URI and source index
+        std::map<std::string, std::map<int, ParallelPixelStreamSentSegment> > sentParallelPixelStreamSegments_;
+
+        // rank 0: outstanding non-blocking sends and the buffers they reference
+        std::vector<MPI_Request> sendRequests_;
+        std::vector<boost::shared_ptr<std::string> > sendRequestBuffers_;
+        QTimer sendRequestsTimer_;
+
+        void sendMessage(MessageHeader messageHeader, const char * data);
+        void waitForSendRequests();
+
+        bool getDisplayGroupDelta(DisplayGroupDelta &delta);
+
+        void receiveDisplayGroupUpdates(std::vector<std::pair<MessageHeader, const char *> > &displayGroupUpdates);
+        void receiveDisplayGroup(MessageHeader messageHeader, const char * buf);
+        void receiveDisplayGroupDelta(MessageHeader messageHeader, const char * buf);
         void receiveContentsDimensionsRequest(MessageHeader messageHeader);
-        void receivePixelStreams(MessageHeader messageHeader);
-        void receiveParallelPixelStreams(MessageHeader messageHeader);
-        void receiveSVGStreams(MessageHeader messageHeader);
+        void receiveFrameTimingsRequest(MessageHeader messageHeader);
+        void receivePixelStreams(MessageHeader messageHeader, const char * buf, boost::shared_ptr<char> buffer);
+        void receiveParallelPixelStreams(MessageHeader messageHeader, const char * buf, boost::shared_ptr<char> segmentsBuffer);
+        void receiveSVGStreams(MessageHeader messageHeader, const char * buf);
 };
 
 #endif
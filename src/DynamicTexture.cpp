@@ -37,6 +37,8 @@
 /*********************************************************************/
 
 #include "DynamicTexture.h"
+#include "DynamicTextureScheduler.h"
+#include "ImagePyramidBuilder.h"
 #include "main.h"
 #include "vector.h"
 #include "log.h"
@@ -58,6 +60,8 @@ DynamicTexture::DynamicTexture(std::string uri, boost::shared_ptr<DynamicTexture
     useImagePyramid_ = false;
     threadCount_ = 0;
     loadImageThreadStarted_ = false;
+    loading_ = false;
+    loaded_ = false;
     imageWidth_ = 0;
     imageHeight_ = 0;
     textureBound_ = false;
@@ -86,8 +90,24 @@ DynamicTexture::DynamicTexture(std::string uri, boost::shared_ptr<DynamicTexture
         // this is the top-level object, so its path is 0
         treePath_.push_back(0);
 
+        // see if this is an image pyramid container
+        if(ImagePyramidContainer::isContainer(uri) == true)
+        {
+            boost::shared_ptr<ImagePyramidContainer> container(new ImagePyramidContainer());
+
+            if(container->open(uri) != true)
+            {
+                return;
+            }
+
+            imagePyramidContainer_ = container;
+            imageWidth_ = container->getImageWidth();
+            imageHeight_ = container->getImageHeight();
+
+            useImagePyramid_ = true;
+        }
         // see if this is an image pyramid metadata filename
-        if(uri.find(".pyr") != std::string::npos)
+        else if(uri.find(".pyr") != std::string::npos)
         {
             std::ifstream ifs(uri.c_str());
 
@@ -130,6 +150,9 @@ DynamicTexture::DynamicTexture(std::string uri, boost::shared_ptr<DynamicTexture
 
 DynamicTexture::~DynamicTexture()
 {
+    // stop tracking the texture first, so it isn't evicted during destruction
+    g_mainWindow->getTextureResidencyManager().remove(this);
+
     // delete bound texture
     if(textureBound_ == true)
     {
@@ -155,7 +178,29 @@ void DynamicTexture::loadImage(bool convertToGLFormat)
         root = getRoot().get();
     }
 
-    if(root->useImagePyramid_ == true)
+    // image pyramid tiles decoded before, by any tree or window, are reused from the cache
+    // the cached images are already in OpenGL format
+    DecodedTileKey tileKey(root->uri_, treePath_);
+    bool useTileCache = (root->useImagePyramid_ == true && convertToGLFormat == true);
+
+    if(useTileCache == true)
+    {
+        scaledImage_ = g_decodedTileCache->get(tileKey);
+
+        if(scaledImage_.isNull() != true)
+        {
+            return;
+        }
+    }
+
+    if(root->useImagePyramid_ == true && root->imagePyramidContainer_ != NULL)
+    {
+        int level, column, row;
+        ImagePyramidContainer::getTileCoordinates(treePath_, level, column, row);
+
+        scaledImage_.loadFromData(root->imagePyramidContainer_->readTile(level, column, row), "jpg");
+    }
+    else if(root->useImagePyramid_ == true)
     {
         // form filename
         std::string filename = root->imagePyramidPath_ + '/';
@@ -176,12 +221,15 @@ void DynamicTexture::loadImage(bool convertToGLFormat)
     }
     else
     {
+        // other objects' loader threads may read image_ in getImageFromParent(), so it is only assigned under loadMutex_
+        QImage image;
+
         // root node
         if(depth_ == 0)
         {
-            image_.load(uri_.c_str());
+            image.load(uri_.c_str());
 
-            if(image_.isNull() == true)
+            if(image.isNull() == true)
             {
                 put_flog(LOG_ERROR, "error loading %s", uri_.c_str());
             }
@@ -190,25 +238,26 @@ void DynamicTexture::loadImage(bool convertToGLFormat)
         {
             // get image from parent
             boost::shared_ptr<DynamicTexture> parent = parent_.lock();
-            image_ = parent->getImageFromParent(parentX_, parentY_, parentW_, parentH_, this);
+            image = parent->getImageFromParent(parentX_, parentY_, parentW_, parentH_, this);
         }
 
         // if we managed to get a valid image, go ahead and scale it
         // otherwise, we'll need to read it in differently...
-        if(image_.isNull() != true)
+        if(image.isNull() != true)
         {
             // save image dimensions for later use; recall image may be deleted
-            imageWidth_ = image_.width();
-            imageHeight_ = image_.height();
+            imageWidth_ = image.width();
+            imageHeight_ = image.height();
 
             // compute the scaled image
-            scaledImage_ = image_.scaled(TEXTURE_SIZE, TEXTURE_SIZE);
+            scaledImage_ = image.scaled(TEXTURE_SIZE, TEXTURE_SIZE);
 
             // only the root needs to keep the non-scaled image in this case
             // we only want to keep the top-most valid image_ in the tree for memory efficiency
-            if(depth_ != 0)
+            if(depth_ == 0)
             {
-                image_ = QImage();
+                QMutexLocker locker(&loadMutex_);
+                image_ = image;
             }
         }
         else
@@ -240,13 +289,18 @@ void DynamicTexture::loadImage(bool convertToGLFormat)
                 put_flog(LOG_DEBUG, "reading clipped region of image");
 
                 imageReader.setClipRect(rootRect);
-                image_ = imageReader.read();
+                image = imageReader.read();
 
-                if(image_.isNull() != true)
+                {
+                    QMutexLocker locker(&loadMutex_);
+                    image_ = image;
+                }
+
+                if(image.isNull() != true)
                 {
                     // successfully loaded clipped image
                     // compute the scaled image
-                    scaledImage_ = image_.scaled(TEXTURE_SIZE, TEXTURE_SIZE);
+                    scaledImage_ = image.scaled(TEXTURE_SIZE, TEXTURE_SIZE);
                 }
                 else
                 {
@@ -283,14 +337,19 @@ void DynamicTexture::loadImage(bool convertToGLFormat)
     {
         scaledImage_ = QGLWidget::convertToGLFormat(scaledImage_);
     }
+
+    if(useTileCache == true)
+    {
+        g_decodedTileCache->insert(tileKey, scaledImage_);
+    }
 }
 
 void DynamicTexture::getDimensions(int &width, int &height)
 {
-    // if we don't have a width and height, and the load image thread is running, wait for it to finish
-    if(imageWidth_ == 0 && imageHeight_ == 0 && loadImageThreadStarted_ == true)
+    // if we don't have a width and height, and the image is being loaded, wait for it to finish
+    if(imageWidth_ == 0 && imageHeight_ == 0)
     {
-        loadImageThread_.waitForFinished();
+        waitForImageLoaded();
     }
 
     width = imageWidth_;
@@ -315,30 +374,25 @@ void DynamicTexture::render(float tX, float tY, float tW, float tH, bool compute
     {
         // want to render this object
 
-        // see if we need to start loading the image
-        if(computeOnDemand == true && loadImageThreadStarted_ == false)
+        bool imageLoaded = getImageLoaded();
+
+        // see if we need to request loading the image
+        // the request is renewed every frame this object is visible, with its current priority; it is dropped otherwise
+        if(computeOnDemand == true && imageLoaded == false && loadImageThreadStarted_ == false && getImageLoading() == false)
         {
-            // only start the thread if this DynamicTexture tree has one available
-            // each DynamicTexture tree is limited to (maxThreads - 2) threads, where the max is determined by the global QThreadPool instance
-            // we increase responsiveness / interactivity by not queuing up image loading
-            // todo: this doesn't perform well with too many threads; restricting to 1 thread for now
-            int maxThreads = 1; // std::max(QThreadPool::globalInstance()->maxThreadCount() - 2, 1);
+            double area = getProjectedPixelArea(true);
 
-            if(getThreadCount() < maxThreads)
+            if(area > 0.)
             {
-                incrementThreadCount();
-
-                // give the thread shared_ptr's to all of this object's parents to prevent their destruction during thread execution
-                std::vector<boost::shared_ptr<DynamicTexture> > objects;
-                getObjectsAscending(objects);
-
-                loadImageThread_ = QtConcurrent::run(loadImageThread, shared_from_this(), objects);
-                loadImageThreadStarted_ = true;
+                if(g_dynamicTextureScheduler.request(shared_from_this(), depth_, getProjectedCenterDistance(), area, g_frameCount) == true)
+                {
+                    g_mainWindow->getTextureResidencyManager().recordMiss();
+                }
             }
         }
 
         // see if we need to load the texture
-        if(loadImageThreadStarted_ == true && loadImageThread_.isFinished() == true && textureBound_ == false)
+        if(imageLoaded == true && textureBound_ == false)
         {
             uploadTexture();
         }
@@ -362,6 +416,8 @@ void DynamicTexture::render(float tX, float tY, float tW, float tH, bool compute
         }
         else
         {
+            g_mainWindow->getTextureResidencyManager().touch(this);
+
 #ifdef DYNAMIC_TEXTURE_SHOW_BORDER
             // draw the border
             glPushAttrib(GL_CURRENT_BIT);
@@ -417,8 +473,15 @@ void DynamicTexture::render(float tX, float tY, float tW, float tH, bool compute
 void DynamicTexture::clearOldChildren(long minFrameCount)
 {
     // clear children if renderChildrenFrameCount_ < minFrameCount
-    if(children_.size() > 0 && renderChildrenFrameCount_ < minFrameCount && getThreadsDoneDescending() == true)
+    // children with resident textures are kept so they can be shown again without reloading; the texture residency manager evicts them as needed
+    if(children_.size() > 0 && renderChildrenFrameCount_ < minFrameCount && getThreadsDoneDescending() == true && getChildrenTextureBoundDescending() == false)
     {
+        // the scheduler holds references to queued objects, so remove their requests first
+        for(unsigned int i=0; i<children_.size(); i++)
+        {
+            children_[i]->cancelScheduledImageDescending();
+        }
+
         children_.clear();
     }
 
@@ -431,110 +494,77 @@ void DynamicTexture::clearOldChildren(long minFrameCount)
 
 void DynamicTexture::computeImagePyramid(std::string imagePyramidPath)
 {
-    if(depth_ == 0)
+    // the pyramid is built from the source file, without the loaded image or child objects
+    if(depth_ != 0)
     {
-        // make directory if necessary
-        if(QDir(imagePyramidPath.c_str()).exists() != true)
-        {
-            bool success = QDir().mkdir(imagePyramidPath.c_str());
-
-            if(success != true)
-            {
-                put_flog(LOG_ERROR, "error creating directory %s", imagePyramidPath.c_str());
-                return;
-            }
-        }
-
-        // wait for initial image load to finish thread
-        loadImageThread_.waitForFinished();
-
-        // write metadata file
-        std::string metadataFilename = imagePyramidPath + "/pyramid.pyr";
-
-        std::ofstream ofs(metadataFilename.c_str());
-        ofs << "\"" << imagePyramidPath << "\" " << imageWidth_ << " " << imageHeight_;
-
-        // write a more conveniently named metadata file in the same directory as the original image, if possible
-        // path ends with ".pyramid"; the new metadata file will end with ".pyr"
-        QString secondMetadataFilename = QString(imagePyramidPath.c_str());
-        int amidLastIndex = secondMetadataFilename.lastIndexOf("amid");
-
-        secondMetadataFilename.truncate(amidLastIndex);
+        put_flog(LOG_ERROR, "only the root object can compute an image pyramid");
+        return;
+    }
 
-        std::ofstream secondOfs(secondMetadataFilename.toStdString().c_str());
+    boost::shared_ptr<ImagePyramidSource> source = openImagePyramidSource(uri_);
 
-        if(secondOfs.good() == true)
-        {
-            secondOfs << "\"" << imagePyramidPath << "\" " << imageWidth_ << " " << imageHeight_;
-        }
-        else
-        {
-            put_flog(LOG_WARN, "could not write second metadata file %s", secondMetadataFilename.toStdString().c_str());
-        }
+    if(source == NULL)
+    {
+        return;
     }
 
-    // generate this object's image and write to disk
-
-    // this will give us scaledImage_
-    // don't convert scaledImage_ to the GL format; we need to be able to save it
-    // note that for depth_ == 0 we already have scaledImage_, but it is in the OpenGL format
-    // so, we need to load it again in the non-OpenGL format so we're able to save it
-    // todo: in the future it might be nice not to require the re-loading of the image for depth_ == 0
-    loadImage(false);
+    ImagePyramidBuilder builder(source);
+    builder.build(imagePyramidPath);
+}
 
-    // form filename
-    std::string filename = imagePyramidPath + '/';
+void DynamicTexture::decrementThreadCount()
+{
+    if(depth_ == 0)
+    {
+        QMutexLocker locker(&threadCountMutex_);
+        threadCount_ = threadCount_ - 1;
+    }
+    else
+    {
+        return getRoot()->decrementThreadCount();
+    }
+}
 
-    for(unsigned int i=0; i<treePath_.size(); i++)
+void DynamicTexture::loadScheduledImage()
+{
     {
-        filename += QString::number(treePath_[i]).toStdString();
+        QMutexLocker locker(&loadMutex_);
 
-        if(i != treePath_.size() - 1)
+        // the object may have been requested again while a load was starting
+        if(loading_ == true || loaded_ == true)
         {
-            filename += "-";
+            return;
         }
+
+        loading_ = true;
     }
 
-    filename += ".jpg";
+    incrementThreadCount();
 
-    put_flog(LOG_DEBUG, "saving %s", filename.c_str());
+    loadImage();
 
-    scaledImage_.save(QString(filename.c_str()), "jpg");
+    decrementThreadCount();
 
-    // no longer need scaled image
-    scaledImage_ = QImage();
+    QMutexLocker locker(&loadMutex_);
 
-    // if we need to descend further...
-    if(getRoot()->imageWidth_ / pow(2,depth_) > TEXTURE_SIZE || getRoot()->imageHeight_ / pow(2,depth_) > TEXTURE_SIZE)
-    {
-        // image rectangle a child quadrant contains
-        QRectF imageBounds[4];
-        imageBounds[0] = QRectF(0.,0.,0.5,0.5);
-        imageBounds[1] = QRectF(0.5,0.,0.5,0.5);
-        imageBounds[2] = QRectF(0.5,0.5,0.5,0.5);
-        imageBounds[3] = QRectF(0.,0.5,0.5,0.5);
-
-        // generate and compute children
-        for(unsigned int i=0; i<4; i++)
-        {
-            boost::shared_ptr<DynamicTexture> c(new DynamicTexture("", shared_from_this(), imageBounds[i].x(), imageBounds[i].y(), imageBounds[i].width(), imageBounds[i].height(), i));
+    loading_ = false;
+    loaded_ = true;
 
-            c->computeImagePyramid(imagePyramidPath);
-        }
-    }
+    loadCondition_.wakeAll();
 }
 
-void DynamicTexture::decrementThreadCount()
+void DynamicTexture::evictTexture()
 {
-    if(depth_ == 0)
-    {
-        QMutexLocker locker(&threadCountMutex_);
-        threadCount_ = threadCount_ - 1;
-    }
-    else
+    if(textureBound_ == true)
     {
-        return getRoot()->decrementThreadCount();
+        g_mainWindow->getGLWindow()->insertPurgeTextureId(textureId_);
+
+        textureBound_ = false;
     }
+
+    // the image needs to be loaded again before the next upload
+    QMutexLocker locker(&loadMutex_);
+    loaded_ = false;
 }
 
 boost::shared_ptr<DynamicTexture> DynamicTexture::getRoot()
@@ -570,10 +600,7 @@ QRect DynamicTexture::getRootImageCoordinates(float x, float y, float w, float h
     if(depth_ == 0)
     {
         // if necessary, block and wait for image loading to complete
-        if(loadImageThreadStarted_ == true && loadImageThread_.isFinished() == false)
-        {
-            loadImageThread_.waitForFinished();
-        }
+        waitForImageLoaded();
 
         QRect rect = QRect(x*imageWidth_, y*imageHeight_, w*imageWidth_, h*imageHeight_);
         return rect;
@@ -612,16 +639,21 @@ QImage DynamicTexture::getImageFromParent(float x, float y, float w, float h, Dy
         return parent->getImageFromParent(pX, pY, pW, pH, start);
     }
 
-    // wait for the load image thread to complete if it's in progress
-    if(loadImageThreadStarted_ == true && loadImageThread_.isFinished() == false)
+    // wait for image loading to complete if it's in progress
+    waitForImageLoaded();
+
+    // an image load of this object may also start after the wait above, so image_ is only accessed under loadMutex_
+    QImage image;
+
     {
-        loadImageThread_.waitForFinished();
+        QMutexLocker locker(&loadMutex_);
+        image = image_;
     }
 
-    if(image_.isNull() != true)
+    if(image.isNull() != true)
     {
         // we have a valid image, return the clipped image
-        QImage copy = image_.copy(x*image_.width(), y*image_.height(), w*image_.width(), h*image_.height());
+        QImage copy = image.copy(x*image.width(), y*image.height(), w*image.width(), h*image.height());
         return copy;
     }
     else
@@ -649,12 +681,22 @@ QImage DynamicTexture::getImageFromParent(float x, float y, float w, float h, Dy
 
 void DynamicTexture::uploadTexture()
 {
+    // the root texture is the fallback for all other tiles, so it stays resident outside of the budget
+    // if the texture doesn't fit, keep the scaled image so the upload can be retried without loading the image again;
+    // meanwhile the tile is rendered from its parent
+    if(depth_ != 0 && g_mainWindow->getTextureResidencyManager().insert(this, scaledImage_.byteCount()) != true)
+    {
+        return;
+    }
+
     // generate new texture
     // no need to compute mipmaps
     // note that scaledImage_ is already in the GL format so we can use glTexImage2D directly
     glGenTextures(1, &textureId_);
     glBindTexture(GL_TEXTURE_2D, textureId_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, scaledImage_.width(), scaledImage_.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledImage_.bits());
+    // use the const image, so an image shared with the tile cache isn't copied
+    const QImage & image = scaledImage_;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
 
     textureBound_ = true;
 
@@ -803,9 +845,72 @@ double DynamicTexture::getProjectedPixelArea(bool onScreenOnly)
     return A;
 }
 
+double DynamicTexture::getProjectedCenterDistance()
+{
+    GLdouble modelview[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+
+    GLdouble projection[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // center of this object in screen space (recall we're in normalized 0->1 dimensions)
+    GLdouble xWin[3];
+    gluProject(0.5, 0.5, 0., modelview, projection, viewport, &xWin[0], &xWin[1], &xWin[2]);
+
+    double dx = xWin[0] - (viewport[0] + 0.5 * viewport[2]);
+    double dy = xWin[1] - (viewport[1] + 0.5 * viewport[3]);
+
+    return sqrt(dx*dx + dy*dy);
+}
+
+bool DynamicTexture::getImageLoaded()
+{
+    if(loadImageThreadStarted_ == true)
+    {
+        return loadImageThread_.isFinished();
+    }
+
+    QMutexLocker locker(&loadMutex_);
+    return loaded_;
+}
+
+bool DynamicTexture::getImageLoading()
+{
+    QMutexLocker locker(&loadMutex_);
+    return loading_;
+}
+
+void DynamicTexture::waitForImageLoaded()
+{
+    if(loadImageThreadStarted_ == true && loadImageThread_.isFinished() == false)
+    {
+        loadImageThread_.waitForFinished();
+    }
+
+    QMutexLocker locker(&loadMutex_);
+
+    while(loading_ == true)
+    {
+        loadCondition_.wait(&loadMutex_);
+    }
+}
+
+void DynamicTexture::cancelScheduledImageDescending()
+{
+    g_dynamicTextureScheduler.cancel(this);
+
+    for(unsigned int i=0; i<children_.size(); i++)
+    {
+        children_[i]->cancelScheduledImageDescending();
+    }
+}
+
 bool DynamicTexture::getThreadsDoneDescending()
 {
-    if(loadImageThread_.isFinished() == false)
+    if(loadImageThread_.isFinished() == false || getImageLoading() == true)
     {
         return false;
     }
@@ -821,6 +926,19 @@ bool DynamicTexture::getThreadsDoneDescending()
     return true;
 }
 
+bool DynamicTexture::getChildrenTextureBoundDescending()
+{
+    for(unsigned int i=0; i<children_.size(); i++)
+    {
+        if(children_[i]->textureBound_ == true || children_[i]->getChildrenTextureBoundDescending() == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 int DynamicTexture::getThreadCount()
 {
     if(depth_ == 0)
@@ -847,12 +965,6 @@ void DynamicTexture::incrementThreadCount()
     }
 }
 
-void loadImageThread(boost::shared_ptr<DynamicTexture> dynamicTexture, std::vector<boost::shared_ptr<DynamicTexture> > objects)
-{
-    loadImageThread(dynamicTexture.get());
-    return;
-}
-
 void loadImageThread(DynamicTexture * dynamicTexture)
 {
     dynamicTexture->loadImage();
@@ -46,8 +46,10 @@
 #undef DYNAMIC_TEXTURE_SHOW_BORDER
 
 #include "FactoryObject.h"
+#include "ImagePyramidContainer.h"
 #include <QGLWidget>
 #include <QtConcurrentRun>
+#include <QWaitCondition>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
@@ -62,9 +64,12 @@ class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, pu
         void loadImage(bool convertToGLFormat=true); // thread needs access to this method
         void getDimensions(int &width, int &height);
         void render(float tX, float tY, float tW, float tH, bool computeOnDemand=true, bool considerChildren=true);
-        void clearOldChildren(long minFrameCount); // clear children of nodes with renderChildrenFrameCount_ < minFrameCount
+        void clearOldChildren(long minFrameCount); // clear children of nodes with renderChildrenFrameCount_ < minFrameCount and no resident textures
         void computeImagePyramid(std::string imagePyramidPath);
         void decrementThreadCount(); // thread needs access to this method
+        void loadScheduledImage(); // thread needs access to this method
+        void evictTexture(); // thread needs access to this method
+        void getObjectsAscending(std::vector<boost::shared_ptr<DynamicTexture> > &objects); // thread needs access to this method
 
     private:
 
@@ -77,6 +82,9 @@ class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, pu
         std::string imagePyramidPath_;
         bool useImagePyramid_;
 
+        // for image pyramids in a single-file container; tiles are read from it instead of imagePyramidPath_
+        boost::shared_ptr<ImagePyramidContainer> imagePyramidContainer_;
+
         // thread count
         int threadCount_;
         QMutex threadCountMutex_;
@@ -94,10 +102,16 @@ class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, pu
         // path through the tree
         std::vector<int> treePath_;
 
-        // thread for loading images
+        // thread for loading images; for the root only, children are loaded by the scheduler
         QFuture<void> loadImageThread_;
         bool loadImageThreadStarted_;
 
+        // scheduled image loading state
+        QMutex loadMutex_;
+        QWaitCondition loadCondition_;
+        bool loading_;
+        bool loaded_;
+
         // full scale image and dimensions; image may be deleted, but dimensions are necessary for later use
         QImage image_;
         int imageWidth_;
@@ -117,20 +131,22 @@ class DynamicTexture : public boost::enable_shared_from_this<DynamicTexture>, pu
         long renderChildrenFrameCount_;
 
         boost::shared_ptr<DynamicTexture> getRoot();
-        void getObjectsAscending(std::vector<boost::shared_ptr<DynamicTexture> > &objects);
         QRect getRootImageCoordinates(float x, float y, float w, float h);
         QImage getImageFromParent(float x, float y, float w, float h, DynamicTexture * start);
         void uploadTexture();
         void renderChildren(float tX, float tY, float tW, float tH);
         double getProjectedPixelArea(bool onScreenOnly);
+        double getProjectedCenterDistance();
+        bool getImageLoaded();
+        bool getImageLoading();
+        void waitForImageLoaded();
+        void cancelScheduledImageDescending();
         bool getThreadsDoneDescending();
+        bool getChildrenTextureBoundDescending();
         int getThreadCount();
         void incrementThreadCount();
 };
 
-// this wrapper is used by child objects to prevent its ancestors from being destructed during thread execution.
-extern void loadImageThread(boost::shared_ptr<DynamicTexture> dynamicTexture, std::vector<boost::shared_ptr<DynamicTexture> > objects);
-
 extern void loadImageThread(DynamicTexture * dynamicTexture);
 
 #endif
@@ -0,0 +1,232 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DynamicTextureScheduler.h"
+#include "DynamicTexture.h"
+#include "log.h"
+#include <algorithm>
+
+DynamicTextureScheduler g_dynamicTextureScheduler;
+
+bool DynamicTextureRequestPriority::operator<(const DynamicTextureRequestPriority & other) const
+{
+    if(depth != other.depth)
+    {
+        return depth < other.depth;
+    }
+
+    if(distance != other.distance)
+    {
+        return distance < other.distance;
+    }
+
+    if(area != other.area)
+    {
+        return area > other.area;
+    }
+
+    return dynamicTexture < other.dynamicTexture;
+}
+
+DynamicTextureScheduler::DynamicTextureScheduler()
+{
+    frame_ = 0;
+    workers_ = 0;
+    shutdown_ = false;
+
+    // created on first use, after the application is set up
+    threadPool_ = NULL;
+}
+
+bool DynamicTextureScheduler::request(boost::shared_ptr<DynamicTexture> dynamicTexture, int depth, double distance, double area, long frame)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(shutdown_ == true)
+    {
+        return false;
+    }
+
+    if(threadPool_ == NULL)
+    {
+        // separate from the global thread pool, so loads don't wait behind other work
+        threadPool_ = new QThreadPool();
+        threadPool_->setMaxThreadCount(QThread::idealThreadCount());
+
+        put_flog(LOG_DEBUG, "loading tiles with %i threads", threadPool_->maxThreadCount());
+    }
+
+    frame_ = std::max(frame_, frame);
+
+    DynamicTextureRequestPriority priority;
+    priority.depth = depth;
+    priority.distance = distance;
+    priority.area = area;
+    priority.dynamicTexture = dynamicTexture.get();
+
+    std::map<DynamicTexture *, DynamicTextureRequest>::iterator it = requests_.find(dynamicTexture.get());
+
+    bool newRequest = (it == requests_.end());
+
+    if(newRequest != true)
+    {
+        // renew the request with the new priority
+        queue_.erase(it->second.priority);
+
+        it->second.priority = priority;
+        it->second.frame = frame;
+    }
+    else
+    {
+        DynamicTextureRequest & request = requests_[dynamicTexture.get()];
+
+        request.dynamicTexture = dynamicTexture;
+        request.priority = priority;
+        request.frame = frame;
+
+        // give the request shared_ptr's to all of this object's parents to prevent their destruction during loading
+        dynamicTexture->getObjectsAscending(request.objects);
+    }
+
+    queue_.insert(priority);
+
+    if(workers_ < threadPool_->maxThreadCount())
+    {
+        workers_++;
+
+        threadPool_->start(new DynamicTextureSchedulerWorker(this));
+    }
+
+    return newRequest;
+}
+
+void DynamicTextureScheduler::cancel(DynamicTexture * dynamicTexture)
+{
+    QMutexLocker locker(&mutex_);
+
+    std::map<DynamicTexture *, DynamicTextureRequest>::iterator it = requests_.find(dynamicTexture);
+
+    if(it != requests_.end())
+    {
+        queue_.erase(it->second.priority);
+        requests_.erase(it);
+    }
+}
+
+int DynamicTextureScheduler::getQueueSize()
+{
+    QMutexLocker locker(&mutex_);
+
+    return (int)queue_.size();
+}
+
+void DynamicTextureScheduler::shutdown()
+{
+    // the requests keep their tiles from destruction; release them outside the lock, since tile destructors cancel requests
+    std::map<DynamicTexture *, DynamicTextureRequest> requests;
+
+    {
+        QMutexLocker locker(&mutex_);
+
+        shutdown_ = true;
+
+        requests.swap(requests_);
+        queue_.clear();
+    }
+
+    requests.clear();
+
+    // workers find the queue empty after their current load and retire
+    if(threadPool_ != NULL)
+    {
+        threadPool_->waitForDone();
+    }
+}
+
+void DynamicTextureScheduler::runWorker()
+{
+    DynamicTextureRequest request;
+
+    while(takeRequest(request) == true)
+    {
+        request.dynamicTexture->loadScheduledImage();
+
+        // release the tile and its ancestors
+        request = DynamicTextureRequest();
+    }
+}
+
+bool DynamicTextureScheduler::takeRequest(DynamicTextureRequest & request)
+{
+    QMutexLocker locker(&mutex_);
+
+    while(queue_.size() > 0)
+    {
+        std::map<DynamicTexture *, DynamicTextureRequest>::iterator it = requests_.find(queue_.begin()->dynamicTexture);
+
+        queue_.erase(queue_.begin());
+
+        bool stale = (it->second.frame < frame_ - 1);
+
+        if(stale != true)
+        {
+            request = it->second;
+        }
+
+        requests_.erase(it);
+
+        if(stale != true)
+        {
+            return true;
+        }
+    }
+
+    workers_--;
+
+    return false;
+}
+
+DynamicTextureSchedulerWorker::DynamicTextureSchedulerWorker(DynamicTextureScheduler * scheduler)
+{
+    scheduler_ = scheduler;
+}
+
+void DynamicTextureSchedulerWorker::run()
+{
+    scheduler_->runWorker();
+}
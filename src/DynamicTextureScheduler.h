@@ -0,0 +1,145 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DYNAMIC_TEXTURE_SCHEDULER_H
+#define DYNAMIC_TEXTURE_SCHEDULER_H
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <set>
+#include <vector>
+
+class DynamicTexture;
+
+// priority of a tile load; lower values load first
+// coarse tiles load before fine ones, then tiles closer to the view center, then tiles covering more pixels
+struct DynamicTextureRequestPriority {
+
+    int depth;
+
+    // distance of the tile center from the view center, in pixels
+    double distance;
+
+    // projected on-screen area, in pixels
+    double area;
+
+    // tie breaker, so requests of equal priority are distinct
+    DynamicTexture * dynamicTexture;
+
+    bool operator<(const DynamicTextureRequestPriority & other) const;
+};
+
+struct DynamicTextureRequest {
+
+    boost::shared_ptr<DynamicTexture> dynamicTexture;
+
+    // the tile's ancestors, kept from destruction until the load is done
+    std::vector<boost::shared_ptr<DynamicTexture> > objects;
+
+    DynamicTextureRequestPriority priority;
+
+    // frame of the latest request
+    long frame;
+};
+
+// loads DynamicTexture tiles for all trees on a bounded pool of worker threads, highest priority first
+// tiles request loading every frame they are visible; requests not renewed in the current or previous frame
+// are stale, e.g. because the tile left the view, and are dropped without loading
+class DynamicTextureScheduler {
+
+    public:
+
+        DynamicTextureScheduler();
+
+        // queue a tile for loading, or update the priority of a queued tile
+        // returns true if the tile wasn't already queued
+        bool request(boost::shared_ptr<DynamicTexture> dynamicTexture, int depth, double distance, double area, long frame);
+
+        // remove a tile from the queue; a load already in progress completes
+        void cancel(DynamicTexture * dynamicTexture);
+
+        int getQueueSize();
+
+        // drop all queued requests and wait for loads in progress; no tiles are loaded afterwards
+        // must be called before the main window is deleted, since loads use its texture residency manager
+        void shutdown();
+
+        // for use by the worker threads: load tiles until the queue is empty
+        void runWorker();
+
+    private:
+
+        QMutex mutex_;
+
+        // queued requests, and their order
+        std::map<DynamicTexture *, DynamicTextureRequest> requests_;
+        std::set<DynamicTextureRequestPriority> queue_;
+
+        // latest frame of any request
+        long frame_;
+
+        // number of running workers, at most the size of the thread pool
+        int workers_;
+
+        // set by shutdown(); requests are ignored afterwards
+        bool shutdown_;
+
+        QThreadPool * threadPool_;
+
+        // for use in runWorker(): take the highest priority request that is not stale
+        // returns false, and retires the worker, if there is none
+        bool takeRequest(DynamicTextureRequest & request);
+};
+
+class DynamicTextureSchedulerWorker : public QRunnable {
+
+    public:
+
+        DynamicTextureSchedulerWorker(DynamicTextureScheduler * scheduler);
+
+        void run();
+
+    private:
+
+        DynamicTextureScheduler * scheduler_;
+};
+
+extern DynamicTextureScheduler g_dynamicTextureScheduler;
+
+#endif
@@ -39,6 +39,13 @@
 #include "FactoryObject.h"
 #include "main.h"
 
+FactoryObject::FactoryObject()
+{
+    // objects may be created outside of rendering, e.g. by the message receiver thread;
+    // count them as rendered in the current frame so they aren't purged before their first frame
+    renderedFrameCount_ = g_frameCount;
+}
+
 long FactoryObject::getRenderedFrameCount()
 {
     return renderedFrameCount_;
@@ -43,6 +43,8 @@ class FactoryObject {
 
     public:
 
+        FactoryObject();
+
         long getRenderedFrameCount();
 
     protected:
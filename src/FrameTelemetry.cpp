@@ -0,0 +1,327 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "FrameTelemetry.h"
+#include "main.h"
+#include "log.h"
+#include <QtNetwork/QTcpSocket>
+#include <algorithm>
+#include <sstream>
+
+// percentile of a set of values (nearest rank)
+static float getPercentile(std::vector<float> &values, float percentile)
+{
+    if(values.size() == 0)
+    {
+        return 0.;
+    }
+
+    unsigned int index = (unsigned int)(percentile / 100. * (float)(values.size() - 1) + 0.5);
+
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+
+    return values[index];
+}
+
+FrameTelemetry::FrameTelemetry()
+{
+    sendRequestActive_ = false;
+    server_ = NULL;
+
+    if(g_mpiRank == 0)
+    {
+        connect(&pollTimer_, SIGNAL(timeout()), this, SLOT(receiveTelemetry()));
+        pollTimer_.start(FRAME_TELEMETRY_POLL_INTERVAL);
+
+        // JSON endpoint
+        if(getenv(FRAME_TELEMETRY_PORT_ENV) != NULL)
+        {
+            int port = atoi(getenv(FRAME_TELEMETRY_PORT_ENV));
+
+            server_ = new QTcpServer(this);
+
+            if(server_->listen(QHostAddress::Any, port) != true)
+            {
+                put_flog(LOG_ERROR, "could not listen on port %i", port);
+            }
+            else
+            {
+                put_flog(LOG_INFO, "serving frame telemetry on port %i", port);
+
+                connect(server_, SIGNAL(newConnection()), this, SLOT(sendJSON()));
+            }
+        }
+    }
+}
+
+void FrameTelemetry::recordFrame(const FrameTiming &frame)
+{
+    float renderTime = 0.;
+
+    for(int i=FRAME_PHASE_UPDATE_GL; i<FRAME_TIMINGS_NUM_PHASES; i++)
+    {
+        if(frame.phaseDuration[i] >= 0)
+        {
+            renderTime += (float)frame.phaseDuration[i] / 1000.;
+        }
+    }
+
+    float barrierTime = (float)frame.phaseDuration[FRAME_PHASE_BARRIER] / 1000.;
+
+    frames_.push_back(renderTime);
+    frames_.push_back(barrierTime);
+
+    // all render processes gather at the same frame
+    if((frame.frameIndex + 1) % FRAME_TELEMETRY_INTERVAL != 0)
+    {
+        return;
+    }
+
+    // a process may have started recording in the middle of an interval; pad with invalid (negative) times
+    frames_.resize(2 * FRAME_TELEMETRY_INTERVAL, -1.);
+
+    int numRenderProcesses;
+    MPI_Comm_size(g_mpiRenderComm, &numRenderProcesses);
+
+    // the previous send must complete before its buffer is reused; don't wait for it, since rank 0 may be busy in the
+    // UI and waiting would hold up all render processes
+    if(g_mpiRank == 1 && sendRequestActive_ == true)
+    {
+        int flag;
+        MPI_Status status;
+        MPI_Test(&sendRequest_, &flag, &status);
+
+        if(flag != 0)
+        {
+            sendRequestActive_ = false;
+        }
+    }
+
+    std::vector<float> gatherBuffer;
+
+    if(g_mpiRank == 1)
+    {
+        gatherBuffer.resize(numRenderProcesses * 2 * FRAME_TELEMETRY_INTERVAL);
+    }
+
+    MPI_Gather((void *)&frames_[0], 2 * FRAME_TELEMETRY_INTERVAL, MPI_FLOAT, (void *)(g_mpiRank == 1 ? &gatherBuffer[0] : NULL), 2 * FRAME_TELEMETRY_INTERVAL, MPI_FLOAT, 0, g_mpiRenderComm);
+
+    frames_.clear();
+
+    // rank 1 forwards the gathered frames to rank 0 (non-blocking)
+    if(g_mpiRank == 1)
+    {
+        if(sendRequestActive_ == true)
+        {
+            put_flog(LOG_DEBUG, "previous telemetry not yet received by rank 0, dropping %i frames", FRAME_TELEMETRY_INTERVAL);
+            return;
+        }
+
+        sendBuffer_.swap(gatherBuffer);
+
+        MPI_Isend((void *)&sendBuffer_[0], sendBuffer_.size(), MPI_FLOAT, 0, FRAME_TELEMETRY_TAG, MPI_COMM_WORLD, &sendRequest_);
+
+        sendRequestActive_ = true;
+    }
+}
+
+std::vector<FrameTelemetryStatistics> FrameTelemetry::getStatistics()
+{
+    QMutexLocker locker(&mutex_);
+
+    std::vector<FrameTelemetryStatistics> statistics;
+
+    for(std::map<int, std::deque<std::pair<float, float> > >::iterator it=rankFrames_.begin(); it != rankFrames_.end(); it++)
+    {
+        std::vector<float> renderTimes;
+        std::vector<float> barrierTimes;
+
+        for(unsigned int i=0; i<(*it).second.size(); i++)
+        {
+            renderTimes.push_back((*it).second[i].first);
+            barrierTimes.push_back((*it).second[i].second);
+        }
+
+        FrameTelemetryStatistics s;
+        s.rank = (*it).first;
+        s.numFrames = (*it).second.size();
+        s.renderTimeP50 = getPercentile(renderTimes, 50.);
+        s.renderTimeP95 = getPercentile(renderTimes, 95.);
+        s.renderTimeP99 = getPercentile(renderTimes, 99.);
+        s.barrierTimeP50 = getPercentile(barrierTimes, 50.);
+        s.barrierTimeP95 = getPercentile(barrierTimes, 95.);
+        s.barrierTimeP99 = getPercentile(barrierTimes, 99.);
+
+        statistics.push_back(s);
+    }
+
+    return statistics;
+}
+
+int FrameTelemetry::getStragglerRank()
+{
+    QMutexLocker locker(&mutex_);
+
+    // the rank with the shortest barrier wait is the one the others are waiting on
+    // this matches FrameTimings::logSummary(); render time alone would miss time spent receiving and decoding
+    int stragglerRank = -1;
+    float minBarrierTime = 0.;
+
+    for(std::map<int, std::deque<std::pair<float, float> > >::iterator it=rankFrames_.begin(); it != rankFrames_.end(); it++)
+    {
+        if((*it).second.size() == 0)
+        {
+            continue;
+        }
+
+        float barrierTime = 0.;
+
+        for(unsigned int i=0; i<(*it).second.size(); i++)
+        {
+            barrierTime += (*it).second[i].second;
+        }
+
+        barrierTime /= (float)(*it).second.size();
+
+        if(stragglerRank == -1 || barrierTime < minBarrierTime)
+        {
+            stragglerRank = (*it).first;
+            minBarrierTime = barrierTime;
+        }
+    }
+
+    return stragglerRank;
+}
+
+std::string FrameTelemetry::getJSON()
+{
+    std::vector<FrameTelemetryStatistics> statistics = getStatistics();
+
+    std::ostringstream oss;
+
+    oss << "{\"frameCount\":" << g_frameCount << ",\"stragglerRank\":" << getStragglerRank() << ",\"ranks\":[";
+
+    for(unsigned int i=0; i<statistics.size(); i++)
+    {
+        FrameTelemetryStatistics &s = statistics[i];
+
+        if(i > 0)
+        {
+            oss << ",";
+        }
+
+        oss << "{\"rank\":" << s.rank << ",\"numFrames\":" << s.numFrames;
+        oss << ",\"renderTime\":{\"p50\":" << s.renderTimeP50 << ",\"p95\":" << s.renderTimeP95 << ",\"p99\":" << s.renderTimeP99 << "}";
+        oss << ",\"barrierTime\":{\"p50\":" << s.barrierTimeP50 << ",\"p95\":" << s.barrierTimeP95 << ",\"p99\":" << s.barrierTimeP99 << "}}";
+    }
+
+    oss << "]}";
+
+    return oss.str();
+}
+
+void FrameTelemetry::receiveTelemetry()
+{
+    bool received = false;
+
+    int flag;
+    MPI_Status status;
+    MPI_Iprobe(1, FRAME_TELEMETRY_TAG, MPI_COMM_WORLD, &flag, &status);
+
+    while(flag != 0)
+    {
+        int count;
+        MPI_Get_count(&status, MPI_FLOAT, &count);
+
+        std::vector<float> buffer(count);
+        MPI_Recv((void *)&buffer[0], count, MPI_FLOAT, 1, FRAME_TELEMETRY_TAG, MPI_COMM_WORLD, &status);
+
+        // the buffer has FRAME_TELEMETRY_INTERVAL (render time, barrier time) pairs for each render process, ordered by rank
+        {
+            QMutexLocker locker(&mutex_);
+
+            for(int i=0; i<count / 2; i++)
+            {
+                if(buffer[2*i] < 0.)
+                {
+                    continue;
+                }
+
+                int rank = 1 + i / FRAME_TELEMETRY_INTERVAL;
+
+                std::deque<std::pair<float, float> > &frames = rankFrames_[rank];
+                frames.push_back(std::pair<float, float>(buffer[2*i], buffer[2*i + 1]));
+
+                if(frames.size() > FRAME_TELEMETRY_WINDOW_SIZE)
+                {
+                    frames.pop_front();
+                }
+            }
+        }
+
+        received = true;
+
+        MPI_Iprobe(1, FRAME_TELEMETRY_TAG, MPI_COMM_WORLD, &flag, &status);
+    }
+
+    if(received == true)
+    {
+        emit(updated());
+    }
+}
+
+void FrameTelemetry::sendJSON()
+{
+    while(server_->hasPendingConnections() == true)
+    {
+        QTcpSocket * socket = server_->nextPendingConnection();
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+
+        // respond as HTTP so the endpoint can be used directly with e.g. curl
+        std::string json = getJSON();
+
+        QByteArray response;
+        response.append("HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: ");
+        response.append(QByteArray::number((int)json.size()));
+        response.append("\r\n\r\n");
+        response.append(json.c_str());
+
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,133 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef FRAME_TELEMETRY_H
+#define FRAME_TELEMETRY_H
+
+// number of frames between gathers of per-rank frame times
+#define FRAME_TELEMETRY_INTERVAL 60
+
+// number of frames per rank kept by rank 0 for the rolling percentiles
+#define FRAME_TELEMETRY_WINDOW_SIZE 600
+
+// interval (ms) rank 0 polls for telemetry from rank 1
+#define FRAME_TELEMETRY_POLL_INTERVAL 100
+
+// MPI tag for telemetry sent from rank 1 to rank 0
+#define FRAME_TELEMETRY_TAG 2
+
+// environment variable with the port of the JSON telemetry endpoint; the endpoint is disabled if it isn't set
+#define FRAME_TELEMETRY_PORT_ENV "DISPLAYCLUSTER_TELEMETRY_PORT"
+
+#include "FrameTimings.h"
+#include <QtCore>
+#include <QtNetwork/QTcpServer>
+#include <mpi.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// rolling frame time percentiles of one render process, in ms
+struct FrameTelemetryStatistics {
+
+    int rank;
+    int numFrames;
+
+    // time spent in updateGL() for all windows
+    float renderTimeP50;
+    float renderTimeP95;
+    float renderTimeP99;
+
+    // time spent waiting at the end of frame barrier
+    float barrierTimeP50;
+    float barrierTimeP95;
+    float barrierTimeP99;
+};
+
+// collects render and barrier wait times from all render processes at rank 0
+// render processes record each frame and periodically gather them to rank 1, which forwards them to rank 0
+// rank 0 keeps rolling percentiles for each rank and serves them as JSON if FRAME_TELEMETRY_PORT_ENV is set
+class FrameTelemetry : public QObject {
+    Q_OBJECT
+
+    public:
+
+        FrameTelemetry();
+
+        // record a finished frame (render processes)
+        // this is collective over the render processes every FRAME_TELEMETRY_INTERVAL frames
+        void recordFrame(const FrameTiming &frame);
+
+        // get the statistics for all render processes (rank 0)
+        std::vector<FrameTelemetryStatistics> getStatistics();
+
+        // get the rank with the shortest average barrier wait, or -1 if there are no statistics (rank 0)
+        int getStragglerRank();
+
+        // get the statistics as a JSON document (rank 0)
+        std::string getJSON();
+
+    signals:
+
+        void updated();
+
+    private slots:
+
+        void receiveTelemetry();
+        void sendJSON();
+
+    private:
+
+        // render processes: frames since the last gather (render time, barrier time pairs)
+        std::vector<float> frames_;
+
+        // rank 1: gathered frames being sent to rank 0; gathers while a send is pending are dropped
+        std::vector<float> sendBuffer_;
+        MPI_Request sendRequest_;
+        bool sendRequestActive_;
+
+        // rank 0: recent frames for each rank (render time, barrier time pairs)
+        QMutex mutex_;
+        std::map<int, std::deque<std::pair<float, float> > > rankFrames_;
+
+        QTimer pollTimer_;
+        QTcpServer * server_;
+};
+
+#endif
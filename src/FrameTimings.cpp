@@ -0,0 +1,336 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "FrameTimings.h"
+#include "log.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <fstream>
+
+FrameTimings::FrameTimings()
+{
+    currentPhase_ = -1;
+    currentPhaseStartTime_ = 0;
+    recording_ = false;
+}
+
+void FrameTimings::beginFrame(int64_t frameIndex)
+{
+    current_.frameIndex = frameIndex;
+    current_.startTime = getTime();
+
+    for(int i=0; i<FRAME_TIMINGS_NUM_PHASES; i++)
+    {
+        current_.phaseStart[i] = 0;
+        current_.phaseDuration[i] = -1;
+    }
+
+    currentPhase_ = -1;
+    recording_ = true;
+}
+
+void FrameTimings::beginPhase(int phase)
+{
+    if(recording_ != true)
+    {
+        return;
+    }
+
+    int64_t time = getTime();
+
+    // end the current phase
+    if(currentPhase_ >= 0)
+    {
+        current_.phaseDuration[currentPhase_] = (int32_t)(time - currentPhaseStartTime_);
+    }
+
+    // phases for windows beyond the maximum aren't recorded
+    if(phase < 0 || phase >= FRAME_TIMINGS_NUM_PHASES)
+    {
+        currentPhase_ = -1;
+        return;
+    }
+
+    currentPhase_ = phase;
+    currentPhaseStartTime_ = time;
+    current_.phaseStart[phase] = (int32_t)(time - current_.startTime);
+}
+
+void FrameTimings::endFrame()
+{
+    if(recording_ != true)
+    {
+        return;
+    }
+
+    beginPhase(-1);
+
+    // copy into the ring buffer, then publish it by incrementing the count
+    int count = count_.fetchAndAddOrdered(0);
+
+    frames_[count % FRAME_TIMINGS_BUFFER_SIZE] = current_;
+
+    count_.fetchAndStoreRelease(count + 1);
+
+    recording_ = false;
+}
+
+FrameTiming FrameTimings::getLastFrame()
+{
+    return current_;
+}
+
+std::vector<FrameTiming> FrameTimings::getSnapshot()
+{
+    std::vector<FrameTiming> frames;
+
+    int countBefore = count_.fetchAndAddOrdered(0);
+
+    int first = countBefore - FRAME_TIMINGS_BUFFER_SIZE;
+
+    if(first < 0)
+    {
+        first = 0;
+    }
+
+    for(int i=first; i<countBefore; i++)
+    {
+        frames.push_back(frames_[i % FRAME_TIMINGS_BUFFER_SIZE]);
+    }
+
+    // frames published while copying may have overwritten the oldest entries (including the slot being written); drop those
+    int countAfter = count_.fetchAndAddOrdered(0);
+
+    int firstValid = countAfter - FRAME_TIMINGS_BUFFER_SIZE + 1;
+
+    if(firstValid > first)
+    {
+        int numInvalid = firstValid - first;
+
+        if(numInvalid > (int)frames.size())
+        {
+            numInvalid = frames.size();
+        }
+
+        frames.erase(frames.begin(), frames.begin() + numInvalid);
+    }
+
+    return frames;
+}
+
+std::string FrameTimings::getPhaseName(int phase)
+{
+    switch(phase)
+    {
+        case FRAME_PHASE_RECEIVE_MESSAGES:
+            return "receiveMessages";
+        case FRAME_PHASE_FRAME_CLOCK:
+            return "frameClock";
+        case FRAME_PHASE_BARRIER:
+            return "barrier";
+        case FRAME_PHASE_SWAP_BUFFERS:
+            return "swapBuffers";
+        case FRAME_PHASE_ADVANCE_CONTENTS:
+            return "advanceContents";
+        case FRAME_PHASE_CLEAR_STALE_OBJECTS:
+            return "clearStaleObjects";
+        case FRAME_PHASE_PURGE_TEXTURES:
+            return "purgeTextures";
+        default:
+            return "updateGL" + QString::number(phase - FRAME_PHASE_UPDATE_GL).toStdString();
+    }
+}
+
+bool FrameTimings::writeCSV(const std::map<int, std::vector<FrameTiming> > &timings, std::string filename)
+{
+    std::ofstream ofs(filename.c_str());
+
+    if(ofs.good() != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    // one row per rank and frame, with one column for each phase duration (microseconds)
+    ofs << "rank,frameIndex,startTime";
+
+    for(int i=0; i<FRAME_TIMINGS_NUM_PHASES; i++)
+    {
+        ofs << "," << getPhaseName(i);
+    }
+
+    ofs << std::endl;
+
+    for(std::map<int, std::vector<FrameTiming> >::const_iterator it=timings.begin(); it != timings.end(); it++)
+    {
+        for(unsigned int i=0; i<(*it).second.size(); i++)
+        {
+            const FrameTiming &f = (*it).second[i];
+
+            ofs << (*it).first << "," << f.frameIndex << "," << f.startTime;
+
+            for(int j=0; j<FRAME_TIMINGS_NUM_PHASES; j++)
+            {
+                ofs << ",";
+
+                if(f.phaseDuration[j] >= 0)
+                {
+                    ofs << f.phaseDuration[j];
+                }
+            }
+
+            ofs << std::endl;
+        }
+    }
+
+    return ofs.good();
+}
+
+bool FrameTimings::writeChromeTrace(const std::map<int, std::vector<FrameTiming> > &timings, std::string filename)
+{
+    std::ofstream ofs(filename.c_str());
+
+    if(ofs.good() != true)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    // trace event format: one complete ("X") event per phase, with the rank as the process id
+    ofs << "{\"traceEvents\":[" << std::endl;
+
+    bool first = true;
+
+    for(std::map<int, std::vector<FrameTiming> >::const_iterator it=timings.begin(); it != timings.end(); it++)
+    {
+        for(unsigned int i=0; i<(*it).second.size(); i++)
+        {
+            const FrameTiming &f = (*it).second[i];
+
+            for(int j=0; j<FRAME_TIMINGS_NUM_PHASES; j++)
+            {
+                if(f.phaseDuration[j] < 0)
+                {
+                    continue;
+                }
+
+                if(first != true)
+                {
+                    ofs << "," << std::endl;
+                }
+
+                first = false;
+
+                ofs << "{\"name\":\"" << getPhaseName(j) << "\",\"ph\":\"X\",\"pid\":" << (*it).first << ",\"tid\":0";
+                ofs << ",\"ts\":" << f.startTime + f.phaseStart[j] << ",\"dur\":" << f.phaseDuration[j];
+                ofs << ",\"args\":{\"frameIndex\":" << f.frameIndex << "}}";
+            }
+        }
+    }
+
+    ofs << std::endl << "]}" << std::endl;
+
+    return ofs.good();
+}
+
+void FrameTimings::logSummary(const std::map<int, std::vector<FrameTiming> > &timings)
+{
+    // the rank with the shortest barrier wait is the one the others are waiting on
+    int stragglerRank = -1;
+    double minBarrierTime = 0.;
+
+    for(std::map<int, std::vector<FrameTiming> >::const_iterator it=timings.begin(); it != timings.end(); it++)
+    {
+        double totals[FRAME_TIMINGS_NUM_PHASES];
+        int counts[FRAME_TIMINGS_NUM_PHASES];
+
+        for(int j=0; j<FRAME_TIMINGS_NUM_PHASES; j++)
+        {
+            totals[j] = 0.;
+            counts[j] = 0;
+        }
+
+        for(unsigned int i=0; i<(*it).second.size(); i++)
+        {
+            for(int j=0; j<FRAME_TIMINGS_NUM_PHASES; j++)
+            {
+                if((*it).second[i].phaseDuration[j] >= 0)
+                {
+                    totals[j] += (double)(*it).second[i].phaseDuration[j];
+                    counts[j]++;
+                }
+            }
+        }
+
+        std::string summary;
+
+        for(int j=0; j<FRAME_TIMINGS_NUM_PHASES; j++)
+        {
+            if(counts[j] > 0)
+            {
+                summary += " " + getPhaseName(j) + " = " + QString::number(totals[j] / (double)counts[j] / 1000., 'f', 3).toStdString();
+            }
+        }
+
+        put_flog(LOG_INFO, "rank %i: %i frames, average phase durations (ms):%s", (*it).first, (int)(*it).second.size(), summary.c_str());
+
+        if(counts[FRAME_PHASE_BARRIER] > 0)
+        {
+            double barrierTime = totals[FRAME_PHASE_BARRIER] / (double)counts[FRAME_PHASE_BARRIER];
+
+            if(stragglerRank == -1 || barrierTime < minBarrierTime)
+            {
+                stragglerRank = (*it).first;
+                minBarrierTime = barrierTime;
+            }
+        }
+    }
+
+    if(stragglerRank != -1)
+    {
+        put_flog(LOG_INFO, "rank %i has the shortest average barrier wait (%f ms) and is holding up the other ranks", stragglerRank, minBarrierTime / 1000.);
+    }
+}
+
+int64_t FrameTimings::getTime()
+{
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    return (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds();
+}
+
+FrameTimings g_frameTimings;
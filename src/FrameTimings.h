@@ -0,0 +1,134 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef FRAME_TIMINGS_H
+#define FRAME_TIMINGS_H
+
+// number of frames kept in the ring buffer
+#define FRAME_TIMINGS_BUFFER_SIZE 1024
+
+// maximum number of GLWindows with separately recorded updateGL() durations
+#define FRAME_TIMINGS_MAX_WINDOWS 8
+
+#include <QtCore>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    typedef __int64 int64_t;
+    typedef __int32 int32_t;
+#else
+    #include <stdint.h>
+#endif
+
+// phases of MainWindow::updateGLWindows(), in order
+// FRAME_PHASE_UPDATE_GL is followed by one phase for each GLWindow
+enum FRAME_PHASE { FRAME_PHASE_RECEIVE_MESSAGES, FRAME_PHASE_FRAME_CLOCK, FRAME_PHASE_BARRIER, FRAME_PHASE_SWAP_BUFFERS, FRAME_PHASE_ADVANCE_CONTENTS, FRAME_PHASE_CLEAR_STALE_OBJECTS, FRAME_PHASE_PURGE_TEXTURES, FRAME_PHASE_UPDATE_GL };
+
+#define FRAME_TIMINGS_NUM_PHASES (FRAME_PHASE_UPDATE_GL + FRAME_TIMINGS_MAX_WINDOWS)
+
+// timing of one frame; plain data so it can be sent directly over MPI
+struct FrameTiming {
+
+    int64_t frameIndex;
+
+    // frame start time, in microseconds since the epoch
+    int64_t startTime;
+
+    // start time relative to the frame start and duration of each phase, in microseconds
+    // the duration is -1 for phases that didn't occur in this frame
+    int32_t phaseStart[FRAME_TIMINGS_NUM_PHASES];
+    int32_t phaseDuration[FRAME_TIMINGS_NUM_PHASES];
+};
+
+// records per-frame phase durations into a fixed-size ring buffer
+// there is a single writer (the main thread); snapshots may be taken from any thread without locking
+class FrameTimings {
+
+    public:
+
+        FrameTimings();
+
+        // start a new frame; this also starts the first phase
+        void beginFrame(int64_t frameIndex);
+
+        // end the current phase (if any) and start the given phase
+        void beginPhase(int phase);
+
+        // end the current phase and publish the frame to the ring buffer
+        void endFrame();
+
+        // get the last frame recorded (from the writer's thread only)
+        FrameTiming getLastFrame();
+
+        // get the recorded frames still in the ring buffer, oldest first
+        std::vector<FrameTiming> getSnapshot();
+
+        // name of a phase, e.g. for trace output
+        static std::string getPhaseName(int phase);
+
+        // write timings for all ranks; returns true on success
+        static bool writeCSV(const std::map<int, std::vector<FrameTiming> > &timings, std::string filename);
+        static bool writeChromeTrace(const std::map<int, std::vector<FrameTiming> > &timings, std::string filename);
+
+        // log average phase durations for all ranks, and the rank which the others wait on at the barrier
+        static void logSummary(const std::map<int, std::vector<FrameTiming> > &timings);
+
+    private:
+
+        // ring buffer of published frames
+        FrameTiming frames_[FRAME_TIMINGS_BUFFER_SIZE];
+
+        // number of frames published; the newest frame is at index (count - 1) % FRAME_TIMINGS_BUFFER_SIZE
+        QAtomicInt count_;
+
+        // frame being recorded
+        FrameTiming current_;
+        int currentPhase_;
+        int64_t currentPhaseStartTime_;
+
+        bool recording_;
+
+        static int64_t getTime();
+};
+
+// global frame timings for this process
+extern FrameTimings g_frameTimings;
+
+#endif
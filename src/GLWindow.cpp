@@ -39,6 +39,7 @@
 #include "GLWindow.h"
 #include "main.h"
 #include "Marker.h"
+#include "StreamingTexture.h"
 #include "ContentWindowManager.h"
 #include "log.h"
 #include <QtOpenGL>
@@ -116,6 +117,13 @@ void GLWindow::insertPurgeTextureId(GLuint textureId)
     purgeTextureIds_.push_back(textureId);
 }
 
+void GLWindow::insertPurgeBufferId(GLuint bufferId)
+{
+    QMutexLocker locker(&purgeTexturesMutex_);
+
+    purgeBufferIds_.push_back(bufferId);
+}
+
 void GLWindow::purgeTextures()
 {
     QMutexLocker locker(&purgeTexturesMutex_);
@@ -127,6 +135,9 @@ void GLWindow::purgeTextures()
     }
 
     purgeTextureIds_.clear();
+
+    StreamingTexture::deleteBuffers(purgeBufferIds_);
+    purgeBufferIds_.clear();
 }
 
 void GLWindow::initializeGL()
@@ -236,31 +247,13 @@ void GLWindow::setOrthographicView()
     }
     else
     {
-        // tiled display parameters
-        double tileI = (double)g_configuration->getTileI(tileIndex_);
-        double numTilesWidth = (double)g_configuration->getNumTilesWidth();
-        double screenWidth = (double)g_configuration->getScreenWidth();
-        double mullionWidth = (double)g_configuration->getMullionWidth();
-
-        double tileJ = (double)g_configuration->getTileJ(tileIndex_);
-        double numTilesHeight = (double)g_configuration->getNumTilesHeight();
-        double screenHeight = (double)g_configuration->getScreenHeight();
-        double mullionHeight = (double)g_configuration->getMullionHeight();
-
-        // border calculations
-        left_ = tileI / numTilesWidth * ( numTilesWidth * screenWidth ) + tileI * mullionWidth;
-        right_ = left_ + screenWidth;
-        bottom_ = tileJ / numTilesHeight * ( numTilesHeight * screenHeight ) + tileJ * mullionHeight;
-        top_ = bottom_ + screenHeight;
-
-        // normalize to 0->1
-        double totalWidth = (double)g_configuration->getTotalWidth();
-        double totalHeight = (double)g_configuration->getTotalHeight();
-
-        left_ /= totalWidth;
-        right_ /= totalWidth;
-        bottom_ /= totalHeight;
-        top_ /= totalHeight;
+        // normalized tile bounds; rank 0 uses the same computation to route stream segments to tiles
+        QRectF tileRect = g_configuration->getNormalizedTileRect(g_configuration->getTileI(tileIndex_), g_configuration->getTileJ(tileIndex_));
+
+        left_ = tileRect.left();
+        right_ = tileRect.right();
+        bottom_ = tileRect.top();
+        top_ = tileRect.bottom();
     }
 
     gluOrtho2D(left_, right_, bottom_, top_);
@@ -503,6 +496,24 @@ void GLWindow::renderTestPattern()
         label6 += "False";
     }
 
+    // texture residency of the DynamicTexture tiles in this process
+    TextureResidencyStatistics residency = g_mainWindow->getTextureResidencyManager().getStatistics();
+
+    QString label7 = "Texture residency: " + QString::number(residency.residentBytes / (1024 * 1024)) + " / " + QString::number(residency.budgetBytes / (1024 * 1024)) + " MB, " + QString::number(residency.residentTextures) + " textures";
+    QString label8 = "Texture hits / misses / evictions / refusals: " + QString::number(residency.hits) + " / " + QString::number(residency.misses) + " / " + QString::number(residency.evictions) + " / " + QString::number(residency.refusals);
+
+    // decoded tile cache of this process
+    DecodedTileCacheStatistics tileCache = g_decodedTileCache->getStatistics();
+
+    double tileCacheHitRate = 0.;
+
+    if(tileCache.hits + tileCache.misses > 0)
+    {
+        tileCacheHitRate = 100. * (double)tileCache.hits / (double)(tileCache.hits + tileCache.misses);
+    }
+
+    QString label9 = "Tile cache: " + QString::number(tileCache.bytes / (1024 * 1024)) + " / " + QString::number(tileCache.capacityBytes / (1024 * 1024)) + " MB, " + QString::number(tileCache.tiles) + " tiles, " + QString::number(tileCacheHitRate, 'f', 1) + "% hits";
+
     int fontSize = 64;
 
     QFont font;
@@ -516,6 +527,9 @@ void GLWindow::renderTestPattern()
     renderText(50, 4*fontSize, label4, font);
     renderText(50, 5*fontSize, label5, font);
     renderText(50, 6*fontSize, label6, font);
+    renderText(50, 7*fontSize, label7, font);
+    renderText(50, 8*fontSize, label8, font);
+    renderText(50, 9*fontSize, label9, font);
 
     glPopMatrix();
     glPopAttrib();
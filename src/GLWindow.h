@@ -65,6 +65,7 @@ class GLWindow : public QGLWidget
         Factory<ParallelPixelStream> & getParallelPixelStreamFactory();
 
         void insertPurgeTextureId(GLuint textureId);
+        void insertPurgeBufferId(GLuint bufferId);
         void purgeTextures();
 
         void initializeGL();
@@ -100,6 +101,7 @@ class GLWindow : public QGLWidget
         // this allows other threads to trigger deletion of a texture during the main OpenGL thread execution
         QMutex purgeTexturesMutex_;
         std::vector<GLuint> purgeTextureIds_;
+        std::vector<GLuint> purgeBufferIds_;
 
         void renderTestPattern();
 };
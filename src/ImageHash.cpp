@@ -0,0 +1,112 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImageHash.h"
+#include <cstring>
+
+// multipliers from xxHash
+#define IMAGE_HASH_PRIME_1 11400714785074694791ULL
+#define IMAGE_HASH_PRIME_2 14029467366897019727ULL
+#define IMAGE_HASH_PRIME_3 1609587929392839161ULL
+
+inline uint64_t imageHashRotate(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t imageHashRound(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * IMAGE_HASH_PRIME_2;
+    accumulator = imageHashRotate(accumulator, 31);
+    accumulator *= IMAGE_HASH_PRIME_1;
+
+    return accumulator;
+}
+
+uint64_t computeImageHash(const unsigned char * imageBuffer, int widthBytes, int pitch, int height, uint64_t seed)
+{
+    // four independent lanes
+    uint64_t lanes[4];
+
+    lanes[0] = seed + IMAGE_HASH_PRIME_1 + IMAGE_HASH_PRIME_2;
+    lanes[1] = seed + IMAGE_HASH_PRIME_2;
+    lanes[2] = seed;
+    lanes[3] = seed - IMAGE_HASH_PRIME_1;
+
+    int numBlocks = widthBytes / 32;
+    int tailBytes = widthBytes % 32;
+
+    // tail bytes of all rows are hashed separately, a byte at a time
+    uint64_t tail = seed + IMAGE_HASH_PRIME_3;
+
+    for(int y=0; y<height; y++)
+    {
+        const unsigned char * row = imageBuffer + (size_t)y * (size_t)pitch;
+
+        for(int b=0; b<numBlocks; b++)
+        {
+            uint64_t words[4];
+            memcpy(words, row + b*32, 32);
+
+            for(int i=0; i<4; i++)
+            {
+                lanes[i] = imageHashRound(lanes[i], words[i]);
+            }
+        }
+
+        for(int i=0; i<tailBytes; i++)
+        {
+            tail = imageHashRotate(tail ^ (row[numBlocks*32 + i] * IMAGE_HASH_PRIME_3), 11) * IMAGE_HASH_PRIME_1;
+        }
+    }
+
+    // merge the lanes, the tail and the dimensions
+    uint64_t hash = imageHashRotate(lanes[0], 1) + imageHashRotate(lanes[1], 7) + imageHashRotate(lanes[2], 12) + imageHashRotate(lanes[3], 18);
+
+    hash = imageHashRound(hash, tail);
+    hash = imageHashRound(hash, ((uint64_t)widthBytes << 32) | (uint64_t)height);
+
+    // final avalanche
+    hash ^= hash >> 33;
+    hash *= IMAGE_HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= IMAGE_HASH_PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
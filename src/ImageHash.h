@@ -36,35 +36,19 @@
 /* or implied, of The University of Texas at Austin.                 */
 /*********************************************************************/
 
-#ifndef NETWORK_LISTENER_THREAD_H
-#define NETWORK_LISTENER_THREAD_H
+#ifndef IMAGE_HASH_H
+#define IMAGE_HASH_H
 
-// increment this every time the network protocol changes in a major way
-#include "NetworkProtocol.h"
-
-#include "DisplayGroupManager.h"
-#include <QThread>
-#include <QtNetwork/QTcpSocket>
-
-class NetworkListenerThread : public QThread {
-    Q_OBJECT
-
-    public:
-
-        NetworkListenerThread(int socketDescriptor);
-
-        void run();
-
-    signals:
-
-        void updatedPixelStreamSource();
-        void updatedSVGStreamSource();
-
-    private:
-
-        int socketDescriptor_;
+#ifdef _WIN32
+    typedef unsigned __int64 uint64_t;
+#else
+    #include <stdint.h>
+#endif
 
-        void handleMessage(MessageHeader messageHeader, QByteArray byteArray);
-};
+// computes a 64-bit hash of a rectangle of an image, for detecting changes between frames
+// widthBytes is the number of bytes of each row to hash, and pitch the number of bytes between rows
+// rows are hashed in 32-byte blocks with four independent lanes, so the inner loop vectorizes well
+// this is not a cryptographic hash
+extern uint64_t computeImageHash(const unsigned char * imageBuffer, int widthBytes, int pitch, int height, uint64_t seed = 0);
 
 #endif
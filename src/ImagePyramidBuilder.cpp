@@ -0,0 +1,393 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidBuilder.h"
+#include "JpegCompressor.h"
+#include "log.h"
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+
+ImagePyramidBuilder::ImagePyramidBuilder(boost::shared_ptr<ImagePyramidSource> source)
+{
+    source_ = source;
+    jpegQuality_ = IMAGE_PYRAMID_JPEG_QUALITY;
+    depth_ = 0;
+
+    statistics_.sourcePixels = 0;
+    statistics_.tiles = 0;
+    statistics_.depth = 0;
+    statistics_.seconds = 0.;
+    statistics_.megapixelsPerSecond = 0.;
+}
+
+void ImagePyramidBuilder::setJpegQuality(int quality)
+{
+    jpegQuality_ = quality;
+}
+
+bool ImagePyramidBuilder::build(std::string imagePyramidPath)
+{
+    QTime time;
+    time.start();
+
+    imagePyramidPath_ = imagePyramidPath;
+
+    int width = source_->getWidth();
+    int height = source_->getHeight();
+
+    if(width <= 0 || height <= 0)
+    {
+        put_flog(LOG_ERROR, "invalid source dimensions %ix%i", width, height);
+        return false;
+    }
+
+    depth_ = getDepth(width, height);
+
+    containerWriter_.reset();
+
+    if(QString(imagePyramidPath_.c_str()).endsWith(".pyrc") == true)
+    {
+        containerWriter_ = boost::shared_ptr<ImagePyramidContainerWriter>(new ImagePyramidContainerWriter());
+
+        if(containerWriter_->open(imagePyramidPath_, width, height, IMAGE_PYRAMID_TILE_SIZE, depth_) != true)
+        {
+            return false;
+        }
+    }
+    // make directory if necessary
+    else if(QDir(imagePyramidPath_.c_str()).exists() != true)
+    {
+        bool success = QDir().mkpath(imagePyramidPath_.c_str());
+
+        if(success != true)
+        {
+            put_flog(LOG_ERROR, "error creating directory %s", imagePyramidPath_.c_str());
+            return false;
+        }
+    }
+
+    pendingTiles_.clear();
+    pendingTiles_.resize(depth_);
+
+    tileCount_ = 0;
+    failed_ = 0;
+
+    // leaf tiles per side
+    int count = 1 << depth_;
+
+    put_flog(LOG_INFO, "building %i level pyramid for %ix%i image, strips of %i rows", depth_ + 1, width, height, (height + count - 1) / count);
+
+    for(int row=0; row<count && failed_ == 0; row++)
+    {
+        // rows of the source covered by this row of leaf tiles; every tile covers at least one row
+        int y = (int)((int64_t)height * row / count);
+        int nextY = (int)((int64_t)height * (row + 1) / count);
+
+        y = std::min(y, height - 1);
+        nextY = std::max(nextY, y + 1);
+
+        QImage strip = source_->readRows(y, nextY - y);
+
+        if(strip.isNull() == true)
+        {
+            failed_ = 1;
+            break;
+        }
+
+        std::vector<QImage> tiles(count);
+
+        processRow(depth_, row, tiles, &strip);
+    }
+
+    pendingTiles_.clear();
+
+    if(failed_ != 0)
+    {
+        put_flog(LOG_ERROR, "failed to build image pyramid %s", imagePyramidPath_.c_str());
+
+        containerWriter_.reset();
+        return false;
+    }
+
+    if(containerWriter_ != NULL)
+    {
+        bool success = containerWriter_->close();
+        containerWriter_.reset();
+
+        if(success != true)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        writeImagePyramidMetadata(imagePyramidPath_, width, height);
+    }
+
+    statistics_.sourcePixels = (int64_t)width * height;
+    statistics_.tiles = tileCount_;
+    statistics_.depth = depth_;
+    statistics_.seconds = (double)time.elapsed() / 1000.;
+    statistics_.megapixelsPerSecond = statistics_.seconds > 0. ? (double)statistics_.sourcePixels / 1000000. / statistics_.seconds : 0.;
+
+    put_flog(LOG_INFO, "wrote %i tiles in %f seconds, %f megapixels/second", statistics_.tiles, statistics_.seconds, statistics_.megapixelsPerSecond);
+
+    return true;
+}
+
+ImagePyramidBuilderStatistics ImagePyramidBuilder::getStatistics()
+{
+    return statistics_;
+}
+
+int ImagePyramidBuilder::getDepth(int width, int height)
+{
+    // same criteria as DynamicTexture uses to descend the tree
+    int depth = 0;
+
+    while(width / pow(2,depth) > IMAGE_PYRAMID_TILE_SIZE || height / pow(2,depth) > IMAGE_PYRAMID_TILE_SIZE)
+    {
+        depth++;
+    }
+
+    return depth;
+}
+
+std::string ImagePyramidBuilder::getTileFilename(int depth, int column, int row)
+{
+    // the root's path is 0; child indices are 0 = top left, 1 = top right, 2 = bottom right, 3 = bottom left
+    std::string filename = "0";
+
+    for(int i=depth-1; i>=0; i--)
+    {
+        int x = (column >> i) & 1;
+        int y = (row >> i) & 1;
+
+        int childIndex = (y == 0) ? x : 3 - x;
+
+        filename += "-" + QString::number(childIndex).toStdString();
+    }
+
+    filename += ".jpg";
+
+    return filename;
+}
+
+void ImagePyramidBuilder::writeTile(int depth, int column, int row, const QImage & image)
+{
+    std::string filename = getTileFilename(depth, column, row);
+
+    JpegCompressor * compressor = JpegCompressor::getThreadCompressor();
+
+    std::vector<unsigned char> jpegBuffer(JpegCompressor::getMaxSize(image.width(), image.height(), TJSAMP_420));
+
+    int jpegSize = compressor->compress(image.bits(), image.width(), image.bytesPerLine(), image.height(), TJPF_BGRX, TJSAMP_420, jpegQuality_, 0, &jpegBuffer[0], (int)jpegBuffer.size());
+
+    if(jpegSize == 0)
+    {
+        put_flog(LOG_ERROR, "error compressing %s", filename.c_str());
+        failed_ = 1;
+        return;
+    }
+
+    if(containerWriter_ != NULL)
+    {
+        if(containerWriter_->writeTile(depth, column, row, (const char *)&jpegBuffer[0], jpegSize) != true)
+        {
+            failed_ = 1;
+            return;
+        }
+
+        tileCount_.ref();
+        return;
+    }
+
+    filename = imagePyramidPath_ + '/' + filename;
+
+    QFile file(filename.c_str());
+
+    if(file.open(QIODevice::WriteOnly) != true || file.write((const char *)&jpegBuffer[0], jpegSize) != jpegSize)
+    {
+        put_flog(LOG_ERROR, "error writing %s", filename.c_str());
+        failed_ = 1;
+        return;
+    }
+
+    tileCount_.ref();
+}
+
+void ImagePyramidBuilder::processRow(int depth, int row, std::vector<QImage> & tiles, const QImage * strip)
+{
+    int count = 1 << depth;
+
+    // allocate the parent tiles when the first of their two rows of children arrives
+    if(depth > 0 && pendingTiles_[depth-1].size() == 0)
+    {
+        for(int i=0; i<count/2; i++)
+        {
+            pendingTiles_[depth-1].push_back(QImage(IMAGE_PYRAMID_TILE_SIZE, IMAGE_PYRAMID_TILE_SIZE, QImage::Format_RGB32));
+        }
+    }
+
+    std::vector<ImagePyramidTile> rowTiles(count);
+
+    for(int i=0; i<count; i++)
+    {
+        ImagePyramidTile & tile = rowTiles[i];
+
+        tile.builder = this;
+        tile.depth = depth;
+        tile.column = i;
+        tile.row = row;
+        tile.image = &tiles[i];
+        tile.strip = strip;
+        tile.stripX = 0;
+        tile.stripWidth = 0;
+        tile.parentBits = NULL;
+        tile.parentPitch = 0;
+
+        if(strip != NULL)
+        {
+            // columns of the strip covered by this tile; every tile covers at least one column
+            int x = (int)((int64_t)strip->width() * i / count);
+            int nextX = (int)((int64_t)strip->width() * (i + 1) / count);
+
+            x = std::min(x, strip->width() - 1);
+            nextX = std::max(nextX, x + 1);
+
+            tile.stripX = x;
+            tile.stripWidth = nextX - x;
+        }
+
+        if(depth > 0)
+        {
+            // note that bits() is called here, not in the threads: it may detach the image
+            QImage & parent = pendingTiles_[depth-1][i/2];
+
+            tile.parentPitch = parent.bytesPerLine();
+            tile.parentBits = parent.bits() + (row & 1) * (IMAGE_PYRAMID_TILE_SIZE/2) * tile.parentPitch + (i & 1) * (IMAGE_PYRAMID_TILE_SIZE/2) * 4;
+        }
+    }
+
+    QtConcurrent::blockingMap(rowTiles, processImagePyramidTile);
+
+    // the parent row is complete after its second row of children
+    if(depth > 0 && (row & 1) == 1 && failed_ == 0)
+    {
+        processRow(depth-1, row/2, pendingTiles_[depth-1], NULL);
+
+        pendingTiles_[depth-1].clear();
+    }
+}
+
+void processImagePyramidTile(ImagePyramidTile & tile)
+{
+    // leaf tiles are scaled from the source strip
+    if(tile.strip != NULL)
+    {
+        *tile.image = tile.strip->copy(tile.stripX, 0, tile.stripWidth, tile.strip->height()).scaled(IMAGE_PYRAMID_TILE_SIZE, IMAGE_PYRAMID_TILE_SIZE, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        if(tile.image->format() != QImage::Format_RGB32)
+        {
+            *tile.image = tile.image->convertToFormat(QImage::Format_RGB32);
+        }
+    }
+
+    tile.builder->writeTile(tile.depth, tile.column, tile.row, *tile.image);
+
+    if(tile.parentBits != NULL)
+    {
+        reduceImagePyramidTile(*tile.image, tile.parentBits, tile.parentPitch);
+    }
+
+    // the tile is no longer needed
+    *tile.image = QImage();
+}
+
+void reduceImagePyramidTile(const QImage & image, uchar * destination, int pitch)
+{
+    for(int y=0; y<IMAGE_PYRAMID_TILE_SIZE/2; y++)
+    {
+        const uchar * row0 = image.scanLine(2*y);
+        const uchar * row1 = image.scanLine(2*y + 1);
+
+        uchar * out = destination + y * pitch;
+
+        for(int x=0; x<IMAGE_PYRAMID_TILE_SIZE/2; x++)
+        {
+            for(int c=0; c<4; c++)
+            {
+                out[4*x + c] = (uchar)((row0[8*x + c] + row0[8*x + 4 + c] + row1[8*x + c] + row1[8*x + 4 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void writeImagePyramidMetadata(std::string imagePyramidPath, int imageWidth, int imageHeight)
+{
+    // write metadata file
+    std::string metadataFilename = imagePyramidPath + "/pyramid.pyr";
+
+    std::ofstream ofs(metadataFilename.c_str());
+    ofs << "\"" << imagePyramidPath << "\" " << imageWidth << " " << imageHeight;
+
+    // write a more conveniently named metadata file in the same directory as the original image, if possible
+    // path ends with ".pyramid"; the new metadata file will end with ".pyr"
+    QString secondMetadataFilename = QString(imagePyramidPath.c_str());
+    int amidLastIndex = secondMetadataFilename.lastIndexOf("amid");
+
+    if(amidLastIndex == -1)
+    {
+        return;
+    }
+
+    secondMetadataFilename.truncate(amidLastIndex);
+
+    std::ofstream secondOfs(secondMetadataFilename.toStdString().c_str());
+
+    if(secondOfs.good() == true)
+    {
+        secondOfs << "\"" << imagePyramidPath << "\" " << imageWidth << " " << imageHeight;
+    }
+    else
+    {
+        put_flog(LOG_WARN, "could not write second metadata file %s", secondMetadataFilename.toStdString().c_str());
+    }
+}
@@ -0,0 +1,149 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef IMAGE_PYRAMID_BUILDER_H
+#define IMAGE_PYRAMID_BUILDER_H
+
+// tile dimensions; must match TEXTURE_SIZE in DynamicTexture.h
+#define IMAGE_PYRAMID_TILE_SIZE 512
+
+#define IMAGE_PYRAMID_JPEG_QUALITY 75
+
+#include "ImagePyramidSource.h"
+#include "ImagePyramidContainer.h"
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+struct ImagePyramidBuilderStatistics {
+
+    int64_t sourcePixels;
+    int tiles;
+
+    // tree depth of the leaf tiles
+    int depth;
+
+    double seconds;
+    double megapixelsPerSecond;
+};
+
+class ImagePyramidBuilder;
+
+// a tile of a row being processed in parallel
+struct ImagePyramidTile {
+
+    ImagePyramidBuilder * builder;
+
+    int depth;
+    int column;
+    int row;
+
+    // the tile, or for leaves, the region of the strip to scale it from
+    QImage * image;
+    const QImage * strip;
+    int stripX;
+    int stripWidth;
+
+    // quadrant of the parent tile to reduce the tile into, or NULL for the root
+    uchar * parentBits;
+    int parentPitch;
+};
+
+// builds an image pyramid, as read by DynamicTexture, from a source image
+// the source is streamed in strips of rows, one row of leaf tiles at a time. each level is built bottom-up
+// by 2x2 box reduction of the level below, and the tiles of a row are scaled, reduced, and written in parallel
+// on the global thread pool. peak memory is one strip plus one row of tiles for each level: it grows with the
+// image width, but not with its height
+class ImagePyramidBuilder {
+
+    public:
+
+        ImagePyramidBuilder(boost::shared_ptr<ImagePyramidSource> source);
+
+        void setJpegQuality(int quality);
+
+        // writes the tiles and a pyramid.pyr metadata file to imagePyramidPath, which is created if necessary
+        // if imagePyramidPath ends with ".pyramid" (or ".pyramid/"), a second metadata file ending with ".pyr" is written next to it
+        // if imagePyramidPath ends with ".pyrc", a single-file container is written instead
+        bool build(std::string imagePyramidPath);
+
+        ImagePyramidBuilderStatistics getStatistics();
+
+        // tree depth of the leaf tiles for an image of the given dimensions
+        static int getDepth(int width, int height);
+
+        // filename of a tile: the path through the tree, e.g. "0-1-3.jpg"
+        static std::string getTileFilename(int depth, int column, int row);
+
+        void writeTile(int depth, int column, int row, const QImage & image); // thread needs access to this method
+
+    private:
+
+        boost::shared_ptr<ImagePyramidSource> source_;
+        int jpegQuality_;
+
+        std::string imagePyramidPath_;
+        int depth_;
+
+        // set when writing a container
+        boost::shared_ptr<ImagePyramidContainerWriter> containerWriter_;
+
+        // tiles of each level above the leaves, assembled from two rows of child tiles
+        std::vector<std::vector<QImage> > pendingTiles_;
+
+        QAtomicInt tileCount_;
+        QAtomicInt failed_;
+
+        ImagePyramidBuilderStatistics statistics_;
+
+        // scale, reduce, and write a row of tiles; then the row of parent tiles, if complete
+        // for leaves, the tiles are scaled from strip; otherwise tiles holds the row
+        void processRow(int depth, int row, std::vector<QImage> & tiles, const QImage * strip);
+};
+
+extern void processImagePyramidTile(ImagePyramidTile & tile);
+
+// writes the pyramid.pyr metadata file of the directory imagePyramidPath, and the second metadata file next to it
+extern void writeImagePyramidMetadata(std::string imagePyramidPath, int imageWidth, int imageHeight);
+
+// averages each 2x2 block of an IMAGE_PYRAMID_TILE_SIZE square Format_RGB32 image into destination, with the given pitch in bytes
+extern void reduceImagePyramidTile(const QImage & image, uchar * destination, int pitch);
+
+#endif
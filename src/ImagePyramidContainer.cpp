@@ -0,0 +1,518 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidContainer.h"
+#include "ImagePyramidBuilder.h"
+#include "log.h"
+#include <QtEndian>
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/tokenizer.hpp>
+
+int64_t getIndexSize(int depth)
+{
+    return ImagePyramidContainer::getIndexEntry(depth + 1, 0, 0);
+}
+
+bool readFully(int fd, char * buffer, int64_t length, int64_t offset)
+{
+    while(length > 0)
+    {
+        ssize_t count = pread(fd, buffer, length, offset);
+
+        if(count <= 0)
+        {
+            return false;
+        }
+
+        buffer += count;
+        length -= count;
+        offset += count;
+    }
+
+    return true;
+}
+
+bool writeFully(int fd, const char * buffer, int64_t length, int64_t offset)
+{
+    while(length > 0)
+    {
+        ssize_t count = pwrite(fd, buffer, length, offset);
+
+        if(count <= 0)
+        {
+            return false;
+        }
+
+        buffer += count;
+        length -= count;
+        offset += count;
+    }
+
+    return true;
+}
+
+ImagePyramidContainer::ImagePyramidContainer()
+{
+    fd_ = -1;
+    imageWidth_ = 0;
+    imageHeight_ = 0;
+    tileSize_ = 0;
+    depth_ = 0;
+}
+
+ImagePyramidContainer::~ImagePyramidContainer()
+{
+    if(fd_ != -1)
+    {
+        ::close(fd_);
+    }
+}
+
+bool ImagePyramidContainer::open(std::string filename)
+{
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+
+    if(fd_ == -1)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return false;
+    }
+
+    char header[IMAGE_PYRAMID_CONTAINER_HEADER_SIZE];
+
+    if(readFully(fd_, header, IMAGE_PYRAMID_CONTAINER_HEADER_SIZE, 0) != true || memcmp(header, IMAGE_PYRAMID_CONTAINER_MAGIC, 8) != 0)
+    {
+        put_flog(LOG_ERROR, "%s is not an image pyramid container", filename.c_str());
+        return false;
+    }
+
+    const uchar * fields = (const uchar *)header + 8;
+
+    int version = qFromLittleEndian<quint32>(fields);
+
+    if(version != IMAGE_PYRAMID_CONTAINER_VERSION)
+    {
+        put_flog(LOG_ERROR, "unsupported image pyramid container version %i in %s", version, filename.c_str());
+        return false;
+    }
+
+    tileSize_ = qFromLittleEndian<quint32>(fields + 4);
+    imageWidth_ = qFromLittleEndian<quint32>(fields + 8);
+    imageHeight_ = qFromLittleEndian<quint32>(fields + 12);
+    depth_ = qFromLittleEndian<quint32>(fields + 16);
+
+    uint64_t indexOffset = qFromLittleEndian<quint64>(fields + 24);
+
+    // validate the header before trusting it for any allocation
+    if(tileSize_ != IMAGE_PYRAMID_TILE_SIZE)
+    {
+        put_flog(LOG_ERROR, "unsupported tile size %i in %s", tileSize_, filename.c_str());
+        return false;
+    }
+
+    if(imageWidth_ <= 0 || imageHeight_ <= 0 || depth_ < 0 || depth_ > IMAGE_PYRAMID_CONTAINER_MAX_DEPTH || depth_ != ImagePyramidBuilder::getDepth(imageWidth_, imageHeight_))
+    {
+        put_flog(LOG_ERROR, "invalid dimensions %i x %i or depth %i in %s", imageWidth_, imageHeight_, depth_, filename.c_str());
+        return false;
+    }
+
+    int64_t entries = getIndexSize(depth_);
+
+    // the index must be within the file, e.g. not truncated
+    struct stat fileStat;
+
+    if(fstat(fd_, &fileStat) != 0 || indexOffset > (uint64_t)fileStat.st_size || (uint64_t)entries * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE > (uint64_t)fileStat.st_size - indexOffset)
+    {
+        put_flog(LOG_ERROR, "index of %s is beyond the end of the file", filename.c_str());
+        return false;
+    }
+
+    // read the whole index at once
+
+    std::vector<char> index(entries * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE);
+
+    if(readFully(fd_, &index[0], index.size(), indexOffset) != true)
+    {
+        put_flog(LOG_ERROR, "could not read index of %s", filename.c_str());
+        return false;
+    }
+
+    tileOffsets_.resize(entries);
+    tileLengths_.resize(entries);
+
+    for(int64_t i=0; i<entries; i++)
+    {
+        const uchar * entry = (const uchar *)&index[i * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE];
+
+        tileOffsets_[i] = qFromLittleEndian<quint64>(entry);
+        tileLengths_[i] = qFromLittleEndian<quint32>(entry + 8);
+
+        // every tile must be within the file, so a corrupt or truncated index can't cause huge allocations or reads
+        if(tileLengths_[i] > IMAGE_PYRAMID_CONTAINER_MAX_TILE_LENGTH || tileOffsets_[i] > (uint64_t)fileStat.st_size || tileLengths_[i] > (uint64_t)fileStat.st_size - tileOffsets_[i])
+        {
+            put_flog(LOG_ERROR, "index entry %li of %s (offset %lu, length %u) is invalid", (long)i, filename.c_str(), (unsigned long)tileOffsets_[i], tileLengths_[i]);
+
+            // readTile() refuses to read from a closed container
+            ::close(fd_);
+            fd_ = -1;
+
+            return false;
+        }
+    }
+
+    put_flog(LOG_DEBUG, "opened image pyramid container %s, imageWidth = %i, imageHeight = %i, depth = %i", filename.c_str(), imageWidth_, imageHeight_, depth_);
+
+    return true;
+}
+
+int ImagePyramidContainer::getImageWidth()
+{
+    return imageWidth_;
+}
+
+int ImagePyramidContainer::getImageHeight()
+{
+    return imageHeight_;
+}
+
+int ImagePyramidContainer::getTileSize()
+{
+    return tileSize_;
+}
+
+int ImagePyramidContainer::getDepth()
+{
+    return depth_;
+}
+
+QByteArray ImagePyramidContainer::readTile(int level, int column, int row)
+{
+    if(fd_ == -1 || level < 0 || level > depth_ || column < 0 || column >= (1 << level) || row < 0 || row >= (1 << level))
+    {
+        put_flog(LOG_ERROR, "invalid tile %i, %i, %i", level, column, row);
+        return QByteArray();
+    }
+
+    int64_t entry = getIndexEntry(level, column, row);
+
+    QByteArray tile(tileLengths_[entry], 0);
+
+    if(tile.size() > 0 && readFully(fd_, tile.data(), tile.size(), tileOffsets_[entry]) != true)
+    {
+        put_flog(LOG_ERROR, "could not read tile %i, %i, %i", level, column, row);
+        return QByteArray();
+    }
+
+    return tile;
+}
+
+bool ImagePyramidContainer::isContainer(std::string filename)
+{
+    char magic[8];
+
+    std::ifstream ifs(filename.c_str(), std::ios::binary);
+
+    return ifs.read(magic, 8).good() == true && memcmp(magic, IMAGE_PYRAMID_CONTAINER_MAGIC, 8) == 0;
+}
+
+int64_t ImagePyramidContainer::getIndexEntry(int level, int column, int row)
+{
+    // entries of the levels above: (4^level - 1) / 3
+    int64_t levelOffset = (((int64_t)1 << (2 * level)) - 1) / 3;
+
+    return levelOffset + (int64_t)row * ((int64_t)1 << level) + column;
+}
+
+void ImagePyramidContainer::getTileCoordinates(const std::vector<int> & treePath, int &level, int &column, int &row)
+{
+    level = 0;
+    column = 0;
+    row = 0;
+
+    // the first element is the root
+    for(unsigned int i=1; i<treePath.size(); i++)
+    {
+        level++;
+        column = 2 * column + ((treePath[i] == 1 || treePath[i] == 2) ? 1 : 0);
+        row = 2 * row + ((treePath[i] == 2 || treePath[i] == 3) ? 1 : 0);
+    }
+}
+
+ImagePyramidContainerWriter::ImagePyramidContainerWriter()
+{
+    fd_ = -1;
+    imageWidth_ = 0;
+    imageHeight_ = 0;
+    tileSize_ = 0;
+    depth_ = 0;
+    endOffset_ = 0;
+}
+
+ImagePyramidContainerWriter::~ImagePyramidContainerWriter()
+{
+    if(fd_ != -1)
+    {
+        ::close(fd_);
+    }
+}
+
+bool ImagePyramidContainerWriter::open(std::string filename, int imageWidth, int imageHeight, int tileSize, int depth)
+{
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if(fd_ == -1)
+    {
+        put_flog(LOG_ERROR, "could not create %s", filename.c_str());
+        return false;
+    }
+
+    imageWidth_ = imageWidth;
+    imageHeight_ = imageHeight;
+    tileSize_ = tileSize;
+    depth_ = depth;
+
+    int64_t entries = getIndexSize(depth_);
+
+    tileOffsets_.assign(entries, 0);
+    tileLengths_.assign(entries, 0);
+
+    // tiles follow the header and index, which are written by close()
+    endOffset_ = IMAGE_PYRAMID_CONTAINER_HEADER_SIZE + entries * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE;
+
+    return true;
+}
+
+bool ImagePyramidContainerWriter::writeTile(int level, int column, int row, const char * data, int length)
+{
+    uint64_t offset;
+    int64_t entry = ImagePyramidContainer::getIndexEntry(level, column, row);
+
+    // reserve space for the tile; the write itself can happen in parallel
+    {
+        QMutexLocker locker(&mutex_);
+
+        if(fd_ == -1 || level < 0 || level > depth_ || column < 0 || column >= (1 << level) || row < 0 || row >= (1 << level))
+        {
+            put_flog(LOG_ERROR, "invalid tile %i, %i, %i", level, column, row);
+            return false;
+        }
+
+        offset = endOffset_;
+        endOffset_ += length;
+    }
+
+    if(writeFully(fd_, data, length, offset) != true)
+    {
+        put_flog(LOG_ERROR, "could not write tile %i, %i, %i", level, column, row);
+        return false;
+    }
+
+    QMutexLocker locker(&mutex_);
+
+    tileOffsets_[entry] = offset;
+    tileLengths_[entry] = length;
+
+    return true;
+}
+
+bool ImagePyramidContainerWriter::close()
+{
+    QMutexLocker locker(&mutex_);
+
+    if(fd_ == -1)
+    {
+        return false;
+    }
+
+    int64_t entries = tileOffsets_.size();
+
+    // header, immediately followed by the index
+    std::vector<char> buffer(IMAGE_PYRAMID_CONTAINER_HEADER_SIZE + entries * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE, 0);
+
+    uchar * fields = (uchar *)&buffer[0];
+
+    memcpy(fields, IMAGE_PYRAMID_CONTAINER_MAGIC, 8);
+    qToLittleEndian<quint32>(IMAGE_PYRAMID_CONTAINER_VERSION, fields + 8);
+    qToLittleEndian<quint32>(tileSize_, fields + 12);
+    qToLittleEndian<quint32>(imageWidth_, fields + 16);
+    qToLittleEndian<quint32>(imageHeight_, fields + 20);
+    qToLittleEndian<quint32>(depth_, fields + 24);
+    qToLittleEndian<quint64>(IMAGE_PYRAMID_CONTAINER_HEADER_SIZE, fields + 32);
+
+    for(int64_t i=0; i<entries; i++)
+    {
+        uchar * entry = fields + IMAGE_PYRAMID_CONTAINER_HEADER_SIZE + i * IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE;
+
+        qToLittleEndian<quint64>(tileOffsets_[i], entry);
+        qToLittleEndian<quint32>(tileLengths_[i], entry + 8);
+    }
+
+    bool success = writeFully(fd_, &buffer[0], buffer.size(), 0);
+
+    if(::close(fd_) != 0)
+    {
+        success = false;
+    }
+
+    fd_ = -1;
+
+    if(success != true)
+    {
+        put_flog(LOG_ERROR, "could not write image pyramid container index");
+    }
+
+    return success;
+}
+
+bool convertImagePyramid(std::string inputFilename, std::string outputPath)
+{
+    if(ImagePyramidContainer::isContainer(inputFilename) == true)
+    {
+        // container to directory
+        ImagePyramidContainer container;
+
+        if(container.open(inputFilename) != true)
+        {
+            return false;
+        }
+
+        if(QDir().mkpath(outputPath.c_str()) != true)
+        {
+            put_flog(LOG_ERROR, "error creating directory %s", outputPath.c_str());
+            return false;
+        }
+
+        for(int level=0; level<=container.getDepth(); level++)
+        {
+            for(int row=0; row<(1 << level); row++)
+            {
+                for(int column=0; column<(1 << level); column++)
+                {
+                    QByteArray tile = container.readTile(level, column, row);
+
+                    if(tile.size() == 0)
+                    {
+                        continue;
+                    }
+
+                    std::string filename = outputPath + '/' + ImagePyramidBuilder::getTileFilename(level, column, row);
+
+                    QFile file(filename.c_str());
+
+                    if(file.open(QIODevice::WriteOnly) != true || file.write(tile) != tile.size())
+                    {
+                        put_flog(LOG_ERROR, "error writing %s", filename.c_str());
+                        return false;
+                    }
+                }
+            }
+        }
+
+        writeImagePyramidMetadata(outputPath, container.getImageWidth(), container.getImageHeight());
+
+        return true;
+    }
+
+    // directory to container: the metadata file holds the directory and image dimensions
+    std::ifstream ifs(inputFilename.c_str());
+
+    std::string lineString;
+    getline(ifs, lineString);
+
+    std::string separator1("\\"); // allow escaped characters
+    std::string separator2(" "); // split on spaces
+    std::string separator3("\"\'"); // allow quoted arguments
+
+    boost::escaped_list_separator<char> els(separator1, separator2, separator3);
+    boost::tokenizer<boost::escaped_list_separator<char> > tok(lineString, els);
+
+    std::vector<std::string> tokVector;
+    tokVector.assign(tok.begin(), tok.end());
+
+    if(tokVector.size() < 3)
+    {
+        put_flog(LOG_ERROR, "require 3 arguments, got %i", tokVector.size());
+        return false;
+    }
+
+    std::string imagePyramidPath = tokVector[0];
+    int imageWidth = atoi(tokVector[1].c_str());
+    int imageHeight = atoi(tokVector[2].c_str());
+
+    int depth = ImagePyramidBuilder::getDepth(imageWidth, imageHeight);
+
+    ImagePyramidContainerWriter writer;
+
+    if(writer.open(outputPath, imageWidth, imageHeight, IMAGE_PYRAMID_TILE_SIZE, depth) != true)
+    {
+        return false;
+    }
+
+    for(int level=0; level<=depth; level++)
+    {
+        for(int row=0; row<(1 << level); row++)
+        {
+            for(int column=0; column<(1 << level); column++)
+            {
+                std::string filename = imagePyramidPath + '/' + ImagePyramidBuilder::getTileFilename(level, column, row);
+
+                QFile file(filename.c_str());
+
+                if(file.open(QIODevice::ReadOnly) != true)
+                {
+                    put_flog(LOG_WARN, "missing tile %s", filename.c_str());
+                    continue;
+                }
+
+                QByteArray tile = file.readAll();
+
+                if(writer.writeTile(level, column, row, tile.constData(), tile.size()) != true)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return writer.close();
+}
@@ -0,0 +1,151 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef IMAGE_PYRAMID_CONTAINER_H
+#define IMAGE_PYRAMID_CONTAINER_H
+
+// single-file image pyramid (.pyrc), all integers little-endian:
+//
+// header, IMAGE_PYRAMID_CONTAINER_HEADER_SIZE bytes:
+//   char[8] magic (IMAGE_PYRAMID_CONTAINER_MAGIC), uint32 version, uint32 tile size,
+//   uint32 image width, uint32 image height, uint32 depth of the leaf tiles, uint32 reserved, uint64 index offset
+// index, one entry of IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE bytes per tile:
+//   uint64 offset, uint32 length (0 for a missing tile), uint32 reserved
+//   ordered by level, then row, then column: the entry of (level, column, row) is ((4^level - 1) / 3) + row * 2^level + column
+// tile payloads: JPEG images, in any order
+#define IMAGE_PYRAMID_CONTAINER_MAGIC "DCPYRC\r\n"
+#define IMAGE_PYRAMID_CONTAINER_VERSION 1
+#define IMAGE_PYRAMID_CONTAINER_HEADER_SIZE 40
+#define IMAGE_PYRAMID_CONTAINER_INDEX_ENTRY_SIZE 16
+
+// limits the index size when opening a container; depth 16 covers 33 million pixels per side
+#define IMAGE_PYRAMID_CONTAINER_MAX_DEPTH 16
+
+// limits the allocation when reading a tile; a JPEG tile is far smaller than this
+#define IMAGE_PYRAMID_CONTAINER_MAX_TILE_LENGTH (16 * 1024 * 1024)
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// read access to a .pyrc file
+// the header and index are read once; tiles are read with pread(), so any number of threads can read tiles concurrently
+class ImagePyramidContainer {
+
+    public:
+
+        ImagePyramidContainer();
+        ~ImagePyramidContainer();
+
+        bool open(std::string filename);
+
+        int getImageWidth();
+        int getImageHeight();
+        int getTileSize();
+
+        // depth of the leaf tiles; levels are 0 (the root) to getDepth()
+        int getDepth();
+
+        // returns the compressed tile, or an empty array if the tile is missing or cannot be read
+        QByteArray readTile(int level, int column, int row);
+
+        // whether filename starts with IMAGE_PYRAMID_CONTAINER_MAGIC
+        static bool isContainer(std::string filename);
+
+        // the index entry of a tile
+        static int64_t getIndexEntry(int level, int column, int row);
+
+        // level, column, and row of the tile for a DynamicTexture tree path (0, child index, child index, ...)
+        // child indices are 0 = top left, 1 = top right, 2 = bottom right, 3 = bottom left
+        static void getTileCoordinates(const std::vector<int> & treePath, int &level, int &column, int &row);
+
+    private:
+
+        int fd_;
+
+        int imageWidth_;
+        int imageHeight_;
+        int tileSize_;
+        int depth_;
+
+        // offset and length of each tile
+        std::vector<uint64_t> tileOffsets_;
+        std::vector<uint32_t> tileLengths_;
+};
+
+// writes a .pyrc file; tiles can be written from any number of threads, in any order
+class ImagePyramidContainerWriter {
+
+    public:
+
+        ImagePyramidContainerWriter();
+        ~ImagePyramidContainerWriter();
+
+        bool open(std::string filename, int imageWidth, int imageHeight, int tileSize, int depth);
+
+        bool writeTile(int level, int column, int row, const char * data, int length);
+
+        // writes the header and index
+        bool close();
+
+    private:
+
+        QMutex mutex_;
+
+        int fd_;
+
+        int imageWidth_;
+        int imageHeight_;
+        int tileSize_;
+        int depth_;
+
+        // end of the file, where the next tile is written
+        uint64_t endOffset_;
+
+        std::vector<uint64_t> tileOffsets_;
+        std::vector<uint32_t> tileLengths_;
+};
+
+// converts between the directory layout (a .pyr metadata file pointing at a directory of JPEG files) and a .pyrc file
+// the direction is determined by the input: a .pyrc file is converted to a directory at outputPath, with its metadata files,
+// and a .pyr metadata file is converted to a .pyrc file at outputPath
+extern bool convertImagePyramid(std::string inputFilename, std::string outputPath);
+
+#endif
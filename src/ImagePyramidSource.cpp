@@ -0,0 +1,349 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "ImagePyramidSource.h"
+#include "log.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+
+ImageReaderPyramidSource::ImageReaderPyramidSource(std::string filename)
+{
+    filename_ = filename;
+    imageRead_ = false;
+
+    QImageReader imageReader(filename_.c_str());
+    size_ = imageReader.size();
+    supportsClipRect_ = imageReader.supportsOption(QImageIOHandler::ClipRect);
+
+    if(size_.isValid() != true)
+    {
+        put_flog(LOG_ERROR, "could not read size of %s", filename_.c_str());
+        size_ = QSize(0,0);
+    }
+
+    // memory use is then proportional to the whole image, not to a strip
+    if(supportsClipRect_ != true)
+    {
+        int64_t megabytes = (int64_t)size_.width() * (int64_t)size_.height() * 4 / (1024 * 1024);
+
+        put_flog(LOG_WARN, "%s doesn't support clipped reads, decoding the whole image at once (about %li MB); convert it to JPEG or binary PPM to build in bounded memory", filename_.c_str(), (long)megabytes);
+    }
+}
+
+int ImageReaderPyramidSource::getWidth()
+{
+    return size_.width();
+}
+
+int ImageReaderPyramidSource::getHeight()
+{
+    return size_.height();
+}
+
+QImage ImageReaderPyramidSource::readRows(int y, int height)
+{
+    if(supportsClipRect_ != true)
+    {
+        // otherwise the handler would decode the whole image for every strip
+        if(imageRead_ != true)
+        {
+            QImageReader imageReader(filename_.c_str());
+            image_ = imageReader.read();
+            imageRead_ = true;
+
+            if(image_.isNull() == true)
+            {
+                put_flog(LOG_ERROR, "error reading %s: %s", filename_.c_str(), imageReader.errorString().toStdString().c_str());
+            }
+            else if(image_.format() != QImage::Format_RGB32)
+            {
+                image_ = image_.convertToFormat(QImage::Format_RGB32);
+            }
+        }
+
+        if(image_.isNull() == true)
+        {
+            return QImage();
+        }
+
+        QImage image = image_.copy(0, y, size_.width(), height);
+
+        // free the image after the last strip
+        if(y + height >= size_.height())
+        {
+            image_ = QImage();
+        }
+
+        return image;
+    }
+
+    // a QImageReader can only read once
+    QImageReader imageReader(filename_.c_str());
+    imageReader.setClipRect(QRect(0, y, size_.width(), height));
+
+    QImage image = imageReader.read();
+
+    if(image.isNull() == true)
+    {
+        put_flog(LOG_ERROR, "error reading rows %i - %i of %s: %s", y, y + height, filename_.c_str(), imageReader.errorString().toStdString().c_str());
+        return image;
+    }
+
+    // some image handlers ignore the clip rectangle
+    if(image.height() != height)
+    {
+        image = image.copy(0, y, size_.width(), height);
+    }
+
+    if(image.format() != QImage::Format_RGB32)
+    {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    return image;
+}
+
+PPMPyramidSource::PPMPyramidSource(std::string filename)
+{
+    width_ = 0;
+    height_ = 0;
+    nextRow_ = 0;
+
+    file_ = fopen(filename.c_str(), "rb");
+
+    if(file_ == NULL)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return;
+    }
+
+    int maxValue = 0;
+
+    // header: magic number, width, height, and maximum value, separated by whitespace, with optional comments
+    char magic[3] = { 0, 0, 0 };
+    int values[3];
+
+    if(fread(magic, 1, 2, file_) != 2 || magic[0] != 'P' || magic[1] != '6')
+    {
+        put_flog(LOG_ERROR, "%s is not a binary PPM file", filename.c_str());
+        return;
+    }
+
+    for(int i=0; i<3; i++)
+    {
+        int c = fgetc(file_);
+
+        while(c == '#' || isspace(c))
+        {
+            if(c == '#')
+            {
+                while(c != '\n' && c != EOF)
+                {
+                    c = fgetc(file_);
+                }
+            }
+
+            c = fgetc(file_);
+        }
+
+        ungetc(c, file_);
+
+        if(fscanf(file_, "%d", &values[i]) != 1)
+        {
+            put_flog(LOG_ERROR, "invalid PPM header in %s", filename.c_str());
+            return;
+        }
+    }
+
+    maxValue = values[2];
+
+    // a single whitespace character precedes the pixel data
+    fgetc(file_);
+
+    if(maxValue != 255)
+    {
+        put_flog(LOG_ERROR, "unsupported PPM maximum value %i in %s", maxValue, filename.c_str());
+        return;
+    }
+
+    width_ = values[0];
+    height_ = values[1];
+}
+
+PPMPyramidSource::~PPMPyramidSource()
+{
+    if(file_ != NULL)
+    {
+        fclose(file_);
+    }
+}
+
+int PPMPyramidSource::getWidth()
+{
+    return width_;
+}
+
+int PPMPyramidSource::getHeight()
+{
+    return height_;
+}
+
+QImage PPMPyramidSource::readRows(int y, int height)
+{
+    if(file_ == NULL || y < nextRow_ - 1 || y + height > height_)
+    {
+        put_flog(LOG_ERROR, "invalid rows %i - %i", y, y + height);
+        return QImage();
+    }
+
+    // skip rows before the strip
+    std::vector<unsigned char> row(width_ * 3);
+
+    while(nextRow_ < y)
+    {
+        if(fread(&row[0], 1, row.size(), file_) != row.size())
+        {
+            put_flog(LOG_ERROR, "unexpected end of file");
+            return QImage();
+        }
+
+        nextRow_++;
+    }
+
+    QImage image(width_, height, QImage::Format_RGB32);
+
+    for(int i=0; i<height; i++)
+    {
+        if(y + i == nextRow_ - 1)
+        {
+            // the previous strip's last row
+            row = previousRow_;
+        }
+        else if(fread(&row[0], 1, row.size(), file_) != row.size())
+        {
+            put_flog(LOG_ERROR, "unexpected end of file");
+            return QImage();
+        }
+        else
+        {
+            nextRow_++;
+        }
+
+        QRgb * pixels = (QRgb *)image.scanLine(i);
+
+        for(int x=0; x<width_; x++)
+        {
+            pixels[x] = qRgb(row[3*x], row[3*x + 1], row[3*x + 2]);
+        }
+
+        previousRow_ = row;
+    }
+
+    return image;
+}
+
+SyntheticPyramidSource::SyntheticPyramidSource(int width, int height)
+{
+    width_ = width;
+    height_ = height;
+}
+
+int SyntheticPyramidSource::getWidth()
+{
+    return width_;
+}
+
+int SyntheticPyramidSource::getHeight()
+{
+    return height_;
+}
+
+QImage SyntheticPyramidSource::readRows(int y, int height)
+{
+    QImage image(width_, height, QImage::Format_RGB32);
+
+    // gradients with a grid every 1024 pixels, so every pyramid level has some detail
+    for(int i=0; i<height; i++)
+    {
+        int row = y + i;
+        QRgb * pixels = (QRgb *)image.scanLine(i);
+
+        for(int x=0; x<width_; x++)
+        {
+            if(x % 1024 < 8 || row % 1024 < 8)
+            {
+                pixels[x] = qRgb(255, 255, 255);
+            }
+            else
+            {
+                pixels[x] = qRgb((int)(255. * x / width_), (int)(255. * row / height_), (x ^ row) & 0xff);
+            }
+        }
+    }
+
+    return image;
+}
+
+boost::shared_ptr<ImagePyramidSource> openImagePyramidSource(std::string filename)
+{
+    boost::shared_ptr<ImagePyramidSource> source;
+
+    int width, height;
+
+    if(sscanf(filename.c_str(), "synthetic:%dx%d", &width, &height) == 2)
+    {
+        source = boost::shared_ptr<ImagePyramidSource>(new SyntheticPyramidSource(width, height));
+    }
+    else if(QString(filename.c_str()).endsWith(".ppm", Qt::CaseInsensitive) == true)
+    {
+        source = boost::shared_ptr<ImagePyramidSource>(new PPMPyramidSource(filename));
+    }
+    else
+    {
+        source = boost::shared_ptr<ImagePyramidSource>(new ImageReaderPyramidSource(filename));
+    }
+
+    if(source->getWidth() <= 0 || source->getHeight() <= 0)
+    {
+        put_flog(LOG_ERROR, "could not open %s", filename.c_str());
+        return boost::shared_ptr<ImagePyramidSource>();
+    }
+
+    return source;
+}
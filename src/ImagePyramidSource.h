@@ -0,0 +1,134 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef IMAGE_PYRAMID_SOURCE_H
+#define IMAGE_PYRAMID_SOURCE_H
+
+#include <QtGui>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+// a source image for ImagePyramidBuilder, read in strips of rows from top to bottom
+class ImagePyramidSource {
+
+    public:
+
+        virtual ~ImagePyramidSource() { }
+
+        virtual int getWidth() = 0;
+        virtual int getHeight() = 0;
+
+        // returns rows [y, y + height) as a QImage::Format_RGB32 image, or a null image on failure
+        // strips are requested in order: y never decreases, but a strip may start at the last row of the previous one
+        virtual QImage readRows(int y, int height) = 0;
+};
+
+// any format readable by QImageReader
+// formats supporting clipped reads (e.g. JPEG) read each strip with a clip rectangle; others (e.g. PNG, TIFF) are decoded
+// once, and the whole image is kept for the following strips
+// for those formats, memory use is not bounded by the strip size: the decoded image (4 bytes per pixel) is held until
+// the last strip; PPMPyramidSource is the bounded alternative for images too large for that
+class ImageReaderPyramidSource : public ImagePyramidSource {
+
+    public:
+
+        ImageReaderPyramidSource(std::string filename);
+
+        int getWidth();
+        int getHeight();
+        QImage readRows(int y, int height);
+
+    private:
+
+        std::string filename_;
+        QSize size_;
+
+        bool supportsClipRect_;
+
+        // the whole image, if clipped reads aren't supported
+        QImage image_;
+        bool imageRead_;
+};
+
+// binary PPM (P6) with a maximum value of 255, read sequentially: memory use is independent of the image height
+class PPMPyramidSource : public ImagePyramidSource {
+
+    public:
+
+        PPMPyramidSource(std::string filename);
+        ~PPMPyramidSource();
+
+        int getWidth();
+        int getHeight();
+        QImage readRows(int y, int height);
+
+    private:
+
+        FILE * file_;
+        int width_;
+        int height_;
+
+        // index of the next row in the file, and the previous row, which may be requested again
+        int nextRow_;
+        std::vector<unsigned char> previousRow_;
+};
+
+// a generated test pattern of any size, for benchmarking
+class SyntheticPyramidSource : public ImagePyramidSource {
+
+    public:
+
+        SyntheticPyramidSource(int width, int height);
+
+        int getWidth();
+        int getHeight();
+        QImage readRows(int y, int height);
+
+    private:
+
+        int width_;
+        int height_;
+};
+
+// opens filename with the most efficient source for its format
+// filenames of the form "synthetic:WIDTHxHEIGHT" give a SyntheticPyramidSource
+extern boost::shared_ptr<ImagePyramidSource> openImagePyramidSource(std::string filename);
+
+#endif
@@ -0,0 +1,92 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "JpegCompressor.h"
+#include "log.h"
+#include <QThreadStorage>
+
+QThreadStorage<JpegCompressor *> g_jpegCompressors;
+
+JpegCompressor::JpegCompressor()
+{
+    handle_ = tjInitCompress();
+}
+
+JpegCompressor::~JpegCompressor()
+{
+    tjDestroy(handle_);
+}
+
+JpegCompressor * JpegCompressor::getThreadCompressor()
+{
+    if(g_jpegCompressors.hasLocalData() != true)
+    {
+        g_jpegCompressors.setLocalData(new JpegCompressor());
+    }
+
+    return g_jpegCompressors.localData();
+}
+
+int JpegCompressor::getMaxSize(int width, int height, int subsampling)
+{
+    return (int)tjBufSize(width, height, subsampling);
+}
+
+int JpegCompressor::compress(const unsigned char * imageBuffer, int width, int pitch, int height, int tjPixelFormat, int subsampling, int quality, int flags, unsigned char * buffer, int bufferSize)
+{
+    if(bufferSize < getMaxSize(width, height, subsampling))
+    {
+        put_flog(LOG_ERROR, "buffer too small: %i < %i", bufferSize, getMaxSize(width, height, subsampling));
+
+        return 0;
+    }
+
+    // compress directly into buffer; libjpeg-turbo won't allocate anything
+    unsigned long jpegSize = 0;
+
+    int success = tjCompress2(handle_, (unsigned char *)imageBuffer, width, pitch, height, tjPixelFormat, &buffer, &jpegSize, subsampling, quality, flags | TJFLAG_NOREALLOC);
+
+    if(success != 0)
+    {
+        put_flog(LOG_ERROR, "libjpeg-turbo image conversion failure");
+
+        return 0;
+    }
+
+    return (int)jpegSize;
+}
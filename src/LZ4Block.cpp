@@ -0,0 +1,297 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "LZ4Block.h"
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+    typedef unsigned __int32 uint32_t;
+#else
+    #include <stdint.h>
+#endif
+
+// number of bits of the match finder's hash table
+#define LZ4_HASH_BITS 12
+
+// format constraints: matches are at least 4 bytes, the last 5 bytes are literals,
+// and the last match starts at least 12 bytes before the end
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+
+inline uint32_t lz4Read32(const unsigned char * p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(uint32_t));
+
+    return value;
+}
+
+inline int lz4Hash(uint32_t value)
+{
+    return (int)((value * 2654435761U) >> (32 - LZ4_HASH_BITS));
+}
+
+inline unsigned char * lz4WriteLength(unsigned char * op, int length)
+{
+    // lengths of 15 or more continue in extra bytes
+    while(length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+
+    *op++ = (unsigned char)length;
+
+    return op;
+}
+
+inline bool lz4ReadLength(const unsigned char * & ip, const unsigned char * inputEnd, size_t & length, size_t maxLength)
+{
+    // lengths of 15 or more continue in extra bytes; reject the length as soon as it exceeds maxLength, so it can't overflow
+    unsigned int b;
+
+    do
+    {
+        if(ip >= inputEnd)
+        {
+            return false;
+        }
+
+        b = *ip++;
+        length += b;
+
+        if(length > maxLength)
+        {
+            return false;
+        }
+    }
+    while(b == 255);
+
+    return true;
+}
+
+int lz4GetMaxCompressedSize(int sourceSize)
+{
+    return sourceSize + sourceSize / 255 + 16;
+}
+
+int lz4CompressBlock(const char * source, int sourceSize, char * dest, int destCapacity)
+{
+    if(sourceSize < 0 || destCapacity < lz4GetMaxCompressedSize(sourceSize))
+    {
+        return 0;
+    }
+
+    const unsigned char * src = (const unsigned char *)source;
+    const unsigned char * ip = src;
+    const unsigned char * anchor = src;
+    const unsigned char * end = src + sourceSize;
+    const unsigned char * matchLimit = end - LZ4_LAST_LITERALS;
+    const unsigned char * matchFindLimit = end - LZ4_MATCH_FIND_LIMIT;
+
+    unsigned char * op = (unsigned char *)dest;
+
+    // positions of the last occurrences of 4-byte sequences
+    int table[1 << LZ4_HASH_BITS];
+
+    for(int i=0; i<(1 << LZ4_HASH_BITS); i++)
+    {
+        table[i] = -1;
+    }
+
+    while(sourceSize > LZ4_MATCH_FIND_LIMIT && ip < matchFindLimit)
+    {
+        uint32_t sequence = lz4Read32(ip);
+        int h = lz4Hash(sequence);
+        int reference = table[h];
+        table[h] = (int)(ip - src);
+
+        if(reference < 0 || (ip - src) - reference > LZ4_MAX_OFFSET || lz4Read32(src + reference) != sequence)
+        {
+            // skip faster through data that doesn't compress
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        const unsigned char * match = src + reference;
+
+        // extend the match
+        const unsigned char * matchEnd = ip + LZ4_MIN_MATCH;
+
+        while(matchEnd < matchLimit && *matchEnd == match[matchEnd - ip])
+        {
+            matchEnd++;
+        }
+
+        int literalLength = (int)(ip - anchor);
+        int matchLength = (int)(matchEnd - ip) - LZ4_MIN_MATCH;
+
+        // token: literal length and match length
+        unsigned char * token = op++;
+
+        if(literalLength >= 15)
+        {
+            *token = 15 << 4;
+            op = lz4WriteLength(op, literalLength - 15);
+        }
+        else
+        {
+            *token = (unsigned char)(literalLength << 4);
+        }
+
+        memcpy(op, anchor, literalLength);
+        op += literalLength;
+
+        // offset, little-endian
+        int offset = (int)(ip - match);
+        *op++ = (unsigned char)(offset & 0xff);
+        *op++ = (unsigned char)(offset >> 8);
+
+        if(matchLength >= 15)
+        {
+            *token |= 15;
+            op = lz4WriteLength(op, matchLength - 15);
+        }
+        else
+        {
+            *token |= (unsigned char)matchLength;
+        }
+
+        ip = matchEnd;
+        anchor = ip;
+    }
+
+    // the last literals
+    int literalLength = (int)(end - anchor);
+
+    if(literalLength >= 15)
+    {
+        *op++ = 15 << 4;
+        op = lz4WriteLength(op, literalLength - 15);
+    }
+    else
+    {
+        *op++ = (unsigned char)(literalLength << 4);
+    }
+
+    memcpy(op, anchor, literalLength);
+    op += literalLength;
+
+    return (int)(op - (unsigned char *)dest);
+}
+
+int lz4DecompressBlock(const char * source, int sourceSize, char * dest, int destCapacity)
+{
+    const unsigned char * ip = (const unsigned char *)source;
+    const unsigned char * inputEnd = ip + sourceSize;
+
+    unsigned char * op = (unsigned char *)dest;
+    unsigned char * outputEnd = op + destCapacity;
+
+    while(ip < inputEnd)
+    {
+        int token = *ip++;
+
+        // literals
+        size_t literalLength = token >> 4;
+        size_t maxLiteralLength = std::min((size_t)(inputEnd - ip), (size_t)(outputEnd - op));
+
+        if(literalLength == 15 && lz4ReadLength(ip, inputEnd, literalLength, maxLiteralLength) != true)
+        {
+            return -1;
+        }
+
+        if(literalLength > (size_t)(inputEnd - ip) || literalLength > (size_t)(outputEnd - op))
+        {
+            return -1;
+        }
+
+        memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        // the last sequence has no match
+        if(ip >= inputEnd)
+        {
+            break;
+        }
+
+        // match
+        if(inputEnd - ip < 2)
+        {
+            return -1;
+        }
+
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if(offset == 0 || offset > op - (unsigned char *)dest)
+        {
+            return -1;
+        }
+
+        size_t matchLength = token & 15;
+
+        if(matchLength == 15 && lz4ReadLength(ip, inputEnd, matchLength, outputEnd - op) != true)
+        {
+            return -1;
+        }
+
+        matchLength += LZ4_MIN_MATCH;
+
+        if(matchLength > (size_t)(outputEnd - op))
+        {
+            return -1;
+        }
+
+        // matches may overlap the output, so copy byte by byte
+        const unsigned char * match = op - offset;
+
+        for(size_t i=0; i<matchLength; i++)
+        {
+            op[i] = match[i];
+        }
+
+        op += matchLength;
+    }
+
+    return (int)(op - (unsigned char *)dest);
+}
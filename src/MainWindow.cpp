@@ -43,6 +43,8 @@
 #include "log.h"
 #include "DisplayGroupGraphicsViewProxy.h"
 #include "DisplayGroupListWidgetProxy.h"
+#include "FrameTimings.h"
+#include "ImagePyramidBuilder.h"
 
 #if ENABLE_PYTHON_SUPPORT
     #include "PythonConsole.h"
@@ -56,6 +58,10 @@ MainWindow::MainWindow()
 {
     // defaults
     constrainAspectRatio_ = true;
+    frameTelemetryTableWidget_ = NULL;
+
+    // the budget covers the DynamicTexture tiles of all windows of this process, since they share one texture factory
+    textureResidencyManager_.setBudget((size_t)g_configuration->getTextureResidencyBudget() * 1024 * 1024);
 
     // make application quit when last window is closed
     QObject::connect(g_app, SIGNAL(lastWindowClosed()), g_app, SLOT(quit()));
@@ -122,6 +128,11 @@ MainWindow::MainWindow()
         connect(pythonConsoleAction, SIGNAL(triggered()), PythonConsole::self(), SLOT(show()));
 #endif
 
+        // save frame timings action
+        QAction * saveFrameTimingsAction = new QAction("Save Frame Timings", this);
+        saveFrameTimingsAction->setStatusTip("Save frame timings of all render processes");
+        connect(saveFrameTimingsAction, SIGNAL(triggered()), this, SLOT(saveFrameTimings()));
+
         // quit action
         QAction * quitAction = new QAction("Quit", this);
         quitAction->setStatusTip("Quit application");
@@ -183,6 +194,13 @@ MainWindow::MainWindow()
         showStreamingStatisticsAction->setChecked(g_displayGroupManager->getOptions()->getShowStreamingStatistics());
         connect(showStreamingStatisticsAction, SIGNAL(toggled(bool)), g_displayGroupManager->getOptions().get(), SLOT(setShowStreamingStatistics(bool)));
 
+        // enable streaming YUV decoding action
+        QAction * enableStreamingYUVAction = new QAction("Enable YUV Decoding", this);
+        enableStreamingYUVAction->setStatusTip("Decode streams to YUV and convert to RGB on the GPU");
+        enableStreamingYUVAction->setCheckable(true);
+        enableStreamingYUVAction->setChecked(g_displayGroupManager->getOptions()->getEnableStreamingYUV());
+        connect(enableStreamingYUVAction, SIGNAL(toggled(bool)), g_displayGroupManager->getOptions().get(), SLOT(setEnableStreamingYUV(bool)));
+
 #if ENABLE_SKELETON_SUPPORT
         // enable skeleton tracking action
         QAction * enableSkeletonTrackingAction = new QAction("Enable Skeleton Tracking", this);
@@ -209,6 +227,7 @@ MainWindow::MainWindow()
         fileMenu->addAction(saveStateAction);
         fileMenu->addAction(loadStateAction);
         fileMenu->addAction(computeImagePyramidAction);
+        fileMenu->addAction(saveFrameTimingsAction);
         fileMenu->addAction(quitAction);
         viewMenu->addAction(constrainAspectRatioAction);
         viewMenu->addAction(showWindowBordersAction);
@@ -218,6 +237,7 @@ MainWindow::MainWindow()
         viewStreamingMenu->addAction(enableStreamingSynchronizationAction);
         viewStreamingMenu->addAction(showStreamingSegmentsAction);
         viewStreamingMenu->addAction(showStreamingStatisticsAction);
+        viewStreamingMenu->addAction(enableStreamingYUVAction);
 
 #if ENABLE_PYTHON_SUPPORT
         windowMenu->addAction(pythonConsoleAction);
@@ -258,6 +278,17 @@ MainWindow::MainWindow()
         DisplayGroupListWidgetProxy * dglwp = new DisplayGroupListWidgetProxy(g_displayGroupManager);
         contentsLayout->addWidget(dglwp->getListWidget());
 
+        // create frame telemetry dock widget: rolling frame time percentiles for each render process
+        QDockWidget * frameTelemetryDockWidget = new QDockWidget("Frame Telemetry", this);
+        frameTelemetryTableWidget_ = new QTableWidget(0, 7);
+        frameTelemetryTableWidget_->setHorizontalHeaderLabels(QStringList() << "Rank" << "Render p50 (ms)" << "Render p95 (ms)" << "Render p99 (ms)" << "Barrier p50 (ms)" << "Barrier p95 (ms)" << "Barrier p99 (ms)");
+        frameTelemetryTableWidget_->verticalHeader()->hide();
+        frameTelemetryTableWidget_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        frameTelemetryDockWidget->setWidget(frameTelemetryTableWidget_);
+        addDockWidget(Qt::LeftDockWidgetArea, frameTelemetryDockWidget);
+
+        connect(g_frameTelemetry, SIGNAL(updated()), this, SLOT(updateFrameTelemetry()));
+
         // timer will trigger polling of ParallelPixelStreams
         connect(&parallelPixelStreamTimer_, SIGNAL(timeout()), g_displayGroupManager.get(), SLOT(sendParallelPixelStreams()));
 
@@ -347,6 +378,11 @@ std::vector<boost::shared_ptr<GLWindow> > MainWindow::getGLWindows()
     return glWindows_;
 }
 
+TextureResidencyManager & MainWindow::getTextureResidencyManager()
+{
+    return textureResidencyManager_;
+}
+
 void MainWindow::openContent()
 {
     QString filename = QFileDialog::getOpenFileName(this);
@@ -444,6 +480,71 @@ void MainWindow::saveState()
     }
 }
 
+void MainWindow::saveFrameTimings()
+{
+    QString filename = QFileDialog::getSaveFileName(this, "Save Frame Timings", "", "CSV files (*.csv);;Chrome trace files (*.json)");
+
+    if(!filename.isEmpty())
+    {
+        // gather the frame timings from all render processes
+        std::map<int, std::vector<FrameTiming> > timings = g_displayGroupManager->getFrameTimings();
+
+        FrameTimings::logSummary(timings);
+
+        bool success;
+
+        if(filename.endsWith(".json") == true)
+        {
+            success = FrameTimings::writeChromeTrace(timings, filename.toStdString());
+        }
+        else
+        {
+            // make sure filename has .csv extension
+            if(filename.endsWith(".csv") != true)
+            {
+                put_flog(LOG_DEBUG, "appended .csv filename extension");
+                filename.append(".csv");
+            }
+
+            success = FrameTimings::writeCSV(timings, filename.toStdString());
+        }
+
+        if(success != true)
+        {
+            QMessageBox::warning(this, "Error", "Could not save frame timings file.", QMessageBox::Ok, QMessageBox::Ok);
+        }
+    }
+}
+
+void MainWindow::updateFrameTelemetry()
+{
+    std::vector<FrameTelemetryStatistics> statistics = g_frameTelemetry->getStatistics();
+    int stragglerRank = g_frameTelemetry->getStragglerRank();
+
+    frameTelemetryTableWidget_->setRowCount(statistics.size());
+
+    for(unsigned int i=0; i<statistics.size(); i++)
+    {
+        float values[6] = { statistics[i].renderTimeP50, statistics[i].renderTimeP95, statistics[i].renderTimeP99, statistics[i].barrierTimeP50, statistics[i].barrierTimeP95, statistics[i].barrierTimeP99 };
+
+        frameTelemetryTableWidget_->setItem(i, 0, new QTableWidgetItem(QString::number(statistics[i].rank)));
+
+        for(int j=0; j<6; j++)
+        {
+            frameTelemetryTableWidget_->setItem(i, j+1, new QTableWidgetItem(QString::number(values[j], 'f', 2)));
+        }
+
+        // highlight the rank the others are waiting on
+        if(statistics[i].rank == stragglerRank && statistics.size() > 1)
+        {
+            for(int j=0; j<7; j++)
+            {
+                frameTelemetryTableWidget_->item(i, j)->setBackground(QBrush(QColor(255, 200, 200)));
+            }
+        }
+    }
+}
+
 void MainWindow::loadState(QString *filename)
 {
         bool success = g_displayGroupManager->loadStateXMLFile(filename->toStdString());
@@ -472,8 +573,13 @@ void MainWindow::computeImagePyramid()
 
         put_flog(LOG_DEBUG, "got image pyramid path %s", imagePyramidPath.c_str());
 
-        boost::shared_ptr<DynamicTexture> dt(new DynamicTexture(imageFilename.toStdString()));
-        dt->computeImagePyramid(imagePyramidPath);
+        boost::shared_ptr<ImagePyramidSource> source = openImagePyramidSource(imageFilename.toStdString());
+
+        if(source != NULL)
+        {
+            ImagePyramidBuilder builder(source);
+            builder.build(imagePyramidPath);
+        }
 
         put_flog(LOG_DEBUG, "done");
     }
@@ -513,11 +619,17 @@ void MainWindow::setEnableSkeletonTracking(bool enable)
 
 void MainWindow::updateGLWindows()
 {
+    // record phase durations for this frame
+    g_frameTimings.beginFrame(g_frameCount);
+
     // receive any waiting messages
+    g_frameTimings.beginPhase(FRAME_PHASE_RECEIVE_MESSAGES);
     g_displayGroupManager->receiveMessages();
 
     // synchronize clock
     // do this right after receiving messages to ensure we have an accurate clock for rendering, etc. below
+    g_frameTimings.beginPhase(FRAME_PHASE_FRAME_CLOCK);
+
     if(g_mpiRank == 1)
     {
         g_displayGroupManager->sendFrameClockUpdate();
@@ -530,34 +642,51 @@ void MainWindow::updateGLWindows()
     // render all GLWindows
     for(unsigned int i=0; i<glWindows_.size(); i++)
     {
+        g_frameTimings.beginPhase(FRAME_PHASE_UPDATE_GL + i);
+
         activeGLWindow_ = glWindows_[i];
         glWindows_[i]->updateGL();
     }
 
     // all render processes render simultaneously
+    g_frameTimings.beginPhase(FRAME_PHASE_BARRIER);
     MPI_Barrier(g_mpiRenderComm);
 
     // swap buffers on all windows
+    g_frameTimings.beginPhase(FRAME_PHASE_SWAP_BUFFERS);
+
     for(unsigned int i=0; i<glWindows_.size(); i++)
     {
         glWindows_[i]->swapBuffers();
     }
 
     // advance all contents
+    g_frameTimings.beginPhase(FRAME_PHASE_ADVANCE_CONTENTS);
     g_displayGroupManager->advanceContents();
 
     // clear old factory objects and purge any textures
     if(glWindows_.size() > 0)
     {
+        g_frameTimings.beginPhase(FRAME_PHASE_CLEAR_STALE_OBJECTS);
+
         glWindows_[0]->getTextureFactory().clearStaleObjects();
         glWindows_[0]->getDynamicTextureFactory().clearStaleObjects();
         glWindows_[0]->getSVGFactory().clearStaleObjects();
         glWindows_[0]->getMovieFactory().clearStaleObjects();
         glWindows_[0]->getPixelStreamFactory().clearStaleObjects();
 
+        g_frameTimings.beginPhase(FRAME_PHASE_PURGE_TEXTURES);
+
         glWindows_[0]->purgeTextures();
     }
 
+    textureResidencyManager_.logStatistics(g_frameCount);
+
+    g_frameTimings.endFrame();
+
+    // periodically gathers frame times to rank 0
+    g_frameTelemetry->recordFrame(g_frameTimings.getLastFrame());
+
     // increment frame counter
     g_frameCount = g_frameCount + 1;
 
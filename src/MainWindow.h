@@ -44,6 +44,7 @@
 
 #include "config.h"
 #include "GLWindow.h"
+#include "TextureResidencyManager.h"
 #include <QtGui>
 #include <QGLWidget>
 #include <boost/shared_ptr.hpp>
@@ -61,6 +62,8 @@ class MainWindow : public QMainWindow {
         boost::shared_ptr<GLWindow> getActiveGLWindow();
         std::vector<boost::shared_ptr<GLWindow> > getGLWindows();
 
+        TextureResidencyManager & getTextureResidencyManager();
+
         void loadState(QString *);
 
     public slots:
@@ -71,6 +74,8 @@ class MainWindow : public QMainWindow {
         void saveState();
         void loadState();
         void computeImagePyramid();
+        void saveFrameTimings();
+        void updateFrameTelemetry();
         void constrainAspectRatio(bool set);
 
 #if ENABLE_SKELETON_SUPPORT
@@ -92,6 +97,9 @@ class MainWindow : public QMainWindow {
 
     private:
 
+        // GPU memory budget for the DynamicTexture tiles of this process; declared first so it outlives the windows and their factories
+        TextureResidencyManager textureResidencyManager_;
+
         std::vector<boost::shared_ptr<GLWindow> > glWindows_;
         boost::shared_ptr<GLWindow> activeGLWindow_;
 
@@ -99,6 +107,9 @@ class MainWindow : public QMainWindow {
 
         // polling timer for updating parallel pixel streams
         QTimer parallelPixelStreamTimer_;
+
+        // frame telemetry table (rank 0)
+        QTableWidget * frameTelemetryTableWidget_;
 };
 
 #endif
@@ -0,0 +1,121 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MessageBufferPool.h"
+
+// deleter used for the shared pointers: returns the buffer to its pool
+struct MessageBufferPoolDeleter {
+
+    MessageBufferPool * pool;
+    int sizeClass;
+
+    MessageBufferPoolDeleter(MessageBufferPool * p, int s) : pool(p), sizeClass(s) { }
+
+    void operator()(char * buffer)
+    {
+        pool->releaseBuffer(buffer, sizeClass);
+    }
+};
+
+MessageBufferPool::MessageBufferPool()
+{
+    freeBuffers_.resize(sizeof(size_t) * 8);
+}
+
+MessageBufferPool::~MessageBufferPool()
+{
+    for(unsigned int i=0; i<freeBuffers_.size(); i++)
+    {
+        for(unsigned int j=0; j<freeBuffers_[i].size(); j++)
+        {
+            delete [] freeBuffers_[i][j];
+        }
+    }
+}
+
+boost::shared_ptr<char> MessageBufferPool::getBuffer(size_t size)
+{
+    int sizeClass = getSizeClass(size);
+
+    char * buffer = NULL;
+
+    {
+        QMutexLocker locker(&mutex_);
+
+        if(freeBuffers_[sizeClass].size() > 0)
+        {
+            buffer = freeBuffers_[sizeClass].back();
+            freeBuffers_[sizeClass].pop_back();
+        }
+    }
+
+    if(buffer == NULL)
+    {
+        buffer = new char[(size_t)1 << sizeClass];
+    }
+
+    return boost::shared_ptr<char>(buffer, MessageBufferPoolDeleter(this, sizeClass));
+}
+
+void MessageBufferPool::releaseBuffer(char * buffer, int sizeClass)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(freeBuffers_[sizeClass].size() < MESSAGE_BUFFER_POOL_MAX_FREE_BUFFERS)
+    {
+        freeBuffers_[sizeClass].push_back(buffer);
+    }
+    else
+    {
+        delete [] buffer;
+    }
+}
+
+int MessageBufferPool::getSizeClass(size_t size)
+{
+    int sizeClass = MESSAGE_BUFFER_POOL_MIN_SIZE_CLASS;
+
+    while(((size_t)1 << sizeClass) < size)
+    {
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+MessageBufferPool g_messageBufferPool;
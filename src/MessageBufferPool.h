@@ -0,0 +1,81 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MESSAGE_BUFFER_POOL_H
+#define MESSAGE_BUFFER_POOL_H
+
+// buffer sizes are powers of two, starting at 2^MESSAGE_BUFFER_POOL_MIN_SIZE_CLASS bytes
+#define MESSAGE_BUFFER_POOL_MIN_SIZE_CLASS 12
+
+// number of free buffers kept for each size class; others are deleted when released
+#define MESSAGE_BUFFER_POOL_MAX_FREE_BUFFERS 4
+
+#include <QtCore>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+// a pool of receive buffers for MPI messages
+// buffers are handed out as shared pointers and are returned to the pool when the last reference is released,
+// so the payloads in a buffer can be used directly (e.g. with QByteArray::fromRawData()) without copying
+class MessageBufferPool {
+
+    public:
+
+        MessageBufferPool();
+        ~MessageBufferPool();
+
+        // get a buffer of at least size bytes
+        boost::shared_ptr<char> getBuffer(size_t size);
+
+        // return a buffer to the pool; called when the last reference to a buffer is released
+        void releaseBuffer(char * buffer, int sizeClass);
+
+    private:
+
+        QMutex mutex_;
+
+        // free buffers for each size class
+        std::vector<std::vector<char *> > freeBuffers_;
+
+        int getSizeClass(size_t size);
+};
+
+// global message buffer pool
+extern MessageBufferPool g_messageBufferPool;
+
+#endif
@@ -45,7 +45,7 @@
     #include <stdint.h>
 #endif
 
-enum MESSAGE_TYPE { MESSAGE_TYPE_CONTENTS, MESSAGE_TYPE_CONTENTS_DIMENSIONS, MESSAGE_TYPE_PIXELSTREAM, MESSAGE_TYPE_PIXELSTREAM_DIMENSIONS_CHANGED, MESSAGE_TYPE_PARALLEL_PIXELSTREAM, MESSAGE_TYPE_SVG_STREAM, MESSAGE_TYPE_FRAME_CLOCK, MESSAGE_TYPE_QUIT };
+enum MESSAGE_TYPE { MESSAGE_TYPE_CONTENTS, MESSAGE_TYPE_CONTENTS_DIMENSIONS, MESSAGE_TYPE_PIXELSTREAM, MESSAGE_TYPE_PIXELSTREAM_DIMENSIONS_CHANGED, MESSAGE_TYPE_PARALLEL_PIXELSTREAM, MESSAGE_TYPE_SVG_STREAM, MESSAGE_TYPE_FRAME_CLOCK, MESSAGE_TYPE_QUIT, MESSAGE_TYPE_CONTENTS_DELTA, MESSAGE_TYPE_FRAME_TIMINGS, MESSAGE_TYPE_PROTOCOL_UPGRADE };
 
 #define MESSAGE_HEADER_URI_LENGTH 64
 
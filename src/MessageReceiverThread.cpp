@@ -0,0 +1,145 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "MessageReceiverThread.h"
+#include "main.h"
+#include "log.h"
+#include "PixelStream.h"
+
+MessageReceiverThread * g_messageReceiverThread = NULL;
+
+MessageReceiverThread::MessageReceiverThread()
+{
+    stopping_ = 0;
+
+    // collective over the render processes
+    MPI_Comm_dup(g_mpiRenderComm, &comm_);
+}
+
+void MessageReceiverThread::run()
+{
+    while(stopping_ == 0)
+    {
+        // this waits for the next batch
+        boost::shared_ptr<MessageBatch> batch = DisplayGroupManager::receiveMessageBatch(comm_, true);
+
+        if(batch == NULL)
+        {
+            continue;
+        }
+
+        bool quit = preprocessMessageBatch(batch);
+
+        {
+            QMutexLocker locker(&readyBatchesMutex_);
+            readyBatches_.push_back(batch);
+        }
+
+        // there are no more batches after a quit message
+        if(quit == true)
+        {
+            put_flog(LOG_DEBUG, "received quit message");
+            break;
+        }
+    }
+}
+
+void MessageReceiverThread::stop()
+{
+    stopping_ = 1;
+}
+
+int MessageReceiverThread::getNumReadyBatches()
+{
+    QMutexLocker locker(&readyBatchesMutex_);
+
+    return readyBatches_.size();
+}
+
+std::vector<boost::shared_ptr<MessageBatch> > MessageReceiverThread::takeReadyBatches(int numBatches)
+{
+    QMutexLocker locker(&readyBatchesMutex_);
+
+    std::vector<boost::shared_ptr<MessageBatch> > batches;
+
+    for(int i=0; i<numBatches && readyBatches_.size() > 0; i++)
+    {
+        batches.push_back(readyBatches_.front());
+        readyBatches_.pop_front();
+    }
+
+    return batches;
+}
+
+bool MessageReceiverThread::preprocessMessageBatch(boost::shared_ptr<MessageBatch> batch)
+{
+    bool quit = false;
+
+    int offset = 0;
+
+    while(offset < batch->size)
+    {
+        MessageHeader mh;
+        memcpy((void *)&mh, (void *)(batch->messages.get() + offset), sizeof(MessageHeader));
+
+        const char * buf = batch->messages.get() + offset + sizeof(MessageHeader);
+
+        offset += sizeof(MessageHeader) + mh.size;
+
+        if(mh.type == MESSAGE_TYPE_PIXELSTREAM)
+        {
+            // pixel streams aren't synchronized across processes, so decoding can start right away
+            std::string uri = std::string(mh.uri);
+
+            g_mainWindow->getGLWindow()->getPixelStreamFactory().getObject(uri)->setImageData(QByteArray::fromRawData(buf, mh.size), batch->messages);
+        }
+        else if(mh.type == MESSAGE_TYPE_PARALLEL_PIXELSTREAM)
+        {
+            // the segments are sent in the same order as these messages
+            batch->parallelPixelStreamSegments.push_back(DisplayGroupManager::receiveParallelPixelStreamSegments(mh, buf));
+        }
+        else if(mh.type == MESSAGE_TYPE_QUIT)
+        {
+            quit = true;
+        }
+    }
+
+    batch->preprocessed = true;
+
+    return quit;
+}
@@ -0,0 +1,108 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef MESSAGE_RECEIVER_THREAD_H
+#define MESSAGE_RECEIVER_THREAD_H
+
+// time (ms) to wait for the thread to stop at shutdown
+#define MESSAGE_RECEIVER_THREAD_STOP_TIMEOUT 5000
+
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <boost/shared_ptr.hpp>
+#include <mpi.h>
+#include <deque>
+#include <vector>
+
+// a batch of messages from rank 0, as broadcast to all render processes: each message is a header followed by its payload
+struct MessageBatch {
+
+    MessageBatch() : size(0), preprocessed(false) { }
+
+    // buffer from the message buffer pool; payloads are used in place
+    boost::shared_ptr<char> messages;
+    int size;
+
+    // whether the batch was preprocessed by the message receiver thread:
+    // pixel stream decoding was started, and the parallel pixel stream segments sent directly to this process were received
+    bool preprocessed;
+
+    // received segments for each parallel pixel stream message, in order (NULL if there were none for this process)
+    std::vector<boost::shared_ptr<char> > parallelPixelStreamSegments;
+};
+
+// receives message batches for the next frames while the main thread renders the current frame (render processes)
+// this uses its own communicator and requires MPI_THREAD_MULTIPLE
+// batches are only applied by the main thread, and every render process applies the same batches in the same frame
+class MessageReceiverThread : public QThread {
+
+    public:
+
+        MessageReceiverThread();
+
+        void run();
+
+        // stop after the batch being received; the thread also stops by itself after a quit message
+        // a receive can't be interrupted, so the thread only stops once the batch arrives
+        void stop();
+
+        // number of batches received and preprocessed, ready to be applied
+        int getNumReadyBatches();
+
+        // remove and return the oldest numBatches ready batches
+        std::vector<boost::shared_ptr<MessageBatch> > takeReadyBatches(int numBatches);
+
+    private:
+
+        // communicator for broadcasting batches, separate from the one used by the main thread
+        MPI_Comm comm_;
+
+        QAtomicInt stopping_;
+
+        QMutex readyBatchesMutex_;
+        std::deque<boost::shared_ptr<MessageBatch> > readyBatches_;
+
+        // start pixel stream decoding and receive parallel pixel stream segments; returns true if the batch has a quit message
+        bool preprocessMessageBatch(boost::shared_ptr<MessageBatch> batch);
+};
+
+// the message receiver thread, or NULL if messages are received by the main thread
+extern MessageReceiverThread * g_messageReceiverThread;
+
+#endif
@@ -40,13 +40,11 @@
 #include "main.h"
 #include "log.h"
 
-Movie::Movie(std::string uri)
+Movie::Movie(std::string uri) : texture_(GL_RGBA)
 {
     initialized_ = false;
 
     // defaults
-    textureId_ = 0;
-    textureBound_ = false;
     avFormatContext_ = NULL;
     avCodecContext_ = NULL;
     swsContext_ = NULL;
@@ -132,12 +130,11 @@ Movie::Movie(std::string uri)
 
     put_flog(LOG_DEBUG, "seeking parameters: start_time = %i, duration_ = %i, num frames = %i", start_time_, duration_, num_frames_);
 
-    // create texture for movie
+    // create texture for movie; it is uploaded on the first render
     QImage image(avCodecContext_->width, avCodecContext_->height, QImage::Format_RGB32);
     image.fill(0);
 
-    textureId_ = g_mainWindow->getGLWindow()->bindTexture(image, GL_TEXTURE_2D, GL_RGBA, QGLContext::LinearFilteringBindOption);
-    textureBound_ = true;
+    texture_.setImage(image);
 
     // allocate video frame for video decoding
     avFrame_ = avcodec_alloc_frame();
@@ -167,13 +164,6 @@ Movie::Movie(std::string uri)
 
 Movie::~Movie()
 {
-    if(textureBound_ == true)
-    {
-        // delete bound texture
-        glDeleteTextures(1, &textureId_); // it appears deleteTexture() below is not actually deleting the texture from the GPU...
-        g_mainWindow->getGLWindow()->deleteTexture(textureId_);
-    }
-
     // close the format context
     avformat_close_input(&avFormatContext_);
 
@@ -200,11 +190,14 @@ void Movie::render(float tX, float tY, float tW, float tH)
         return;
     }
 
+    // upload the latest frame, if not yet uploaded
+    texture_.update();
+
     // draw the texture
     glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureId_);
+    glBindTexture(GL_TEXTURE_2D, texture_.getTextureId());
 
     // on zoom-out, clamp to edge (instead of showing the texture tiled / repeated)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -315,13 +308,26 @@ void Movie::nextFrame(bool skip)
                 // until we get to the desired timestamp (in the case that we seeked)
                 if(desiredTimestamp == 0 || (avFrame_->pkt_dts >= desiredTimestamp))
                 {
-                    // convert the frame from its native format to RGB
-                    sws_scale(swsContext_, avFrame_->data, avFrame_->linesize, 0, avCodecContext_->height, avFrameRGB_->data, avFrameRGB_->linesize);
-
-                    // put the RGB image to the already-created texture
-                    // glTexSubImage2D uses the existing texture and is more efficient than other means
-                    glBindTexture(GL_TEXTURE_2D, textureId_);
-                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, avCodecContext_->width, avCodecContext_->height, GL_RGBA, GL_UNSIGNED_BYTE, avFrameRGB_->data[0]);
+                    // convert the frame from its native format to RGB, directly into a mapped pixel buffer of the texture if possible
+                    uint8_t * pixels = (uint8_t *)texture_.beginWrite(avCodecContext_->width, avCodecContext_->height);
+
+                    if(pixels != NULL)
+                    {
+                        uint8_t * data[4] = { pixels, NULL, NULL, NULL };
+                        int linesize[4] = { avCodecContext_->width * 4, 0, 0, 0 };
+
+                        sws_scale(swsContext_, avFrame_->data, avFrame_->linesize, 0, avCodecContext_->height, data, linesize);
+
+                        texture_.endWrite(pixels, true);
+                        texture_.update();
+                    }
+                    else
+                    {
+                        sws_scale(swsContext_, avFrame_->data, avFrame_->linesize, 0, avCodecContext_->height, avFrameRGB_->data, avFrameRGB_->linesize);
+
+                        // put the RGB image to the already-created texture
+                        texture_.upload(avFrameRGB_->data[0], avCodecContext_->width, avCodecContext_->height);
+                    }
 
                     // free the packet that was allocated by av_read_frame
                     av_free_packet(&packet);
@@ -40,6 +40,7 @@
 #define MOVIE_H
 
 #include "FactoryObject.h"
+#include "StreamingTexture.h"
 #include <QGLWidget>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -84,8 +85,7 @@ class Movie : public FactoryObject {
         std::string uri_;
 
         // texture
-        GLuint textureId_;
-        bool textureBound_;
+        StreamingTexture texture_;
 
         // FFMPEG
         AVFormatContext * avFormatContext_;
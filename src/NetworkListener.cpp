@@ -37,14 +37,26 @@
 /*********************************************************************/
 
 #include "NetworkListener.h"
-#include "NetworkListenerThread.h"
+#include "NetworkListenerConnection.h"
 #include "log.h"
 
 NetworkListener::NetworkListener(int port)
 {
+    // defaults
+    nextIOThread_ = 0;
+
     // assign values
     port_ = port;
 
+    // start the I/O threads; QThread::run() just runs an event loop
+    for(int i=0; i<NETWORK_LISTENER_NUM_IO_THREADS; i++)
+    {
+        QThread * thread = new QThread();
+        thread->start();
+
+        ioThreads_.push_back(thread);
+    }
+
     if(listen(QHostAddress::Any, port_) != true)
     {
         put_flog(LOG_FATAL, "could not listen on port %i", port_);
@@ -52,11 +64,28 @@ NetworkListener::NetworkListener(int port)
     }
 }
 
+NetworkListener::~NetworkListener()
+{
+    for(unsigned int i=0; i<ioThreads_.size(); i++)
+    {
+        ioThreads_[i]->quit();
+        ioThreads_[i]->wait();
+
+        delete ioThreads_[i];
+    }
+}
+
 void NetworkListener::incomingConnection(int socketDescriptor)
 {
     put_flog(LOG_DEBUG, "");
 
-    NetworkListenerThread * thread = new NetworkListenerThread(socketDescriptor);
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-    thread->start();
+    // assign connections to the I/O threads round-robin
+    QThread * thread = ioThreads_[nextIOThread_];
+    nextIOThread_ = (nextIOThread_ + 1) % ioThreads_.size();
+
+    NetworkListenerConnection * connection = new NetworkListenerConnection(socketDescriptor);
+    connection->moveToThread(thread);
+
+    // the socket has to be created in the I/O thread
+    QMetaObject::invokeMethod(connection, "initialize", Qt::QueuedConnection);
 }
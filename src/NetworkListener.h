@@ -39,14 +39,22 @@
 #ifndef NETWORK_LISTENER_H
 #define NETWORK_LISTENER_H
 
+// number of I/O threads handling the streaming client connections
+#define NETWORK_LISTENER_NUM_IO_THREADS 4
+
 #include <QtNetwork/QTcpServer>
+#include <QThread>
+#include <vector>
 
+// accepts streaming client connections and distributes them over a fixed pool of I/O threads
+// each I/O thread runs an event loop, handling all of its connections without blocking
 class NetworkListener : public QTcpServer {
     Q_OBJECT
 
     public:
 
         NetworkListener(int port=1701);
+        ~NetworkListener();
 
     protected:
 
@@ -55,6 +63,11 @@ class NetworkListener : public QTcpServer {
     private:
 
         int port_;
+
+        std::vector<QThread *> ioThreads_;
+
+        // I/O thread for the next connection
+        unsigned int nextIOThread_;
 };
 
 #endif
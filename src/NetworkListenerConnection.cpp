@@ -0,0 +1,258 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "NetworkListenerConnection.h"
+#include "main.h"
+#include "log.h"
+#include "PixelStreamSource.h"
+#include "ParallelPixelStream.h"
+#include "SVGStreamSource.h"
+#include <stdint.h>
+#include <algorithm>
+
+NetworkListenerConnection::NetworkListenerConnection(int socketDescriptor)
+{
+    // defaults
+    tcpSocket_ = NULL;
+    protocolVersion_ = NETWORK_PROTOCOL_HANDSHAKE_VERSION;
+    state_ = READING_HEADER;
+    messageHeaderReceived_ = 0;
+    payloadReceived_ = 0;
+
+    // assign values
+    socketDescriptor_ = socketDescriptor;
+
+    // required for using MessageHeader with queued connections
+    qRegisterMetaType<MessageHeader>("MessageHeader");
+
+    // connect signals
+    // the I/O thread is shared by many connections, so it never waits for the main thread; sends are coalesced by the display group manager
+    connect(this, SIGNAL(updatedPixelStreamSource()), g_displayGroupManager.get(), SLOT(requestSendPixelStreams()), Qt::DirectConnection);
+
+    connect(this, SIGNAL(updatedSVGStreamSource()), g_displayGroupManager.get(), SLOT(requestSendSVGStreams()), Qt::DirectConnection);
+}
+
+void NetworkListenerConnection::initialize()
+{
+    // the socket is a child of this object, so it's deleted with it
+    tcpSocket_ = new QTcpSocket(this);
+
+    if(tcpSocket_->setSocketDescriptor(socketDescriptor_) != true)
+    {
+        put_flog(LOG_ERROR, "could not set socket descriptor: %s", tcpSocket_->errorString().toStdString().c_str());
+        deleteLater();
+        return;
+    }
+
+    connect(tcpSocket_, SIGNAL(readyRead()), this, SLOT(readMessages()));
+    connect(tcpSocket_, SIGNAL(disconnected()), this, SLOT(deleteLater()));
+
+    // handshake
+    int32_t protocolVersion = NETWORK_PROTOCOL_HANDSHAKE_VERSION;
+    tcpSocket_->write((char *)&protocolVersion, sizeof(int32_t));
+
+    // data may have arrived before we connected to readyRead()
+    readMessages();
+}
+
+void NetworkListenerConnection::readMessages()
+{
+    // parse as many messages as are available; a partial message is continued on the next readyRead()
+    while(tcpSocket_->bytesAvailable() > 0)
+    {
+        if(state_ == READING_HEADER)
+        {
+            qint64 bytesRead = tcpSocket_->read((char *)&messageHeader_ + messageHeaderReceived_, sizeof(MessageHeader) - messageHeaderReceived_);
+
+            if(bytesRead <= 0)
+            {
+                break;
+            }
+
+            messageHeaderReceived_ += bytesRead;
+
+            if(messageHeaderReceived_ < (int)sizeof(MessageHeader))
+            {
+                continue;
+            }
+
+            // got the header; allocate the payload buffer once, at its final size
+            messageHeaderReceived_ = 0;
+
+            payload_ = QByteArray();
+            payloadReceived_ = 0;
+
+            if(messageHeader_.size > 0)
+            {
+                payload_.resize(messageHeader_.size);
+            }
+
+            state_ = READING_PAYLOAD;
+        }
+
+        if(state_ == READING_PAYLOAD)
+        {
+            if(payloadReceived_ < payload_.size())
+            {
+                qint64 bytesRead = tcpSocket_->read(payload_.data() + payloadReceived_, payload_.size() - payloadReceived_);
+
+                if(bytesRead <= 0)
+                {
+                    break;
+                }
+
+                payloadReceived_ += bytesRead;
+            }
+
+            if(payloadReceived_ < payload_.size())
+            {
+                continue;
+            }
+
+            // got the message
+            state_ = READING_HEADER;
+
+            if(messageHeader_.type == MESSAGE_TYPE_PROTOCOL_UPGRADE && payload_.size() >= (int)sizeof(int32_t))
+            {
+                int32_t requestedVersion;
+                memcpy((void *)&requestedVersion, (void *)payload_.constData(), sizeof(int32_t));
+
+                sendProtocolUpgrade(requestedVersion);
+            }
+            else
+            {
+                handleMessage(messageHeader_, payload_);
+
+                // one acknowledgment for every message; with windowed flow control each returns one credit to the client
+                sendAck();
+            }
+        }
+    }
+}
+
+void NetworkListenerConnection::handleMessage(MessageHeader messageHeader, QByteArray byteArray)
+{
+    if(messageHeader.type == MESSAGE_TYPE_PIXELSTREAM)
+    {
+        // update pixel stream source
+        // keep this in this thread so we can have pixel stream source updating and sendPixelStreams() happening in parallel
+        // at most one sendPixelStreams() is queued at a time, and it grabs only the latest pixel stream data
+        std::string uri(messageHeader.uri);
+
+        g_pixelStreamSourceFactory.getObject(uri)->setImageData(byteArray);
+
+        emit(updatedPixelStreamSource());
+    }
+    else if(messageHeader.type == MESSAGE_TYPE_PIXELSTREAM_DIMENSIONS_CHANGED)
+    {
+        std::string uri(messageHeader.uri);
+
+        const int * dimensions = (const int *)byteArray.constData();
+
+        g_pixelStreamSourceFactory.getObject(uri)->setDimensions(dimensions[0], dimensions[1]);
+
+        emit(updatedPixelStreamSource());
+    }
+    else if(messageHeader.type == MESSAGE_TYPE_PARALLEL_PIXELSTREAM)
+    {
+        // update parallel pixel stream source
+        // keep this in this thread so we can have parallel pixel stream source updating and sendParallelPixelStreams() happening in parallel
+        // sendParallelPixelStreams() runs in a polling loop on the main thread
+        std::string uri(messageHeader.uri);
+
+        ParallelPixelStreamSegment segment;
+
+        // read parameters; older clients don't send the codec, which defaults to JPEG
+        int parametersSize = sizeof(ParallelPixelStreamSegmentParameters);
+
+        if(protocolVersion_ < NETWORK_PROTOCOL_CODEC_VERSION)
+        {
+            parametersSize = PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_LEGACY_SIZE;
+        }
+
+        if(byteArray.size() < parametersSize)
+        {
+            put_flog(LOG_ERROR, "invalid segment message size %i", byteArray.size());
+            return;
+        }
+
+        memcpy((void *)&segment.parameters, (void *)byteArray.constData(), parametersSize);
+
+        // the image data is used in place; the segment keeps a reference to the message buffer
+        segment.imageData = QByteArray::fromRawData(byteArray.constData() + parametersSize, byteArray.size() - parametersSize);
+        segment.imageDataBuffer = boost::shared_ptr<QByteArray>(new QByteArray(byteArray));
+
+        g_parallelPixelStreamSourceFactory.getObject(uri)->insertSegment(segment);
+
+        // no need to emit any signals since there's a polling loop in the main thread
+    }
+    else if(messageHeader.type == MESSAGE_TYPE_SVG_STREAM)
+    {
+        // update SVG stream source
+        // similar to pixel streaming above
+        std::string uri(messageHeader.uri);
+
+        g_SVGStreamSourceFactory.getObject(uri)->setImageData(byteArray);
+
+        emit(updatedSVGStreamSource());
+    }
+}
+
+void NetworkListenerConnection::sendAck()
+{
+    // the socket buffers the write; it's sent when we return to the event loop
+    const char ack[] = "ack";
+
+    tcpSocket_->write(ack, 3);
+}
+
+void NetworkListenerConnection::sendProtocolUpgrade(int32_t requestedVersion)
+{
+    protocolVersion_ = std::min(requestedVersion, (int32_t)NETWORK_PROTOCOL_VERSION);
+
+    put_flog(LOG_DEBUG, "requested protocol version %i, granted %i", requestedVersion, protocolVersion_);
+
+    // reply: "win", granted version, window size in messages and bytes
+    int32_t reply[3];
+    reply[0] = protocolVersion_;
+    reply[1] = NETWORK_PROTOCOL_WINDOW_MESSAGES;
+    reply[2] = NETWORK_PROTOCOL_WINDOW_BYTES;
+
+    tcpSocket_->write("win", 3);
+    tcpSocket_->write((const char *)reply, sizeof(reply));
+}
@@ -40,6 +40,25 @@
 #define NETWORK_PROTOCOL_H
 
 // increment this every time the network protocol changes in a major way
-#define NETWORK_PROTOCOL_VERSION 3
+#define NETWORK_PROTOCOL_VERSION 6
+
+// version sent by the server in the handshake
+// clients supporting newer versions request them with a MESSAGE_TYPE_PROTOCOL_UPGRADE message, so older clients keep working
+// the server replies "win" followed by the granted version and window (see below), or "ack" if it doesn't support upgrades
+#define NETWORK_PROTOCOL_HANDSHAKE_VERSION 3
+
+// starting with this version, clients don't wait for the acknowledgment of each message:
+// they may have up to NETWORK_PROTOCOL_WINDOW_MESSAGES messages or NETWORK_PROTOCOL_WINDOW_BYTES bytes unacknowledged
+#define NETWORK_PROTOCOL_WINDOWED_VERSION 4
+#define NETWORK_PROTOCOL_WINDOW_MESSAGES 32
+#define NETWORK_PROTOCOL_WINDOW_BYTES (16 * 1024 * 1024)
+
+// starting with this version, clients may send a parallel pixel stream segment with non-zero dimensions and no image data
+// to indicate that the segment didn't change for its frame index
+#define NETWORK_PROTOCOL_UNCHANGED_SEGMENTS_VERSION 5
+
+// starting with this version, parallel pixel stream segment parameters include the codec of the image data
+// (see ParallelPixelStreamSegmentParameters.h); older clients send PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_LEGACY_SIZE bytes of parameters
+#define NETWORK_PROTOCOL_CODEC_VERSION 6
 
 #endif
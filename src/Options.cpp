@@ -47,6 +47,7 @@ Options::Options()
     enableStreamingSynchronization_ = false;
     showStreamingSegments_ = false;
     showStreamingStatistics_ = false;
+    enableStreamingYUV_ = false;
 
 #if ENABLE_SKELETON_SUPPORT
     showSkeletons_ = true;
@@ -88,6 +89,11 @@ bool Options::getShowStreamingStatistics()
     return showStreamingStatistics_;
 }
 
+bool Options::getEnableStreamingYUV()
+{
+    return enableStreamingYUV_;
+}
+
 #if ENABLE_SKELETON_SUPPORT
 bool Options::getShowSkeletons()
 {
@@ -144,6 +150,13 @@ void Options::setShowStreamingStatistics(bool set)
     emit(updated());
 }
 
+void Options::setEnableStreamingYUV(bool set)
+{
+    enableStreamingYUV_ = set;
+
+    emit(updated());
+}
+
 #if ENABLE_SKELETON_SUPPORT
 void Options::setShowSkeletons(bool set)
 {
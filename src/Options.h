@@ -57,6 +57,7 @@ class Options : public QObject {
         bool getEnableStreamingSynchronization();
         bool getShowStreamingSegments();
         bool getShowStreamingStatistics();
+        bool getEnableStreamingYUV();
 
 #if ENABLE_SKELETON_SUPPORT
         bool getShowSkeletons();
@@ -70,6 +71,7 @@ class Options : public QObject {
         void setEnableStreamingSynchronization(bool set);
         void setShowStreamingSegments(bool set);
         void setShowStreamingStatistics(bool set);
+        void setEnableStreamingYUV(bool set);
 
 #if ENABLE_SKELETON_SUPPORT
         void setShowSkeletons(bool set);
@@ -91,6 +93,7 @@ class Options : public QObject {
             ar & enableStreamingSynchronization_;
             ar & showStreamingSegments_;
             ar & showStreamingStatistics_;
+            ar & enableStreamingYUV_;
 
 #if ENABLE_SKELETON_SUPPORT
             ar & showSkeletons_;
@@ -104,6 +107,7 @@ class Options : public QObject {
         bool enableStreamingSynchronization_;
         bool showStreamingSegments_;
         bool showStreamingStatistics_;
+        bool enableStreamingYUV_;
 
 #if ENABLE_SKELETON_SUPPORT
         bool showSkeletons_;
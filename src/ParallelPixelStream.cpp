@@ -59,6 +59,14 @@ void ParallelPixelStream::getDimensions(int &width, int &height)
     height = height_;
 }
 
+void ParallelPixelStream::setDimensions(int width, int height)
+{
+    QMutexLocker locker(&segmentsMutex_);
+
+    width_ = width;
+    height_ = height;
+}
+
 void ParallelPixelStream::render(float tX, float tY, float tW, float tH)
 {
     updateRenderedFrameCount();
@@ -195,7 +203,7 @@ std::vector<ParallelPixelStreamSegment> ParallelPixelStream::getAndPopLatestSegm
     {
         if((*it).second.size() > 0)
         {
-            latestSegments.push_back((*it).second.back());
+            latestSegments.push_back(getLatestSegment((*it).second, (*it).second.size() - 1));
         }
     }
 
@@ -237,7 +245,7 @@ std::vector<ParallelPixelStreamSegment> ParallelPixelStream::getAndPopSegments(i
         {
             if((*it).second[i].parameters.frameIndex == frameIndex)
             {
-                frameIndexSegments.push_back((*it).second[i]);
+                frameIndexSegments.push_back(getLatestSegment((*it).second, i));
 
                 // erase this segment and the earlier segments (i+1 segments will be erased)
                 (*it).second.erase((*it).second.begin(), (*it).second.begin() + i+1);
@@ -251,6 +259,30 @@ std::vector<ParallelPixelStreamSegment> ParallelPixelStream::getAndPopSegments(i
     return frameIndexSegments;
 }
 
+ParallelPixelStreamSegment ParallelPixelStream::getLatestSegment(const std::vector<ParallelPixelStreamSegment> & segments, unsigned int index)
+{
+    // an unchanged segment (without image data) means the image data is that of the previous segment
+    // if the previous segments are about to be dropped too, use the image data of the latest one that has any
+    ParallelPixelStreamSegment segment = segments[index];
+
+    if(segment.imageData.size() == 0 && segment.parameters.width != 0 && segment.parameters.height != 0)
+    {
+        for(int i=(int)index-1; i>=0 && segments[i].parameters.width != 0; i--)
+        {
+            if(segments[i].imageData.size() > 0)
+            {
+                segment.imageData = segments[i].imageData;
+                segment.imageDataBuffer = segments[i].imageDataBuffer;
+                segment.parameters.codec = segments[i].parameters.codec;
+
+                break;
+            }
+        }
+    }
+
+    return segment;
+}
+
 void ParallelPixelStream::updatePixelStreams()
 {
     // segments we want to process
@@ -350,7 +382,13 @@ void ParallelPixelStream::updatePixelStreams()
         // auto texture uploading depending on synchronous setting
         pixelStreams_[sourceIndex]->setAutoUpdateTexture(!enableStreamingSynchronization);
 
-        bool success = pixelStreams_[sourceIndex]->setImageData(segments[i].imageData);
+        // segments without image data are unchanged since the last frame; they only count for synchronization
+        if(segments[i].imageData.size() == 0)
+        {
+            continue;
+        }
+
+        bool success = pixelStreams_[sourceIndex]->setImageData(segments[i].imageData, segments[i].imageDataBuffer, segments[i].parameters.codec, segments[i].parameters.width, segments[i].parameters.height);
 
         if(success == true)
         {
@@ -481,6 +519,22 @@ std::string ParallelPixelStream::getStatistics(int sourceIndex)
         result += " fps";
     }
 
+    // decode statistics of the local pixel stream
+    if(pixelStreams_.count(sourceIndex) > 0)
+    {
+        PixelStreamDecodeStatistics decodeStatistics = pixelStreams_[sourceIndex]->getDecodeStatistics();
+
+        if(result.isEmpty() != true)
+        {
+            result += ", ";
+        }
+
+        result += QString::number(decodeStatistics.averageDecodeLatency, 'f', 1);
+        result += " ms decode, ";
+        result += QString::number(decodeStatistics.droppedFrames);
+        result += " dropped";
+    }
+
     return result.toStdString();
 }
 
@@ -82,6 +82,10 @@ struct ParallelPixelStreamSegment {
     // image data for segment
     QByteArray imageData;
 
+    // optional owner of the memory referenced by imageData, if it was created with QByteArray::fromRawData()
+    // this is not serialized
+    boost::shared_ptr<void> imageDataBuffer;
+
     private:
         friend class boost::serialization::access;
 
@@ -118,6 +122,7 @@ class ParallelPixelStream : public FactoryObject {
         ParallelPixelStream(std::string uri);
 
         void getDimensions(int &width, int &height);
+        void setDimensions(int width, int height);
         void render(float tX, float tY, float tW, float tH);
 
         void insertSegment(ParallelPixelStreamSegment segment);
@@ -154,6 +159,9 @@ class ParallelPixelStream : public FactoryObject {
         std::map<int, boost::shared_ptr<PixelStream> > pixelStreams_;
         std::map<int, ParallelPixelStreamSegmentParameters> pixelStreamParameters_;
 
+        // segments[index], with the image data of an earlier segment if it is unchanged
+        ParallelPixelStreamSegment getLatestSegment(const std::vector<ParallelPixelStreamSegment> & segments, unsigned int index);
+
         // determine if segment is visible on any of the screens of this process
         bool isSegmentVisible(ParallelPixelStreamSegmentParameters parameters);
 
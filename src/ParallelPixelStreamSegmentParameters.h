@@ -36,6 +36,9 @@
 /* or implied, of The University of Texas at Austin.                 */
 /*********************************************************************/
 
+#ifndef PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_H
+#define PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_H
+
 #ifdef _WIN32
     typedef __int32 int32_t;
 #else
@@ -44,6 +47,18 @@
 
 #define FRAME_INDEX_UNDEFINED -1
 
+// codecs of segment image data
+#define PARALLEL_PIXEL_STREAM_CODEC_JPEG 0
+
+// 32-bit BGRA pixels, top row first, without padding
+#define PARALLEL_PIXEL_STREAM_CODEC_RAW 1
+
+// raw pixels as above, compressed in the LZ4 block format
+#define PARALLEL_PIXEL_STREAM_CODEC_LZ4 2
+
+// size of the parameters before the codec was added; this is what clients using older protocol versions send
+#define PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_LEGACY_SIZE (8 * sizeof(int32_t))
+
 struct ParallelPixelStreamSegmentParameters {
 
     // source identifier
@@ -62,9 +77,15 @@ struct ParallelPixelStreamSegmentParameters {
     int32_t totalWidth;
     int32_t totalHeight;
 
+    // codec of the image data; only sent with protocol versions >= NETWORK_PROTOCOL_CODEC_VERSION
+    int32_t codec;
+
     ParallelPixelStreamSegmentParameters()
     {
         // defaults
         frameIndex = FRAME_INDEX_UNDEFINED;
+        codec = PARALLEL_PIXEL_STREAM_CODEC_JPEG;
     }
 };
+
+#endif
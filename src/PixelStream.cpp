@@ -39,43 +39,62 @@
 #include "PixelStream.h"
 #include "main.h"
 #include "log.h"
+#include "LZ4Block.h"
 
-PixelStream::PixelStream(std::string uri)
+// libjpeg-turbo decompression handle, one for each decode thread
+class PixelStreamDecompressor {
+
+    public:
+
+        PixelStreamDecompressor() { handle_ = tjInitDecompress(); }
+        ~PixelStreamDecompressor() { tjDestroy(handle_); }
+
+        tjhandle getHandle() { return handle_; }
+
+    private:
+
+        tjhandle handle_;
+};
+
+QThreadStorage<PixelStreamDecompressor *> g_pixelStreamDecompressors;
+
+QThreadPool * g_pixelStreamDecodeThreadPool = NULL;
+QMutex g_pixelStreamDecodeThreadPoolMutex;
+
+PixelStream::PixelStream(std::string uri) : texture_(GL_BGRA)
 {
     // defaults
-    textureId_ = 0;
-    textureWidth_ = 0;
-    textureHeight_ = 0;
-    textureBound_ = false;
-    imageReady_ = false;
     autoUpdateTexture_ = true;
+    renderYUV_ = false;
+    decodeYUV_ = false;
+    decoding_ = false;
+    pendingImageDataAvailable_ = false;
+    pendingCodec_ = PARALLEL_PIXEL_STREAM_CODEC_JPEG;
+    pendingWidth_ = 0;
+    pendingHeight_ = 0;
+    decodeStatistics_.decodedFrames = 0;
+    decodeStatistics_.droppedFrames = 0;
+    decodeStatistics_.averageDecodeLatency = 0.;
 
     // assign values
     uri_ = uri;
-
-    // initialize libjpeg-turbo handle
-    handle_ = tjInitDecompress();
 }
 
 PixelStream::~PixelStream()
 {
-    // delete bound texture
-    if(textureBound_ == true)
-    {
-        // let the OpenGL window delete the texture, so the destructor can occur in any thread...
-        g_mainWindow->getGLWindow()->insertPurgeTextureId(textureId_);
-
-        textureBound_ = false;
-    }
-
-    // destroy libjpeg-turbo handle
-    tjDestroy(handle_);
+    // the streaming texture lets the OpenGL window delete the texture, so the destructor can occur in any thread...
 }
 
 void PixelStream::getDimensions(int &width, int &height)
 {
-    width = textureWidth_;
-    height = textureHeight_;
+    if(renderYUV_ == true)
+    {
+        yuvTexture_.getDimensions(width, height);
+    }
+    else
+    {
+        texture_.getDimensions(width, height);
+    }
 }
 
 bool PixelStream::render(float tX, float tY, float tW, float tH)
@@ -88,7 +107,14 @@ bool PixelStream::render(float tX, float tY, float tW, float tH)
         updateTextureIfAvailable();
     }
 
-    if(textureBound_ != true)
+    if(renderYUV_ == true)
+    {
+        return yuvTexture_.render(tX, tY, tW, tH);
+    }
+
+    GLuint textureId = texture_.getTextureId();
+
+    if(textureId == 0)
     {
         return false;
     }
@@ -97,7 +123,7 @@ bool PixelStream::render(float tX, float tY, float tW, float tH)
     glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, textureId_);
+    glBindTexture(GL_TEXTURE_2D, textureId);
 
     // on zoom-out, clamp to edge (instead of showing the texture tiled / repeated)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -124,22 +150,39 @@ bool PixelStream::render(float tX, float tY, float tW, float tH)
     return true;
 }
 
-bool PixelStream::setImageData(QByteArray imageData)
+bool PixelStream::setImageData(QByteArray imageData, boost::shared_ptr<void> imageDataBuffer, int codec, int width, int height)
 {
-    // drop frames if we're currently processing
-    if(loadImageDataThread_.isRunning() == true)
+    QMutexLocker locker(&decodeMutex_);
+
+    // the newest frame wins: replace any frame still waiting to be decoded
+    if(pendingImageDataAvailable_ == true)
     {
-        return false;
+        decodeStatistics_.droppedFrames++;
     }
 
-    loadImageDataThread_ = QtConcurrent::run(loadImageDataThread, shared_from_this(), imageData);
+    pendingImageData_ = imageData;
+    pendingImageDataBuffer_ = imageDataBuffer;
+    pendingCodec_ = codec;
+    pendingWidth_ = width;
+    pendingHeight_ = height;
+    pendingImageDataTime_.start();
+    pendingImageDataAvailable_ = true;
+
+    if(decoding_ != true)
+    {
+        decoding_ = true;
+
+        PixelStreamDecodeTask::getThreadPool()->start(new PixelStreamDecodeTask(shared_from_this()));
+    }
 
     return true;
 }
 
 bool PixelStream::getLoadImageDataThreadRunning()
 {
-    return loadImageDataThread_.isRunning();
+    QMutexLocker locker(&decodeMutex_);
+
+    return decoding_;
 }
 
 void PixelStream::setAutoUpdateTexture(bool set)
@@ -149,94 +192,254 @@ void PixelStream::setAutoUpdateTexture(bool set)
 
 void PixelStream::updateTextureIfAvailable()
 {
+    // decode to YUV if enabled and the conversion shader is available
+    bool decodeYUV = g_displayGroupManager->getOptions()->getEnableStreamingYUV() == true && YUVTexture::getShadersAvailable() == true;
+
+    {
+        QMutexLocker locker(&decodeMutex_);
+        decodeYUV_ = decodeYUV;
+    }
+
     // upload a new texture if a new image is available
-    QMutexLocker locker(&imageReadyMutex_);
+    if(texture_.update() == true)
+    {
+        renderYUV_ = false;
+    }
 
-    if(imageReady_ == true)
+    if(yuvTexture_.update() == true)
     {
-        updateTexture(image_);
-        imageReady_ = false;
+        renderYUV_ = true;
     }
 }
 
-tjhandle PixelStream::getHandle()
+PixelStreamDecodeStatistics PixelStream::getDecodeStatistics()
 {
-    return handle_;
+    QMutexLocker locker(&decodeMutex_);
+
+    return decodeStatistics_;
+}
+
+void PixelStream::decodeLatestImageData()
+{
+    QByteArray imageData;
+    boost::shared_ptr<void> imageDataBuffer;
+    int codec;
+    int width;
+    int height;
+    QTime imageDataTime;
+    bool decodeYUV;
+
+    {
+        QMutexLocker locker(&decodeMutex_);
+
+        imageData = pendingImageData_;
+        imageDataBuffer = pendingImageDataBuffer_;
+        codec = pendingCodec_;
+        width = pendingWidth_;
+        height = pendingHeight_;
+        imageDataTime = pendingImageDataTime_;
+        decodeYUV = decodeYUV_;
+
+        pendingImageData_ = QByteArray();
+        pendingImageDataBuffer_.reset();
+        pendingImageDataAvailable_ = false;
+    }
+
+    // imageDataBuffer keeps the memory referenced by imageData until we're done
+    decodeImageData(shared_from_this(), imageData, codec, width, height, decodeYUV);
+
+    QMutexLocker locker(&decodeMutex_);
+
+    decodeStatistics_.decodedFrames++;
+
+    if(decodeStatistics_.decodedFrames == 1)
+    {
+        decodeStatistics_.averageDecodeLatency = imageDataTime.elapsed();
+    }
+    else
+    {
+        decodeStatistics_.averageDecodeLatency = (1. - PIXEL_STREAM_DECODE_LATENCY_SMOOTHING) * decodeStatistics_.averageDecodeLatency + PIXEL_STREAM_DECODE_LATENCY_SMOOTHING * imageDataTime.elapsed();
+    }
+
+    // queue another task for newer image data; a new task lets other streams' tasks run in between
+    if(pendingImageDataAvailable_ == true)
+    {
+        PixelStreamDecodeTask::getThreadPool()->start(new PixelStreamDecodeTask(shared_from_this()));
+    }
+    else
+    {
+        decoding_ = false;
+    }
+}
+
+StreamingTexture & PixelStream::getStreamingTexture()
+{
+    return texture_;
 }
 
 void PixelStream::imageReady(QImage image)
 {
-    QMutexLocker locker(&imageReadyMutex_);
-    imageReady_ = true;
-    image_ = image;
+    texture_.setImage(image);
+}
+
+void PixelStream::yuvImageReady(YUVImage image)
+{
+    yuvTexture_.setImage(image);
 }
 
-void PixelStream::updateTexture(QImage & image)
+void decodeImageData(boost::shared_ptr<PixelStream> pixelStream, QByteArray imageData, int codec, int width, int height, bool decodeYUV)
 {
-    // todo: consider if the image has changed dimensions
+    // note that we only use constData() here: imageData may reference memory owned by imageDataBuffer, and data() would make a copy
 
-    if(textureBound_ == false)
+    // libjpeg-turbo handle of this thread, for JPEG conversion
+    tjhandle handle = NULL;
+
+    // raw BGRA pixels, optionally LZ4-compressed, are in the same layout as QImage::Format_RGB32, with the dimensions from the segment parameters
+    if(codec == PARALLEL_PIXEL_STREAM_CODEC_JPEG)
     {
-        // want mipmaps disabled
-        textureId_ = g_mainWindow->getGLWindow()->bindTexture(image, GL_TEXTURE_2D, GL_RGBA, QGLContext::LinearFilteringBindOption);
-        textureWidth_ = image.width();
-        textureHeight_ = image.height();
-        textureBound_ = true;
+        if(g_pixelStreamDecompressors.hasLocalData() != true)
+        {
+            g_pixelStreamDecompressors.setLocalData(new PixelStreamDecompressor());
+        }
+
+        handle = g_pixelStreamDecompressors.localData()->getHandle();
+
+        // get information from header
+        int jpegSubsamp;
+        int success =  tjDecompressHeader2(handle, (unsigned char *)imageData.constData(), (unsigned long)imageData.size(), &width, &height, &jpegSubsamp);
+
+        if(success != 0)
+        {
+            put_flog(LOG_ERROR, "libjpeg-turbo header decompression failure");
+            return;
+        }
+
+        // decode to YUV planes, leaving the color conversion to the GPU
+        if(decodeYUV == true && YUVImage::isSubsamplingSupported(jpegSubsamp) == true)
+        {
+            if(width > PIXEL_STREAM_MAX_DIMENSION || height > PIXEL_STREAM_MAX_DIMENSION)
+            {
+                put_flog(LOG_ERROR, "invalid dimensions %ix%i", width, height);
+                return;
+            }
+
+            YUVImage yuvImage(width, height, jpegSubsamp);
+
+            if(tjDecompressToYUV(handle, (unsigned char *)imageData.constData(), (unsigned long)imageData.size(), (unsigned char *)yuvImage.data.data(), 0) != 0)
+            {
+                put_flog(LOG_ERROR, "libjpeg-turbo YUV image decompression failure");
+                return;
+            }
+
+            pixelStream->yuvImageReady(yuvImage);
+            return;
+        }
     }
-    else
+    else if(codec != PARALLEL_PIXEL_STREAM_CODEC_RAW && codec != PARALLEL_PIXEL_STREAM_CODEC_LZ4)
+    {
+        put_flog(LOG_ERROR, "unknown codec %i", codec);
+        return;
+    }
+
+    // the dimensions come from the network
+    if(width <= 0 || height <= 0 || width > PIXEL_STREAM_MAX_DIMENSION || height > PIXEL_STREAM_MAX_DIMENSION)
+    {
+        put_flog(LOG_ERROR, "invalid dimensions %ix%i", width, height);
+        return;
+    }
+
+    // decode directly into a mapped pixel buffer of the texture if one is available, otherwise into an image
+    StreamingTexture & texture = pixelStream->getStreamingTexture();
+
+    QImage image;
+    unsigned char * pixels = (unsigned char *)texture.beginWrite(width, height);
+
+    if(pixels == NULL)
     {
-        // update the texture. note that generally we would need to convert the image to an OpenGL supported format
-        // however, we're lucky and can use GL_BGRA on the original image...
-        // example conversion to GL format: QImage glImage = QGLWidget::convertToGLFormat(image);
+        image = QImage(width, height, QImage::Format_RGB32);
 
-        // if the size has changed, create a new texture
-        if(image.width() != textureWidth_ || image.height() != textureHeight_)
+        if(image.isNull() == true || image.bits() == NULL)
         {
-            // delete bound texture
-            glDeleteTextures(1, &textureId_); // it appears deleteTexture() below is not actually deleting the texture from the GPU...
-            g_mainWindow->getGLWindow()->deleteTexture(textureId_);
+            put_flog(LOG_ERROR, "could not allocate %ix%i image", width, height);
+            return;
+        }
+
+        pixels = image.bits();
+    }
 
-            textureId_ = g_mainWindow->getGLWindow()->bindTexture(image, GL_TEXTURE_2D, GL_RGBA, QGLContext::LinearFilteringBindOption);
-            textureWidth_ = image.width();
-            textureHeight_ = image.height();
+    // computed in 64 bits; with the dimensions checked above, it also fits in an int
+    int64_t size = (int64_t)width * (int64_t)height * 4;
+    bool success = true;
+
+    if(codec == PARALLEL_PIXEL_STREAM_CODEC_RAW)
+    {
+        if(imageData.size() != size)
+        {
+            put_flog(LOG_ERROR, "raw image data size %i != %i", imageData.size(), (int)size);
+            success = false;
         }
         else
         {
-            glBindTexture(GL_TEXTURE_2D, textureId_);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, image.width(), image.height(), GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+            memcpy(pixels, imageData.constData(), size);
         }
     }
-}
-
-void loadImageDataThread(boost::shared_ptr<PixelStream> pixelStream, QByteArray imageData)
-{
-    // use libjpeg-turbo for JPEG conversion
-    tjhandle handle = pixelStream->getHandle();
+    else if(codec == PARALLEL_PIXEL_STREAM_CODEC_LZ4)
+    {
+        if(lz4DecompressBlock(imageData.constData(), imageData.size(), (char *)pixels, (int)size) != size)
+        {
+            put_flog(LOG_ERROR, "LZ4 image decompression failure");
+            success = false;
+        }
+    }
+    else
+    {
+        // decompress image data
+        int pixelFormat = TJPF_BGRX;
+        int pitch = width * tjPixelSize[pixelFormat];
+        int flags = TJ_FASTUPSAMPLE;
 
-    // get information from header
-    int width, height, jpegSubsamp;
-    int success =  tjDecompressHeader2(handle, (unsigned char *)imageData.data(), (unsigned long)imageData.size(), &width, &height, &jpegSubsamp);
+        if(tjDecompress2(handle, (unsigned char *)imageData.constData(), (unsigned long)imageData.size(), pixels, width, pitch, height, pixelFormat, flags) != 0)
+        {
+            put_flog(LOG_ERROR, "libjpeg-turbo image decompression failure");
+            success = false;
+        }
+    }
 
-    if(success != 0)
+    if(image.isNull() != true)
     {
-        put_flog(LOG_ERROR, "libjpeg-turbo header decompression failure");
-        return;
+        if(success == true)
+        {
+            pixelStream->imageReady(image);
+        }
     }
+    else
+    {
+        texture.endWrite(pixels, success);
+    }
+}
 
-    // decompress image data
-    int pixelFormat = TJPF_BGRX;
-    int pitch = width * tjPixelSize[pixelFormat];
-    int flags = TJ_FASTUPSAMPLE;
+PixelStreamDecodeTask::PixelStreamDecodeTask(boost::shared_ptr<PixelStream> pixelStream)
+{
+    pixelStream_ = pixelStream;
+}
 
-    QImage image = QImage(width, height, QImage::Format_RGB32);
+void PixelStreamDecodeTask::run()
+{
+    pixelStream_->decodeLatestImageData();
+}
 
-    success = tjDecompress2(handle, (unsigned char *)imageData.data(), (unsigned long)imageData.size(), (unsigned char *)image.scanLine(0), width, pitch, height, pixelFormat, flags);
+QThreadPool * PixelStreamDecodeTask::getThreadPool()
+{
+    QMutexLocker locker(&g_pixelStreamDecodeThreadPoolMutex);
 
-    if(success != 0)
+    if(g_pixelStreamDecodeThreadPool == NULL)
     {
-        put_flog(LOG_ERROR, "libjpeg-turbo image decompression failure");
-        return;
+        g_pixelStreamDecodeThreadPool = new QThreadPool();
+        g_pixelStreamDecodeThreadPool->setMaxThreadCount(QThread::idealThreadCount());
+
+        // keep the threads, and their decompression handles, between frames
+        g_pixelStreamDecodeThreadPool->setExpiryTimeout(-1);
     }
 
-    pixelStream->imageReady(image);
+    return g_pixelStreamDecodeThreadPool;
 }
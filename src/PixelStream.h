@@ -40,11 +40,31 @@
 #define PIXEL_STREAM_H
 
 #include "FactoryObject.h"
+#include "ParallelPixelStreamSegmentParameters.h"
+#include "StreamingTexture.h"
+#include "YUVTexture.h"
+#include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <QGLWidget>
-#include <QtConcurrentRun>
+#include <QtCore>
 #include <turbojpeg.h>
 
+// smoothing factor of the average decode latency
+#define PIXEL_STREAM_DECODE_LATENCY_SMOOTHING 0.1
+
+// largest width or height of a decoded image; dimensions come from the network, so they are checked before allocating
+#define PIXEL_STREAM_MAX_DIMENSION 16384
+
+struct PixelStreamDecodeStatistics {
+
+    // frames decoded, and frames replaced by a newer frame before they could be decoded
+    int decodedFrames;
+    int droppedFrames;
+
+    // average time from setImageData() until the image is decoded, in milliseconds
+    float averageDecodeLatency;
+};
+
 class PixelStream : public boost::enable_shared_from_this<PixelStream>, public FactoryObject {
 
     public:
@@ -54,44 +74,82 @@ class PixelStream : public boost::enable_shared_from_this<PixelStream>, public F
 
         void getDimensions(int &width, int &height);
         bool render(float tX, float tY, float tW, float tH); // return true on successful render; false if no texture available
-        bool setImageData(QByteArray imageData); // returns true if load image thread was spawned; false if frame was dropped
+        // queues image data for decoding on the decode thread pool; always returns true
+        // only the latest image data is kept: image data still waiting to be decoded is replaced and counted as dropped
+        // imageDataBuffer optionally owns the memory referenced by imageData (see QByteArray::fromRawData()) and is kept until decoding is done
+        // codec is one of PARALLEL_PIXEL_STREAM_CODEC_*; the raw codecs need the image dimensions
+        bool setImageData(QByteArray imageData, boost::shared_ptr<void> imageDataBuffer = boost::shared_ptr<void>(), int codec = PARALLEL_PIXEL_STREAM_CODEC_JPEG, int width = 0, int height = 0);
+
+        // whether image data is being decoded or waiting to be decoded
         bool getLoadImageDataThreadRunning();
+
         void setAutoUpdateTexture(bool set);
         void updateTextureIfAvailable();
 
-        // for use by loadImageDataThread()
-        tjhandle getHandle();
+        PixelStreamDecodeStatistics getDecodeStatistics();
+
+        // for use by the decode thread pool: decode the latest image data
+        // images are decoded directly into the streaming texture's mapped buffers when possible, otherwise into a QImage passed to imageReady()
+        void decodeLatestImageData();
+        StreamingTexture & getStreamingTexture();
         void imageReady(QImage image);
+        void yuvImageReady(YUVImage image);
 
     private:
 
         // pixel stream identifier
         std::string uri_;
 
-        // texture
-        GLuint textureId_;
-        int textureWidth_;
-        int textureHeight_;
-        bool textureBound_;
+        // texture, holding the latest decoded image until it is uploaded
+        StreamingTexture texture_;
 
-        // thread for generating images from image data
-        QFuture<void> loadImageDataThread_;
+        // textures for images decoded to YUV, converted to RGB when rendered
+        // renderYUV_ is true if the latest uploaded image was a YUV image
+        YUVTexture yuvTexture_;
+        bool renderYUV_;
 
-        // libjpeg-turbo handle for decompression
-        tjhandle handle_;
+        // latest image data waiting to be decoded, and whether a decode task is queued or running
+        // at most one decode task runs per stream, so images are decoded in order
+        QMutex decodeMutex_;
+        bool decoding_;
+        bool pendingImageDataAvailable_;
+        QByteArray pendingImageData_;
+        boost::shared_ptr<void> pendingImageDataBuffer_;
+        int pendingCodec_;
+        int pendingWidth_;
+        int pendingHeight_;
+        QTime pendingImageDataTime_;
 
-        // image, mutex, and ready status
-        QMutex imageReadyMutex_;
-        bool imageReady_;
-        QImage image_;
+        // whether JPEG image data should be decoded to YUV
+        bool decodeYUV_;
+
+        // decode statistics
+        PixelStreamDecodeStatistics decodeStatistics_;
 
         // whether updateTexture() should be called automatically every render() or not
         // this can be set to false to allow for synchronization across multiple streams, for example.
         bool autoUpdateTexture_;
-
-        void updateTexture(QImage & image);
 };
 
-extern void loadImageDataThread(boost::shared_ptr<PixelStream> pixelStream, QByteArray imageData);
+// decodes image data for a pixel stream, with the libjpeg-turbo handle of the calling thread
+// JPEG image data is decoded to YUV planes if decodeYUV is true and the JPEG subsampling is supported
+extern void decodeImageData(boost::shared_ptr<PixelStream> pixelStream, QByteArray imageData, int codec, int width, int height, bool decodeYUV);
+
+// decodes the latest image data of a pixel stream on the decode thread pool
+class PixelStreamDecodeTask : public QRunnable {
+
+    public:
+
+        PixelStreamDecodeTask(boost::shared_ptr<PixelStream> pixelStream);
+
+        void run();
+
+        // the thread pool for all pixel stream decoding, separate from the global thread pool
+        static QThreadPool * getThreadPool();
+
+    private:
+
+        boost::shared_ptr<PixelStream> pixelStream_;
+};
 
 #endif
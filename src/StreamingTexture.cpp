@@ -0,0 +1,435 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "StreamingTexture.h"
+#include "main.h"
+#include "log.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef APIENTRY
+    #define APIENTRY
+#endif
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+    #define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+
+#ifndef GL_STREAM_DRAW
+    #define GL_STREAM_DRAW 0x88E0
+#endif
+
+#ifndef GL_WRITE_ONLY
+    #define GL_WRITE_ONLY 0x88B9
+#endif
+
+// buffer object entry points, resolved at runtime since they are not part of OpenGL 1.1
+typedef void (APIENTRY * GenBuffersFunction)(GLsizei n, GLuint * buffers);
+typedef void (APIENTRY * DeleteBuffersFunction)(GLsizei n, const GLuint * buffers);
+typedef void (APIENTRY * BindBufferFunction)(GLenum target, GLuint buffer);
+typedef void (APIENTRY * BufferDataFunction)(GLenum target, ptrdiff_t size, const GLvoid * data, GLenum usage);
+typedef GLvoid * (APIENTRY * MapBufferFunction)(GLenum target, GLenum access);
+typedef GLboolean (APIENTRY * UnmapBufferFunction)(GLenum target);
+
+GenBuffersFunction g_glGenBuffers = NULL;
+DeleteBuffersFunction g_glDeleteBuffers = NULL;
+BindBufferFunction g_glBindBuffer = NULL;
+BufferDataFunction g_glBufferData = NULL;
+MapBufferFunction g_glMapBuffer = NULL;
+UnmapBufferFunction g_glUnmapBuffer = NULL;
+
+void * getBufferFunction(const QGLContext * context, QString name)
+{
+    void * function = context->getProcAddress(name);
+
+    // fall back to the ARB_vertex_buffer_object entry points
+    if(function == NULL)
+    {
+        function = context->getProcAddress(name + "ARB");
+    }
+
+    return function;
+}
+
+StreamingTexture::StreamingTexture(GLenum format)
+{
+    format_ = format;
+
+    textureId_ = 0;
+    textureWidth_ = 0;
+    textureHeight_ = 0;
+
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        pixelBuffers_[i].id = 0;
+        pixelBuffers_[i].state = PIXEL_BUFFER_UNMAPPED;
+        pixelBuffers_[i].data = NULL;
+        pixelBuffers_[i].width = 0;
+        pixelBuffers_[i].height = 0;
+    }
+}
+
+StreamingTexture::~StreamingTexture()
+{
+    // let the OpenGL window delete the texture and buffers, so the destructor can occur in any thread...
+    // deleting a mapped buffer also unmaps it
+    if(textureId_ != 0)
+    {
+        g_mainWindow->getGLWindow()->insertPurgeTextureId(textureId_);
+    }
+
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        if(pixelBuffers_[i].id != 0)
+        {
+            g_mainWindow->getGLWindow()->insertPurgeBufferId(pixelBuffers_[i].id);
+        }
+    }
+}
+
+GLuint StreamingTexture::getTextureId()
+{
+    QMutexLocker locker(&mutex_);
+
+    return textureId_;
+}
+
+void StreamingTexture::getDimensions(int &width, int &height)
+{
+    QMutexLocker locker(&mutex_);
+
+    width = textureWidth_;
+    height = textureHeight_;
+}
+
+void * StreamingTexture::beginWrite(int width, int height)
+{
+    QMutexLocker locker(&mutex_);
+
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        if(pixelBuffers_[i].state == PIXEL_BUFFER_MAPPED && pixelBuffers_[i].width == width && pixelBuffers_[i].height == height)
+        {
+            pixelBuffers_[i].state = PIXEL_BUFFER_WRITING;
+
+            return pixelBuffers_[i].data;
+        }
+    }
+
+    return NULL;
+}
+
+void StreamingTexture::endWrite(void * data, bool success)
+{
+    QMutexLocker locker(&mutex_);
+
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        if(pixelBuffers_[i].state == PIXEL_BUFFER_WRITING && pixelBuffers_[i].data == data)
+        {
+            if(success == true)
+            {
+                // this image replaces any older image waiting for upload; the older buffer stays mapped for reuse
+                for(int j=0; j<STREAMING_TEXTURE_PIXEL_BUFFERS; j++)
+                {
+                    if(pixelBuffers_[j].state == PIXEL_BUFFER_READY)
+                    {
+                        pixelBuffers_[j].state = PIXEL_BUFFER_MAPPED;
+                    }
+                }
+
+                image_ = QImage();
+
+                pixelBuffers_[i].state = PIXEL_BUFFER_READY;
+            }
+            else
+            {
+                pixelBuffers_[i].state = PIXEL_BUFFER_MAPPED;
+            }
+
+            return;
+        }
+    }
+
+    put_flog(LOG_ERROR, "unknown buffer");
+}
+
+void StreamingTexture::setImage(QImage image)
+{
+    QMutexLocker locker(&mutex_);
+
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        if(pixelBuffers_[i].state == PIXEL_BUFFER_READY)
+        {
+            pixelBuffers_[i].state = PIXEL_BUFFER_MAPPED;
+        }
+    }
+
+    image_ = image;
+}
+
+bool StreamingTexture::update()
+{
+    QMutexLocker locker(&mutex_);
+
+    bool updated = false;
+
+    if(image_.isNull() != true)
+    {
+        uploadTexture(image_.bits(), image_.width(), image_.height());
+        image_ = QImage();
+
+        updated = true;
+    }
+    else
+    {
+        for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+        {
+            if(pixelBuffers_[i].state == PIXEL_BUFFER_READY)
+            {
+                updated = uploadPixelBuffer(pixelBuffers_[i]);
+                break;
+            }
+        }
+    }
+
+    mapPixelBuffers();
+
+    return updated;
+}
+
+void StreamingTexture::upload(const void * pixels, int width, int height)
+{
+    QMutexLocker locker(&mutex_);
+
+    uploadTexture(pixels, width, height);
+
+    mapPixelBuffers();
+}
+
+bool StreamingTexture::getPixelBuffersAvailable()
+{
+    static bool checked = false;
+    static bool available = false;
+
+    if(checked == true)
+    {
+        return available;
+    }
+
+    checked = true;
+
+    if(getenv(STREAMING_TEXTURE_DISABLE_PBO_ENV) != NULL)
+    {
+        put_flog(LOG_INFO, "pixel buffer objects disabled by %s", STREAMING_TEXTURE_DISABLE_PBO_ENV);
+        return available;
+    }
+
+    const QGLContext * context = QGLContext::currentContext();
+
+    if(context == NULL)
+    {
+        put_flog(LOG_ERROR, "no current OpenGL context");
+        return available;
+    }
+
+    // pixel buffer objects are core in OpenGL 2.1
+    int majorVersion = 0;
+    int minorVersion = 0;
+
+    const char * version = (const char *)glGetString(GL_VERSION);
+    const char * extensions = (const char *)glGetString(GL_EXTENSIONS);
+
+    if(version != NULL)
+    {
+        sscanf(version, "%i.%i", &majorVersion, &minorVersion);
+    }
+
+    bool supported = (majorVersion > 2 || (majorVersion == 2 && minorVersion >= 1));
+
+    if(supported != true && extensions != NULL && strstr(extensions, "GL_ARB_pixel_buffer_object") != NULL)
+    {
+        supported = true;
+    }
+
+    if(supported == true)
+    {
+        g_glGenBuffers = (GenBuffersFunction)getBufferFunction(context, "glGenBuffers");
+        g_glDeleteBuffers = (DeleteBuffersFunction)getBufferFunction(context, "glDeleteBuffers");
+        g_glBindBuffer = (BindBufferFunction)getBufferFunction(context, "glBindBuffer");
+        g_glBufferData = (BufferDataFunction)getBufferFunction(context, "glBufferData");
+        g_glMapBuffer = (MapBufferFunction)getBufferFunction(context, "glMapBuffer");
+        g_glUnmapBuffer = (UnmapBufferFunction)getBufferFunction(context, "glUnmapBuffer");
+
+        available = (g_glGenBuffers != NULL && g_glDeleteBuffers != NULL && g_glBindBuffer != NULL && g_glBufferData != NULL && g_glMapBuffer != NULL && g_glUnmapBuffer != NULL);
+    }
+
+    if(available == true)
+    {
+        put_flog(LOG_INFO, "using pixel buffer objects for texture uploads");
+    }
+    else
+    {
+        put_flog(LOG_INFO, "pixel buffer objects not available (OpenGL %s), uploading textures from client memory", version != NULL ? version : "unknown");
+    }
+
+    return available;
+}
+
+void StreamingTexture::deleteBuffers(std::vector<GLuint> & bufferIds)
+{
+    if(bufferIds.size() > 0 && g_glDeleteBuffers != NULL)
+    {
+        g_glDeleteBuffers((GLsizei)bufferIds.size(), &bufferIds[0]);
+    }
+}
+
+void StreamingTexture::uploadTexture(const void * pixels, int width, int height)
+{
+    if(textureId_ == 0)
+    {
+        glGenTextures(1, &textureId_);
+
+        glBindTexture(GL_TEXTURE_2D, textureId_);
+
+        // no mipmaps
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, textureId_);
+    }
+
+    // glTexSubImage2D uses the existing texture storage; only reallocate when the dimensions change
+    if(width != textureWidth_ || height != textureHeight_)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format_, GL_UNSIGNED_BYTE, pixels);
+
+        textureWidth_ = width;
+        textureHeight_ = height;
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, width, height, format_, GL_UNSIGNED_BYTE, pixels);
+    }
+}
+
+bool StreamingTexture::uploadPixelBuffer(PixelBuffer & pixelBuffer)
+{
+    g_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.id);
+
+    bool success = (g_glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE);
+
+    pixelBuffer.state = PIXEL_BUFFER_UNMAPPED;
+    pixelBuffer.data = NULL;
+
+    // the buffer contents can be lost, e.g. on a display mode change
+    if(success == true)
+    {
+        // with a pixel unpack buffer bound, the pixels argument is an offset into the buffer
+        // the transfer happens asynchronously, without stalling this thread
+        uploadTexture(0, pixelBuffer.width, pixelBuffer.height);
+    }
+    else
+    {
+        put_flog(LOG_WARN, "pixel buffer contents lost");
+    }
+
+    g_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return success;
+}
+
+void StreamingTexture::mapPixelBuffer(PixelBuffer & pixelBuffer, int width, int height)
+{
+    if(pixelBuffer.id == 0)
+    {
+        g_glGenBuffers(1, &pixelBuffer.id);
+    }
+
+    g_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.id);
+
+    if(pixelBuffer.state == PIXEL_BUFFER_MAPPED)
+    {
+        g_glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // allocating new storage (orphaning the previous one, which may still be in use by an upload)
+    // means mapping does not wait for pending transfers
+    g_glBufferData(GL_PIXEL_UNPACK_BUFFER, (ptrdiff_t)width * height * 4, NULL, GL_STREAM_DRAW);
+
+    pixelBuffer.data = g_glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+    if(pixelBuffer.data != NULL)
+    {
+        pixelBuffer.state = PIXEL_BUFFER_MAPPED;
+        pixelBuffer.width = width;
+        pixelBuffer.height = height;
+    }
+    else
+    {
+        put_flog(LOG_ERROR, "could not map pixel buffer");
+
+        pixelBuffer.state = PIXEL_BUFFER_UNMAPPED;
+    }
+
+    g_glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void StreamingTexture::mapPixelBuffers()
+{
+    if(textureWidth_ <= 0 || textureHeight_ <= 0 || getPixelBuffersAvailable() != true)
+    {
+        return;
+    }
+
+    // buffers being written or waiting for upload are left alone
+    for(int i=0; i<STREAMING_TEXTURE_PIXEL_BUFFERS; i++)
+    {
+        PixelBuffer & pixelBuffer = pixelBuffers_[i];
+
+        if(pixelBuffer.state == PIXEL_BUFFER_UNMAPPED || (pixelBuffer.state == PIXEL_BUFFER_MAPPED && (pixelBuffer.width != textureWidth_ || pixelBuffer.height != textureHeight_)))
+        {
+            mapPixelBuffer(pixelBuffer, textureWidth_, textureHeight_);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef STREAMING_TEXTURE_H
+#define STREAMING_TEXTURE_H
+
+#include <QGLWidget>
+#include <QtCore>
+#include <vector>
+
+// number of pixel buffer objects for each texture: one being written, one waiting for upload, and one spare
+#define STREAMING_TEXTURE_PIXEL_BUFFERS 3
+
+// if this environment variable is set, pixel buffer objects are not used
+#define STREAMING_TEXTURE_DISABLE_PBO_ENV "DISPLAYCLUSTER_DISABLE_PBO"
+
+// a texture updated through a ring of pixel buffer objects (PBOs)
+// writers, in any thread, decode images directly into mapped PBO memory with beginWrite() / endWrite(),
+// and the OpenGL thread uploads the latest written image in update() without stalling on the transfer.
+// if PBOs are not available, beginWrite() returns NULL and images are uploaded from client memory instead.
+// only the latest image is kept: a newer image replaces one still waiting for upload
+class StreamingTexture {
+
+    public:
+
+        // format of the images: GL_RGBA or GL_BGRA, 4 bytes per pixel, top row first
+        StreamingTexture(GLenum format);
+        ~StreamingTexture();
+
+        // returns 0 if no image was uploaded yet
+        GLuint getTextureId();
+        void getDimensions(int &width, int &height);
+
+        // returns mapped memory for an image of the given dimensions, or NULL if no buffer is available
+        // buffers are only mapped for the dimensions of the last uploaded image
+        void * beginWrite(int width, int height);
+
+        // finish a write started with beginWrite(); on success the image is queued for upload
+        void endWrite(void * data, bool success);
+
+        // queue an image in client memory for upload
+        void setImage(QImage image);
+
+        // for use in the OpenGL thread: upload the latest queued image and map buffers for the next writes
+        // returns true if the texture was updated
+        bool update();
+
+        // for use in the OpenGL thread: upload an image in client memory immediately
+        void upload(const void * pixels, int width, int height);
+
+        // for use in the OpenGL thread: whether the current context supports pixel buffer objects
+        static bool getPixelBuffersAvailable();
+
+        // for use in the OpenGL thread: delete buffers; see GLWindow::insertPurgeBufferId()
+        static void deleteBuffers(std::vector<GLuint> & bufferIds);
+
+    private:
+
+        enum PIXEL_BUFFER_STATE { PIXEL_BUFFER_UNMAPPED, PIXEL_BUFFER_MAPPED, PIXEL_BUFFER_WRITING, PIXEL_BUFFER_READY };
+
+        struct PixelBuffer {
+            GLuint id;
+            PIXEL_BUFFER_STATE state;
+            void * data;
+            int width;
+            int height;
+        };
+
+        GLenum format_;
+
+        // protects everything below
+        QMutex mutex_;
+
+        GLuint textureId_;
+        int textureWidth_;
+        int textureHeight_;
+
+        PixelBuffer pixelBuffers_[STREAMING_TEXTURE_PIXEL_BUFFERS];
+
+        // image in client memory waiting for upload
+        QImage image_;
+
+        void uploadTexture(const void * pixels, int width, int height);
+        bool uploadPixelBuffer(PixelBuffer & pixelBuffer);
+        void mapPixelBuffer(PixelBuffer & pixelBuffer, int width, int height);
+        void mapPixelBuffers();
+};
+
+#endif
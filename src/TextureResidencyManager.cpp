@@ -0,0 +1,173 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "TextureResidencyManager.h"
+#include "DynamicTexture.h"
+#include "main.h"
+#include "log.h"
+
+TextureResidencyManager::TextureResidencyManager()
+{
+    budgetBytes_ = 0;
+    residentBytes_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+    refusals_ = 0;
+}
+
+void TextureResidencyManager::setBudget(size_t bytes)
+{
+    QMutexLocker locker(&mutex_);
+
+    budgetBytes_ = bytes;
+}
+
+bool TextureResidencyManager::insert(DynamicTexture * dynamicTexture, size_t bytes)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(textureEntries_.count(dynamicTexture) != 0)
+    {
+        put_flog(LOG_WARN, "texture already resident");
+        return true;
+    }
+
+    // evict least recently used textures until the new texture fits, but never textures used in the current frame
+    // textures_ is ordered by last use, so we can stop at the first texture used in the current frame
+    while(residentBytes_ + bytes > budgetBytes_ && textures_.size() > 0 && textureEntries_[textures_.back()].frame < g_frameCount)
+    {
+        DynamicTexture * evictTexture = textures_.back();
+
+        residentBytes_ -= textureEntries_[evictTexture].bytes;
+
+        textureEntries_.erase(evictTexture);
+        textures_.pop_back();
+
+        // the object can't be destroyed while we hold the lock, since its destructor removes it here first
+        evictTexture->evictTexture();
+
+        evictions_++;
+    }
+
+    if(residentBytes_ + bytes > budgetBytes_)
+    {
+        refusals_++;
+
+        return false;
+    }
+
+    textures_.push_front(dynamicTexture);
+
+    TextureResidencyEntry & entry = textureEntries_[dynamicTexture];
+    entry.position = textures_.begin();
+    entry.bytes = bytes;
+    entry.frame = g_frameCount;
+
+    residentBytes_ += bytes;
+
+    return true;
+}
+
+void TextureResidencyManager::touch(DynamicTexture * dynamicTexture)
+{
+    QMutexLocker locker(&mutex_);
+
+    std::map<DynamicTexture *, TextureResidencyEntry>::iterator it = textureEntries_.find(dynamicTexture);
+
+    if(it != textureEntries_.end())
+    {
+        // move to the front of the list
+        textures_.splice(textures_.begin(), textures_, it->second.position);
+
+        it->second.frame = g_frameCount;
+
+        hits_++;
+    }
+}
+
+void TextureResidencyManager::recordMiss()
+{
+    QMutexLocker locker(&mutex_);
+
+    misses_++;
+}
+
+void TextureResidencyManager::remove(DynamicTexture * dynamicTexture)
+{
+    QMutexLocker locker(&mutex_);
+
+    std::map<DynamicTexture *, TextureResidencyEntry>::iterator it = textureEntries_.find(dynamicTexture);
+
+    if(it != textureEntries_.end())
+    {
+        residentBytes_ -= it->second.bytes;
+
+        textures_.erase(it->second.position);
+        textureEntries_.erase(it);
+    }
+}
+
+TextureResidencyStatistics TextureResidencyManager::getStatistics()
+{
+    QMutexLocker locker(&mutex_);
+
+    TextureResidencyStatistics statistics;
+
+    statistics.hits = hits_;
+    statistics.misses = misses_;
+    statistics.evictions = evictions_;
+    statistics.refusals = refusals_;
+    statistics.residentTextures = (int)textures_.size();
+    statistics.residentBytes = residentBytes_;
+    statistics.budgetBytes = budgetBytes_;
+
+    return statistics;
+}
+
+void TextureResidencyManager::logStatistics(long frame)
+{
+    if(frame % TEXTURE_RESIDENCY_LOG_INTERVAL != 0)
+    {
+        return;
+    }
+
+    TextureResidencyStatistics s = getStatistics();
+
+    put_flog(LOG_INFO, "texture residency: %i textures, %i / %i MB, %li hits, %li misses, %li evictions, %li refused uploads", s.residentTextures, (int)(s.residentBytes / (1024 * 1024)), (int)(s.budgetBytes / (1024 * 1024)), s.hits, s.misses, s.evictions, s.refusals);
+}
@@ -0,0 +1,130 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef TEXTURE_RESIDENCY_MANAGER_H
+#define TEXTURE_RESIDENCY_MANAGER_H
+
+// number of frames between logging of the residency statistics
+#define TEXTURE_RESIDENCY_LOG_INTERVAL 600
+
+#include <QtCore>
+#include <list>
+#include <map>
+
+class DynamicTexture;
+
+struct TextureResidencyStatistics {
+
+    // tile renders with the texture resident
+    long hits;
+
+    // tile loads requested because a rendered tile had no texture
+    long misses;
+
+    // textures evicted to stay within the budget
+    long evictions;
+
+    // uploads refused because all resident textures were used in the current frame
+    long refusals;
+
+    int residentTextures;
+    size_t residentBytes;
+    size_t budgetBytes;
+};
+
+struct TextureResidencyEntry {
+
+    std::list<DynamicTexture *>::iterator position;
+
+    size_t bytes;
+
+    // frame the texture was last used
+    long frame;
+};
+
+// keeps the textures of DynamicTexture tiles within a GPU memory budget
+// tiles register their textures when uploaded and mark them used when rendered; when the budget is exceeded, the
+// least recently used textures are evicted and their tiles are loaded again when next needed
+// textures used in the current frame are never evicted: if the visible tiles don't fit, further uploads are refused
+// and those tiles are rendered from their parents instead of being reloaded every frame
+class TextureResidencyManager {
+
+    public:
+
+        TextureResidencyManager();
+
+        void setBudget(size_t bytes);
+
+        // register a texture about to be uploaded, evicting textures not used in the current frame if necessary
+        // returns false, and doesn't register the texture, if it doesn't fit (OpenGL thread)
+        bool insert(DynamicTexture * dynamicTexture, size_t bytes);
+
+        // mark a resident texture as used in the current frame (OpenGL thread)
+        void touch(DynamicTexture * dynamicTexture);
+
+        // record a tile load requested because a rendered tile had no texture (OpenGL thread)
+        void recordMiss();
+
+        // thread needs access to this method
+        void remove(DynamicTexture * dynamicTexture);
+
+        TextureResidencyStatistics getStatistics();
+
+        // log the statistics every TEXTURE_RESIDENCY_LOG_INTERVAL frames
+        void logStatistics(long frame);
+
+    private:
+
+        QMutex mutex_;
+
+        size_t budgetBytes_;
+        size_t residentBytes_;
+
+        // resident textures, most recently used first
+        std::list<DynamicTexture *> textures_;
+
+        // position in textures_, size and last use of each resident texture
+        std::map<DynamicTexture *, TextureResidencyEntry> textureEntries_;
+
+        long hits_;
+        long misses_;
+        long evictions_;
+        long refusals_;
+};
+
+#endif
@@ -0,0 +1,519 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "YUVTexture.h"
+#include "main.h"
+#include "log.h"
+#include <QGLShaderProgram>
+#include <QGLFramebufferObject>
+#include <turbojpeg.h>
+
+#ifndef APIENTRY
+    #define APIENTRY
+#endif
+
+#ifndef GL_TEXTURE0
+    #define GL_TEXTURE0 0x84C0
+#endif
+
+// multitexturing entry point, resolved at runtime since it is not part of OpenGL 1.1
+typedef void (APIENTRY * ActiveTextureFunction)(GLenum texture);
+
+ActiveTextureFunction g_glActiveTexture = NULL;
+
+// conversion shader, shared by all (shared) OpenGL contexts
+bool g_yuvShadersInitialized = false;
+bool g_yuvShadersAvailable = false;
+QGLShaderProgram * g_yuvShaderProgram = NULL;
+
+// JFIF full-range YCbCr to RGB; keep in sync with convertYUVImageToRGB()
+const char * g_yuvFragmentShaderSource =
+    "uniform sampler2D yTexture;\n"
+    "uniform sampler2D cbTexture;\n"
+    "uniform sampler2D crTexture;\n"
+    "void main()\n"
+    "{\n"
+    "    float y = texture2D(yTexture, gl_TexCoord[0].st).r;\n"
+    "    float cb = texture2D(cbTexture, gl_TexCoord[0].st).r - 0.5;\n"
+    "    float cr = texture2D(crTexture, gl_TexCoord[0].st).r - 0.5;\n"
+    "    gl_FragColor = vec4(y + 1.402 * cr, y - 0.344136 * cb - 0.714136 * cr, y + 1.772 * cb, 1.);\n"
+    "}\n";
+
+// horizontal and vertical chroma subsampling factors
+void getSubsamplingFactors(int subsampling, int &horizontal, int &vertical)
+{
+    horizontal = (subsampling == TJSAMP_444) ? 1 : 2;
+    vertical = (subsampling == TJSAMP_420) ? 2 : 1;
+}
+
+int padSize(int size, int multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+YUVImage::YUVImage()
+{
+    width = 0;
+    height = 0;
+    subsampling = TJSAMP_444;
+}
+
+YUVImage::YUVImage(int width, int height, int subsampling)
+{
+    this->width = width;
+    this->height = height;
+    this->subsampling = subsampling;
+
+    data.resize(getSize());
+}
+
+bool YUVImage::isNull() const
+{
+    return data.size() == 0;
+}
+
+int YUVImage::getPlaneWidth(int plane) const
+{
+    int horizontal, vertical;
+    getSubsamplingFactors(subsampling, horizontal, vertical);
+
+    return (plane == 0) ? width : (width + horizontal - 1) / horizontal;
+}
+
+int YUVImage::getPlaneHeight(int plane) const
+{
+    int horizontal, vertical;
+    getSubsamplingFactors(subsampling, horizontal, vertical);
+
+    return (plane == 0) ? height : (height + vertical - 1) / vertical;
+}
+
+int YUVImage::getPlanePitch(int plane) const
+{
+    int horizontal, vertical;
+    getSubsamplingFactors(subsampling, horizontal, vertical);
+
+    int paddedWidth = padSize(width, horizontal);
+
+    return padSize((plane == 0) ? paddedWidth : paddedWidth / horizontal, 4);
+}
+
+int YUVImage::getPlaneOffset(int plane) const
+{
+    int horizontal, vertical;
+    getSubsamplingFactors(subsampling, horizontal, vertical);
+
+    // rows stored in each plane
+    int lumaRows = padSize(height, vertical);
+    int chromaRows = lumaRows / vertical;
+
+    int offset = 0;
+
+    if(plane > 0)
+    {
+        offset += getPlanePitch(0) * lumaRows;
+    }
+
+    if(plane > 1)
+    {
+        offset += getPlanePitch(1) * chromaRows;
+    }
+
+    if(plane > 2)
+    {
+        offset += getPlanePitch(2) * chromaRows;
+    }
+
+    return offset;
+}
+
+int YUVImage::getSize() const
+{
+    return getPlaneOffset(3);
+}
+
+bool YUVImage::isSubsamplingSupported(int subsampling)
+{
+    return subsampling == TJSAMP_444 || subsampling == TJSAMP_422 || subsampling == TJSAMP_420;
+}
+
+unsigned char clampColor(float value)
+{
+    if(value <= 0.)
+    {
+        return 0;
+    }
+    else if(value >= 255.)
+    {
+        return 255;
+    }
+
+    return (unsigned char)(value + 0.5);
+}
+
+QImage convertYUVImageToRGB(const YUVImage & yuvImage)
+{
+    QImage image(yuvImage.width, yuvImage.height, QImage::Format_RGB32);
+
+    int horizontal, vertical;
+    getSubsamplingFactors(yuvImage.subsampling, horizontal, vertical);
+
+    const unsigned char * data = (const unsigned char *)yuvImage.data.constData();
+
+    for(int y=0; y<yuvImage.height; y++)
+    {
+        const unsigned char * yRow = data + yuvImage.getPlaneOffset(0) + y * yuvImage.getPlanePitch(0);
+        const unsigned char * cbRow = data + yuvImage.getPlaneOffset(1) + (y / vertical) * yuvImage.getPlanePitch(1);
+        const unsigned char * crRow = data + yuvImage.getPlaneOffset(2) + (y / vertical) * yuvImage.getPlanePitch(2);
+
+        QRgb * pixels = (QRgb *)image.scanLine(y);
+
+        for(int x=0; x<yuvImage.width; x++)
+        {
+            float luma = yRow[x];
+            float cb = cbRow[x / horizontal] - 128.;
+            float cr = crRow[x / horizontal] - 128.;
+
+            pixels[x] = qRgb(clampColor(luma + 1.402 * cr), clampColor(luma - 0.344136 * cb - 0.714136 * cr), clampColor(luma + 1.772 * cb));
+        }
+    }
+
+    return image;
+}
+
+YUVTexture::YUVTexture()
+{
+    for(int i=0; i<3; i++)
+    {
+        textureIds_[i] = 0;
+        textureWidths_[i] = 0;
+        textureHeights_[i] = 0;
+    }
+
+    width_ = 0;
+    height_ = 0;
+}
+
+YUVTexture::~YUVTexture()
+{
+    // let the OpenGL window delete the textures, so the destructor can occur in any thread...
+    for(int i=0; i<3; i++)
+    {
+        if(textureIds_[i] != 0)
+        {
+            g_mainWindow->getGLWindow()->insertPurgeTextureId(textureIds_[i]);
+        }
+    }
+}
+
+void YUVTexture::getDimensions(int &width, int &height)
+{
+    QMutexLocker locker(&mutex_);
+
+    width = width_;
+    height = height_;
+}
+
+void YUVTexture::setImage(YUVImage image)
+{
+    QMutexLocker locker(&mutex_);
+
+    image_ = image;
+}
+
+bool YUVTexture::update()
+{
+    initializeShaders();
+
+    YUVImage image;
+
+    {
+        QMutexLocker locker(&mutex_);
+
+        if(image_.isNull() == true)
+        {
+            return false;
+        }
+
+        image = image_;
+        image_ = YUVImage();
+
+        width_ = image.width;
+        height_ = image.height;
+    }
+
+    // rows are padded; the row length skips the padding
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for(int i=0; i<3; i++)
+    {
+        int width = image.getPlaneWidth(i);
+        int height = image.getPlaneHeight(i);
+        const char * pixels = image.data.constData() + image.getPlaneOffset(i);
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, image.getPlanePitch(i));
+
+        if(textureIds_[i] == 0)
+        {
+            glGenTextures(1, &textureIds_[i]);
+
+            glBindTexture(GL_TEXTURE_2D, textureIds_[i]);
+
+            // no mipmaps
+            // chroma uses the nearest sample, like convertYUVImageToRGB(), so each pixel gets the chroma of its own block
+            GLint filter = (i == 0) ? GL_LINEAR : GL_NEAREST;
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, textureIds_[i]);
+        }
+
+        // only reallocate when the dimensions change
+        if(width != textureWidths_[i] || height != textureHeights_[i])
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
+
+            textureWidths_[i] = width;
+            textureHeights_[i] = height;
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+
+    glPopClientAttrib();
+
+    return true;
+}
+
+bool YUVTexture::render(float tX, float tY, float tW, float tH)
+{
+    if(textureIds_[0] == 0 || g_yuvShadersAvailable != true)
+    {
+        return false;
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
+
+    // bind the planes to texture units 0 - 2
+    for(int i=2; i>=0; i--)
+    {
+        g_glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textureIds_[i]);
+
+        // on zoom-out, clamp to edge (instead of showing the texture tiled / repeated)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    g_yuvShaderProgram->bind();
+    g_yuvShaderProgram->setUniformValue("yTexture", 0);
+    g_yuvShaderProgram->setUniformValue("cbTexture", 1);
+    g_yuvShaderProgram->setUniformValue("crTexture", 2);
+
+    // all planes cover the same texture coordinates
+    glBegin(GL_QUADS);
+
+    glTexCoord2f(tX,tY);
+    glVertex2f(0.,0.);
+
+    glTexCoord2f(tX+tW,tY);
+    glVertex2f(1.,0.);
+
+    glTexCoord2f(tX+tW,tY+tH);
+    glVertex2f(1.,1.);
+
+    glTexCoord2f(tX,tY+tH);
+    glVertex2f(0.,1.);
+
+    glEnd();
+
+    g_yuvShaderProgram->release();
+
+    glPopAttrib();
+
+    return true;
+}
+
+bool YUVTexture::getShadersAvailable()
+{
+    return g_yuvShadersAvailable;
+}
+
+void YUVTexture::initializeShaders()
+{
+    if(g_yuvShadersInitialized == true)
+    {
+        return;
+    }
+
+    g_yuvShadersInitialized = true;
+
+    const QGLContext * context = QGLContext::currentContext();
+
+    if(context == NULL || QGLShaderProgram::hasOpenGLShaderPrograms() != true)
+    {
+        put_flog(LOG_INFO, "shader programs not available, decoding streams to RGB");
+        return;
+    }
+
+    g_glActiveTexture = (ActiveTextureFunction)context->getProcAddress("glActiveTexture");
+
+    if(g_glActiveTexture == NULL)
+    {
+        g_glActiveTexture = (ActiveTextureFunction)context->getProcAddress("glActiveTextureARB");
+    }
+
+    if(g_glActiveTexture == NULL)
+    {
+        put_flog(LOG_INFO, "multitexturing not available, decoding streams to RGB");
+        return;
+    }
+
+    g_yuvShaderProgram = new QGLShaderProgram();
+
+    if(g_yuvShaderProgram->addShaderFromSourceCode(QGLShader::Fragment, g_yuvFragmentShaderSource) != true || g_yuvShaderProgram->link() != true)
+    {
+        put_flog(LOG_ERROR, "could not build YUV conversion shader: %s", g_yuvShaderProgram->log().toLocal8Bit().constData());
+
+        delete g_yuvShaderProgram;
+        g_yuvShaderProgram = NULL;
+
+        return;
+    }
+
+    g_yuvShadersAvailable = true;
+
+    if(verifyShaders() != true)
+    {
+        put_flog(LOG_ERROR, "YUV conversion shader doesn't match the CPU conversion, decoding streams to RGB");
+
+        g_yuvShadersAvailable = false;
+    }
+}
+
+bool YUVTexture::verifyShaders()
+{
+    if(QGLFramebufferObject::hasOpenGLFramebufferObjects() != true)
+    {
+        put_flog(LOG_WARN, "framebuffer objects not available, can't verify the YUV conversion shader");
+        return true;
+    }
+
+    bool match = true;
+
+    // small images with each subsampling, with the luma and chroma varying across the image
+    int subsamplings[3] = { TJSAMP_444, TJSAMP_422, TJSAMP_420 };
+
+    for(int i=0; i<3 && match == true; i++)
+    {
+        YUVImage yuvImage(YUV_TEXTURE_VERIFY_SIZE, YUV_TEXTURE_VERIFY_SIZE, subsamplings[i]);
+
+        for(int plane=0; plane<3; plane++)
+        {
+            for(int y=0; y<yuvImage.getPlaneHeight(plane); y++)
+            {
+                unsigned char * row = (unsigned char *)yuvImage.data.data() + yuvImage.getPlaneOffset(plane) + y * yuvImage.getPlanePitch(plane);
+
+                for(int x=0; x<yuvImage.getPlaneWidth(plane); x++)
+                {
+                    row[x] = (unsigned char)(16 + (37 * x + 59 * y + 83 * plane) % 224);
+                }
+            }
+        }
+
+        QImage reference = convertYUVImageToRGB(yuvImage);
+
+        // draw the image pixel for pixel into a framebuffer object, with the first row at the top
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0., 1., 1., 0., -1., 1.);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+
+        QGLFramebufferObject fbo(yuvImage.width, yuvImage.height);
+        fbo.bind();
+
+        glViewport(0, 0, yuvImage.width, yuvImage.height);
+
+        YUVTexture texture;
+        texture.setImage(yuvImage);
+        texture.update();
+        texture.render(0., 0., 1., 1.);
+
+        fbo.release();
+
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+        glPopAttrib();
+
+        QImage image = fbo.toImage();
+
+        for(int y=0; y<reference.height() && match == true; y++)
+        {
+            for(int x=0; x<reference.width(); x++)
+            {
+                QRgb a = reference.pixel(x, y);
+                QRgb b = image.pixel(x, y);
+
+                if(qAbs(qRed(a) - qRed(b)) > YUV_TEXTURE_VERIFY_TOLERANCE || qAbs(qGreen(a) - qGreen(b)) > YUV_TEXTURE_VERIFY_TOLERANCE || qAbs(qBlue(a) - qBlue(b)) > YUV_TEXTURE_VERIFY_TOLERANCE)
+                {
+                    put_flog(LOG_ERROR, "subsampling %i, pixel (%i, %i): shader (%i, %i, %i), reference (%i, %i, %i)", subsamplings[i], x, y, qRed(b), qGreen(b), qBlue(b), qRed(a), qGreen(a), qBlue(a));
+
+                    match = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return match;
+}
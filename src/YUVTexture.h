@@ -0,0 +1,133 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef YUV_TEXTURE_H
+#define YUV_TEXTURE_H
+
+// size (pixels) of the images used to verify the conversion shader against convertYUVImageToRGB()
+#define YUV_TEXTURE_VERIFY_SIZE 16
+
+// maximum difference per color component between the shader and convertYUVImageToRGB()
+#define YUV_TEXTURE_VERIFY_TOLERANCE 2
+
+#include <QGLWidget>
+#include <QtCore>
+
+// planar YCbCr image, as decoded by tjDecompressToYUV(): the Y, Cb and Cr planes follow each other in data,
+// each row padded to a multiple of 4 bytes and each plane padded to a whole number of chroma samples
+struct YUVImage {
+
+    int width;
+    int height;
+
+    // TJSAMP_444, TJSAMP_422 or TJSAMP_420
+    int subsampling;
+
+    QByteArray data;
+
+    YUVImage();
+    YUVImage(int width, int height, int subsampling);
+
+    bool isNull() const;
+
+    // plane 0 is Y, 1 is Cb, and 2 is Cr
+    // the plane width and height only cover the image, the pitch includes the padding
+    int getPlaneWidth(int plane) const;
+    int getPlaneHeight(int plane) const;
+    int getPlanePitch(int plane) const;
+    int getPlaneOffset(int plane) const;
+
+    // total size of the planes, including padding
+    int getSize() const;
+
+    // whether tjDecompressToYUV() output with this subsampling is supported
+    static bool isSubsamplingSupported(int subsampling);
+};
+
+// CPU reference of the shader conversion (JFIF full-range YCbCr to RGB, nearest chroma sample)
+// the shader is checked against this when it is built; streams fall back to RGB decoding if they differ
+extern QImage convertYUVImageToRGB(const YUVImage & yuvImage);
+
+// a YUV image uploaded to one luminance texture per plane, and converted to RGB by a fragment shader when drawn
+// this uploads 1.5 (4:2:0) to 3 (4:4:4) bytes per pixel instead of 4, and saves the CPU color conversion
+class YUVTexture {
+
+    public:
+
+        YUVTexture();
+        ~YUVTexture();
+
+        void getDimensions(int &width, int &height);
+
+        // queue an image for upload, replacing any image waiting to be uploaded
+        void setImage(YUVImage image);
+
+        // for use in the OpenGL thread: upload the latest queued image; returns true if the textures were updated
+        bool update();
+
+        // for use in the OpenGL thread: draw the unit square with the given texture coordinates
+        // returns false if nothing was uploaded yet
+        bool render(float tX, float tY, float tW, float tH);
+
+        // whether the conversion shader is available; determined in the OpenGL thread by the first call to update()
+        // until then, this returns false
+        static bool getShadersAvailable();
+
+    private:
+
+        // protects image_
+        QMutex mutex_;
+
+        // image waiting to be uploaded
+        YUVImage image_;
+
+        GLuint textureIds_[3];
+        int textureWidths_[3];
+        int textureHeights_[3];
+
+        int width_;
+        int height_;
+
+        // for use in the OpenGL thread: compile and link the conversion shader, once
+        static void initializeShaders();
+
+        // for use in the OpenGL thread: draw test images with the shader and compare them to convertYUVImageToRGB()
+        static bool verifyShaders();
+};
+
+#endif
@@ -0,0 +1,830 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "DcSocket.h"
+#include "../NetworkProtocol.h"
+#include "../ImageHash.h"
+#include "../log.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+struct DcImage {
+    const unsigned char * imageBuffer;
+    int width;
+    int pitch;
+    int height;
+    PIXEL_FORMAT pixelFormat;
+    char * segmentData;
+    int segmentBufferSize;
+    int segmentSize;
+    DcStreamEncoderOptions encoderOptions;
+
+    // the hash of the segment is computed first, and it is only compressed if the hash differs from previousHash
+    bool checkUnchanged;
+    uint64_t previousHash;
+    uint64_t hash;
+    bool unchanged;
+};
+
+DcImage dcStreamComputeSegmentMapped(const DcImage & dcImage)
+{
+    DcImage newDcImage = dcImage;
+
+    newDcImage.hash = computeImageHash(newDcImage.imageBuffer, newDcImage.width * dcBytesPerPixel[newDcImage.pixelFormat], newDcImage.pitch, newDcImage.height);
+    newDcImage.unchanged = (newDcImage.checkUnchanged == true && newDcImage.hash == newDcImage.previousHash);
+
+    if(newDcImage.unchanged == true)
+    {
+        return newDcImage;
+    }
+
+    dcStreamComputeSegment(newDcImage.imageBuffer, newDcImage.width, newDcImage.pitch, newDcImage.height, newDcImage.pixelFormat, newDcImage.segmentData, newDcImage.segmentBufferSize, newDcImage.segmentSize, newDcImage.encoderOptions);
+
+    return newDcImage;
+}
+
+DcSocket::DcSocket(std::string hostname)
+{
+    // defaults
+    connected_ = false;
+    connectFinished_ = false;
+    stopping_ = false;
+    queuePolicy_ = DC_STREAM_QUEUE_BLOCK;
+    maxQueuedFrames_ = DC_SOCKET_DEFAULT_MAX_QUEUED_FRAMES;
+    nextFrameId_ = 1;
+    encoderOptions_ = dcStreamGetDefaultEncoderOptions();
+    adaptiveQuality_ = encoderOptions_.quality;
+    averageFrameTime_ = -1.;
+    socket_ = NULL;
+    protocolVersion_ = NETWORK_PROTOCOL_HANDSHAKE_VERSION;
+    windowMessages_ = 1;
+    windowBytes_ = INT_MAX;
+    unacknowledgedBytes_ = 0;
+
+    // assign values
+    hostname_ = hostname;
+    port_ = DC_SOCKET_DEFAULT_PORT;
+
+    // hostname:port, e.g. for connecting through a proxy
+    size_t colon = hostname.rfind(':');
+
+    if(colon != std::string::npos && hostname.find(':') == colon)
+    {
+        hostname_ = hostname.substr(0, colon);
+        port_ = atoi(hostname.substr(colon + 1).c_str());
+    }
+}
+
+DcSocket::~DcSocket()
+{
+    // the sender thread sends all queued jobs before it exits
+    {
+        QMutexLocker locker(&mutex_);
+
+        stopping_ = true;
+        jobsChanged_.wakeAll();
+    }
+
+    wait();
+}
+
+bool DcSocket::waitForConnected()
+{
+    QMutexLocker locker(&mutex_);
+
+    while(connectFinished_ != true)
+    {
+        jobsChanged_.wait(&mutex_);
+    }
+
+    return connected_;
+}
+
+int DcSocket::enqueue(DcSendJob job)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(connected_ != true)
+    {
+        return -1;
+    }
+
+    job.frameId = nextFrameId_++;
+
+    // apply the queue policy to asynchronous frames
+    if(job.droppable == true)
+    {
+        while(connected_ == true && getNumDroppableJobs() >= maxQueuedFrames_)
+        {
+            if(queuePolicy_ == DC_STREAM_QUEUE_DROP_OLDEST)
+            {
+                for(std::deque<DcSendJob>::iterator it=jobs_.begin(); it != jobs_.end(); it++)
+                {
+                    if((*it).droppable == true)
+                    {
+                        frameResults_[(*it).frameId] = false;
+                        jobs_.erase(it);
+                        break;
+                    }
+                }
+
+                frameFinished_.wakeAll();
+            }
+            else
+            {
+                jobsChanged_.wait(&mutex_);
+            }
+        }
+
+        if(connected_ != true)
+        {
+            return -1;
+        }
+    }
+
+    jobs_.push_back(job);
+    jobsChanged_.wakeAll();
+
+    return job.frameId;
+}
+
+bool DcSocket::waitForFrame(int frameId)
+{
+    QMutexLocker locker(&mutex_);
+
+    while(frameId >= nextFrameId_ - DC_SOCKET_MAX_FRAME_RESULTS && frameResults_.count(frameId) == 0)
+    {
+        frameFinished_.wait(&mutex_);
+    }
+
+    if(frameResults_.count(frameId) == 0)
+    {
+        // finished long ago; the result isn't known anymore
+        return true;
+    }
+
+    return frameResults_[frameId];
+}
+
+bool DcSocket::isFrameFinished(int frameId)
+{
+    QMutexLocker locker(&mutex_);
+
+    return frameId < nextFrameId_ - DC_SOCKET_MAX_FRAME_RESULTS || frameResults_.count(frameId) != 0;
+}
+
+void DcSocket::setQueuePolicy(DC_STREAM_QUEUE_POLICY policy, int maxQueuedFrames)
+{
+    QMutexLocker locker(&mutex_);
+
+    queuePolicy_ = policy;
+    maxQueuedFrames_ = std::max(maxQueuedFrames, 1);
+
+    jobsChanged_.wakeAll();
+}
+
+void DcSocket::setEncoderOptions(DcStreamEncoderOptions options)
+{
+    QMutexLocker locker(&mutex_);
+
+    encoderOptions_ = options;
+
+    // adapt from the new maximum quality
+    adaptiveQuality_ = options.quality;
+    averageFrameTime_ = -1.;
+}
+
+DcStreamEncoderOptions DcSocket::getEncoderOptions()
+{
+    QMutexLocker locker(&mutex_);
+
+    DcStreamEncoderOptions options = encoderOptions_;
+
+    if(options.adaptive == true)
+    {
+        options.quality = adaptiveQuality_;
+    }
+
+    // the codec is only sent to servers that support it; otherwise fall back to JPEG
+    if(protocolVersion_ < NETWORK_PROTOCOL_CODEC_VERSION)
+    {
+        options.codec = DC_STREAM_CODEC_JPEG;
+    }
+
+    return options;
+}
+
+void DcSocket::appendSegmentMessage(DcSendJob & job, const DcStreamParameters & parameters, int frameIndex, const char * jpegData, int jpegSize)
+{
+    // the payload: parameters, then image data
+    ParallelPixelStreamSegmentParameters p = getSegmentParameters(parameters, frameIndex, DC_STREAM_CODEC_JPEG);
+
+    QByteArray payload;
+    payload.reserve(getSegmentParametersSize() + jpegSize);
+    payload.append((const char *)&p, getSegmentParametersSize());
+
+    if(jpegSize > 0)
+    {
+        payload.append(jpegData, jpegSize);
+    }
+
+    job.headers.push_back(getSegmentMessageHeader(parameters, payload.size()));
+    job.payloads.push_back(payload);
+
+    // the sender thread no longer knows what this segment looks like
+    job.invalidatedSegments.push_back(DcSegmentKey(parameters.name, parameters.sourceIndex));
+}
+
+MessageHeader DcSocket::getSegmentMessageHeader(const DcStreamParameters & parameters, int size)
+{
+    MessageHeader mh;
+    mh.size = size;
+    mh.type = MESSAGE_TYPE_PARALLEL_PIXELSTREAM;
+
+    // add the truncated URI to the header
+    size_t len = parameters.name.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
+    mh.uri[len] = '\0';
+
+    return mh;
+}
+
+int DcSocket::getSegmentParametersSize()
+{
+    // older servers don't know about codecs
+    if(protocolVersion_ < NETWORK_PROTOCOL_CODEC_VERSION)
+    {
+        return PARALLEL_PIXEL_STREAM_SEGMENT_PARAMETERS_LEGACY_SIZE;
+    }
+
+    return sizeof(ParallelPixelStreamSegmentParameters);
+}
+
+ParallelPixelStreamSegmentParameters DcSocket::getSegmentParameters(const DcStreamParameters & parameters, int frameIndex, DC_STREAM_CODEC codec)
+{
+    ParallelPixelStreamSegmentParameters p;
+
+    p.sourceIndex = parameters.sourceIndex;
+    p.frameIndex = frameIndex;
+    p.x = parameters.x;
+    p.y = parameters.y;
+    p.width = parameters.width;
+    p.height = parameters.height;
+    p.totalWidth = parameters.totalWidth;
+    p.totalHeight = parameters.totalHeight;
+    p.codec = codec;
+
+    return p;
+}
+
+void DcSocket::run()
+{
+    bool connected = connectToHost();
+
+    {
+        QMutexLocker locker(&mutex_);
+
+        connected_ = connected;
+        connectFinished_ = true;
+        jobsChanged_.wakeAll();
+    }
+
+    while(connected == true)
+    {
+        DcSendJob job;
+
+        {
+            QMutexLocker locker(&mutex_);
+
+            while(jobs_.size() == 0 && stopping_ != true)
+            {
+                jobsChanged_.wait(&mutex_);
+            }
+
+            if(jobs_.size() == 0)
+            {
+                break;
+            }
+
+            job = jobs_.front();
+            jobs_.pop_front();
+
+            // there's room in the queue now
+            jobsChanged_.wakeAll();
+        }
+
+        bool success = processJob(job);
+
+        finishFrame(job.frameId, success);
+
+        if(socket_->state() != QAbstractSocket::ConnectedState)
+        {
+            put_flog(LOG_ERROR, "connection lost");
+
+            // fail the remaining jobs
+            QMutexLocker locker(&mutex_);
+
+            connected_ = false;
+
+            while(jobs_.size() > 0)
+            {
+                frameResults_[jobs_.front().frameId] = false;
+                jobs_.pop_front();
+            }
+
+            frameFinished_.wakeAll();
+            jobsChanged_.wakeAll();
+
+            break;
+        }
+    }
+
+    if(socket_ != NULL)
+    {
+        // wait for all messages to be acknowledged, so they're all handled before we disconnect
+        while(unacknowledgedMessageSizes_.size() > 0 && readAcknowledgment(true) == true)
+        {
+            unacknowledgedMessageSizes_.pop_front();
+        }
+
+        socket_->disconnectFromHost();
+
+        delete socket_;
+        socket_ = NULL;
+    }
+}
+
+bool DcSocket::connectToHost()
+{
+    // the socket is created here so it belongs to this thread
+    socket_ = new QTcpSocket();
+
+    // open connection
+    socket_->connectToHost(hostname_.c_str(), port_);
+
+    if(socket_->waitForConnected() != true)
+    {
+        put_flog(LOG_ERROR, "could not connect to host %s port %i", hostname_.c_str(), port_);
+
+        return false;
+    }
+
+    // handshake
+    while(socket_->bytesAvailable() < (int)sizeof(int32_t))
+    {
+        if(socket_->waitForReadyRead() != true)
+        {
+            put_flog(LOG_ERROR, "no handshake from host %s", hostname_.c_str());
+
+            return false;
+        }
+    }
+
+    int32_t protocolVersion = -1;
+    socket_->read((char *)&protocolVersion, sizeof(int32_t));
+
+    if(protocolVersion != NETWORK_PROTOCOL_HANDSHAKE_VERSION)
+    {
+        socket_->disconnectFromHost();
+
+        put_flog(LOG_ERROR, "unsupported protocol version %i != %i", protocolVersion, NETWORK_PROTOCOL_HANDSHAKE_VERSION);
+
+        return false;
+    }
+
+    // request the current protocol version, for windowed flow control
+    upgradeProtocol();
+
+    return true;
+}
+
+void DcSocket::upgradeProtocol()
+{
+    // request the current version
+    MessageHeader mh;
+    mh.size = sizeof(int32_t);
+    mh.type = MESSAGE_TYPE_PROTOCOL_UPGRADE;
+    mh.uri[0] = '\0';
+
+    int32_t requestedVersion = NETWORK_PROTOCOL_VERSION;
+
+    socket_->write((const char *)&mh, sizeof(MessageHeader));
+    socket_->write((const char *)&requestedVersion, sizeof(int32_t));
+
+    // the reply is "win" followed by the granted version and window, or "ack" from servers that don't support upgrades
+    while(socket_->bytesAvailable() < 3)
+    {
+        if(socket_->waitForReadyRead() != true)
+        {
+            put_flog(LOG_ERROR, "no reply to protocol upgrade");
+            return;
+        }
+    }
+
+    if(socket_->read(3) == "win")
+    {
+        int32_t reply[3];
+
+        while(socket_->bytesAvailable() < (int)sizeof(reply))
+        {
+            if(socket_->waitForReadyRead() != true)
+            {
+                put_flog(LOG_ERROR, "incomplete reply to protocol upgrade");
+                return;
+            }
+        }
+
+        socket_->read((char *)reply, sizeof(reply));
+
+        protocolVersion_ = reply[0];
+
+        if(protocolVersion_ >= NETWORK_PROTOCOL_WINDOWED_VERSION)
+        {
+            windowMessages_ = reply[1];
+            windowBytes_ = reply[2];
+        }
+    }
+
+    put_flog(LOG_DEBUG, "protocol version %i, window %i messages / %i bytes", protocolVersion_, windowMessages_, windowBytes_);
+}
+
+bool DcSocket::processJob(DcSendJob & job)
+{
+    bool allSuccess = true;
+
+    DcStreamEncoderOptions encoderOptions = getEncoderOptions();
+
+    QTime frameTime;
+    frameTime.start();
+
+    for(unsigned int i=0; i<job.invalidatedSegments.size(); i++)
+    {
+        segmentStates_.erase(job.invalidatedSegments[i]);
+    }
+
+    // compress the image first, if any
+    if(job.imageBuffer != NULL && job.pixelStreamName.empty() != true)
+    {
+        allSuccess = computePixelStreamMessages(job, encoderOptions);
+    }
+    else if(job.imageBuffer != NULL)
+    {
+        allSuccess = computeSegmentMessages(job, encoderOptions);
+    }
+
+    for(unsigned int i=0; i<job.headers.size(); i++)
+    {
+        if(sendMessage(job.headers[i], job.payloads[i]) != true)
+        {
+            return false;
+        }
+    }
+
+    if(job.imageBuffer != NULL && encoderOptions.adaptive == true)
+    {
+        adaptQuality(frameTime.elapsed());
+    }
+
+    return allSuccess;
+}
+
+bool DcSocket::computeSegmentMessages(DcSendJob & job, DcStreamEncoderOptions encoderOptions)
+{
+    std::vector<DcImage> dcImages;
+
+    int parametersSize = getSegmentParametersSize();
+
+    // segments are compressed into buffers reused across jobs, after room for their parameters
+    if(segmentBuffers_.size() < job.parameters.size())
+    {
+        segmentBuffers_.resize(job.parameters.size());
+    }
+
+    for(unsigned int i=0; i<job.parameters.size(); i++)
+    {
+        int bufferSize = parametersSize + dcStreamGetMaxSegmentSize(job.parameters[i].width, job.parameters[i].height, encoderOptions.codec);
+
+        if((int)segmentBuffers_[i].size() < bufferSize)
+        {
+            segmentBuffers_[i].resize(bufferSize);
+        }
+
+        DcImage d;
+
+        // imageBuffer coordinates have the origin at the bottom-left corner.
+        // DisplayCluster's coordinates have the origin at the top-left.
+        // a transformation is needed to find the appropriate memory location within the full imageBuffer...
+        d.imageBuffer = job.imageBuffer + job.imageHeight*job.imagePitch - (job.parameters[i].y - job.imageY + job.parameters[i].height)*job.imagePitch + (job.parameters[i].x - job.imageX)*dcBytesPerPixel[job.pixelFormat];
+
+        d.width = job.parameters[i].width;
+        d.pitch = job.imagePitch;
+        d.height = job.parameters[i].height;
+        d.pixelFormat = job.pixelFormat;
+        d.encoderOptions = encoderOptions;
+        d.segmentData = &segmentBuffers_[i][parametersSize];
+        d.segmentBufferSize = segmentBuffers_[i].size() - parametersSize;
+        d.segmentSize = 0;
+
+        // only skip unchanged segments if the server supports it, and resend them periodically anyway:
+        // segments are only delivered to the processes displaying them, and others may need them later
+        DcSegmentKey key(job.parameters[i].name, job.parameters[i].sourceIndex);
+
+        d.checkUnchanged = false;
+        d.previousHash = 0;
+        d.hash = 0;
+        d.unchanged = false;
+
+        if(encoderOptions.skipUnchangedSegments == true && protocolVersion_ >= NETWORK_PROTOCOL_UNCHANGED_SEGMENTS_VERSION && segmentStates_.count(key) != 0 && segmentStates_[key].codec == encoderOptions.codec && segmentStates_[key].unchangedFrames < DC_SOCKET_SEGMENT_REFRESH_INTERVAL)
+        {
+            d.checkUnchanged = true;
+            d.previousHash = segmentStates_[key].hash;
+        }
+
+        dcImages.push_back(d);
+    }
+
+    // compress each changed segment, in parallel
+    dcImages = QtConcurrent::blockingMapped<std::vector<DcImage> >(dcImages, &dcStreamComputeSegmentMapped);
+
+    bool allSuccess = true;
+
+    for(unsigned int i=0; i<dcImages.size(); i++)
+    {
+        DcSegmentKey key(job.parameters[i].name, job.parameters[i].sourceIndex);
+
+        if(dcImages[i].unchanged == true)
+        {
+            // send the parameters only, so the segment still counts for this frame index
+            ParallelPixelStreamSegmentParameters p = getSegmentParameters(job.parameters[i], job.frameIndex, encoderOptions.codec);
+
+            job.headers.push_back(getSegmentMessageHeader(job.parameters[i], parametersSize));
+            job.payloads.push_back(QByteArray((const char *)&p, parametersSize));
+
+            segmentStates_[key].unchangedFrames++;
+        }
+        // segmentSize == 0 indicates an error
+        else if(dcImages[i].segmentSize == 0)
+        {
+            allSuccess = false;
+
+            segmentStates_.erase(key);
+        }
+        else
+        {
+            // stagger the periodic resends of new segments
+            if(segmentStates_.count(key) == 0)
+            {
+                segmentStates_[key].unchangedFrames = job.parameters[i].sourceIndex % DC_SOCKET_SEGMENT_REFRESH_INTERVAL;
+            }
+            else
+            {
+                segmentStates_[key].unchangedFrames = 0;
+            }
+
+            segmentStates_[key].hash = dcImages[i].hash;
+            segmentStates_[key].codec = encoderOptions.codec;
+
+            // the payload references the segment buffer, which isn't reused until this job is sent
+            ParallelPixelStreamSegmentParameters p = getSegmentParameters(job.parameters[i], job.frameIndex, encoderOptions.codec);
+            memcpy(&segmentBuffers_[i][0], &p, parametersSize);
+
+            int size = parametersSize + dcImages[i].segmentSize;
+
+            job.headers.push_back(getSegmentMessageHeader(job.parameters[i], size));
+            job.payloads.push_back(QByteArray::fromRawData(&segmentBuffers_[i][0], size));
+        }
+    }
+
+    return allSuccess;
+}
+
+bool DcSocket::computePixelStreamMessages(DcSendJob & job, DcStreamEncoderOptions encoderOptions)
+{
+    // pixel streams are always JPEG
+    int bufferSize = dcStreamGetMaxJpegSize(job.imageWidth, job.imageHeight);
+
+    if((int)pixelStreamBuffer_.size() < bufferSize)
+    {
+        pixelStreamBuffer_.resize(bufferSize);
+    }
+
+    int jpegSize = 0;
+
+    if(dcStreamComputeJpeg(job.imageBuffer, job.imageWidth, job.imagePitch, job.imageHeight, job.pixelFormat, &pixelStreamBuffer_[0], pixelStreamBuffer_.size(), jpegSize, encoderOptions) != true)
+    {
+        return false;
+    }
+
+    MessageHeader mh;
+    mh.size = jpegSize;
+    mh.type = MESSAGE_TYPE_PIXELSTREAM;
+
+    // add the truncated URI to the header
+    size_t len = job.pixelStreamName.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
+    mh.uri[len] = '\0';
+
+    // the payload references the buffer, which isn't reused until this job is sent
+    job.headers.push_back(mh);
+    job.payloads.push_back(QByteArray::fromRawData(&pixelStreamBuffer_[0], jpegSize));
+
+    // the server needs the dimensions of the pixel stream when they change
+    std::pair<int, int> dimensions(job.imageWidth, job.imageHeight);
+
+    if(pixelStreamDimensions_.count(job.pixelStreamName) == 0 || pixelStreamDimensions_[job.pixelStreamName] != dimensions)
+    {
+        int32_t dimensionsPayload[2];
+        dimensionsPayload[0] = job.imageWidth;
+        dimensionsPayload[1] = job.imageHeight;
+
+        mh.size = sizeof(dimensionsPayload);
+        mh.type = MESSAGE_TYPE_PIXELSTREAM_DIMENSIONS_CHANGED;
+
+        job.headers.push_back(mh);
+        job.payloads.push_back(QByteArray((const char *)dimensionsPayload, sizeof(dimensionsPayload)));
+
+        pixelStreamDimensions_[job.pixelStreamName] = dimensions;
+    }
+
+    return true;
+}
+
+bool DcSocket::sendMessage(const MessageHeader & messageHeader, const QByteArray & payload)
+{
+    if(socket_->state() != QAbstractSocket::ConnectedState)
+    {
+        put_flog(LOG_ERROR, "socket is not connected");
+
+        return false;
+    }
+
+    // send the header
+    int sent = socket_->write((const char *)&messageHeader, sizeof(MessageHeader));
+
+    while(sent < (int)sizeof(MessageHeader))
+    {
+        sent += socket_->write((const char *)&messageHeader + sent, sizeof(MessageHeader) - sent);
+    }
+
+    // send the message
+    if(payload.size() > 0)
+    {
+        sent = socket_->write(payload.constData(), payload.size());
+
+        while(sent < payload.size())
+        {
+            sent += socket_->write(payload.constData() + sent, payload.size() - sent);
+        }
+    }
+
+    // make sure the message is actually sent now; we may not wait on the socket again for a while
+    while(socket_->bytesToWrite() > 0)
+    {
+        if(socket_->waitForBytesWritten() != true)
+        {
+            break;
+        }
+    }
+
+    int size = sizeof(MessageHeader) + payload.size();
+
+    unacknowledgedMessageSizes_.push_back(size);
+    unacknowledgedBytes_ += size;
+
+    // collect the acknowledgments already received, then wait for more only while the window is full
+    while(unacknowledgedMessageSizes_.size() > 0)
+    {
+        bool windowFull = (int)unacknowledgedMessageSizes_.size() >= windowMessages_ || unacknowledgedBytes_ > windowBytes_;
+
+        if(readAcknowledgment(windowFull) != true)
+        {
+            if(windowFull == true)
+            {
+                // we can't send more without exceeding the window; treat the connection as lost
+                put_flog(LOG_ERROR, "timed out waiting for acknowledgment");
+
+                socket_->abort();
+
+                return false;
+            }
+
+            break;
+        }
+
+        unacknowledgedBytes_ -= unacknowledgedMessageSizes_.front();
+        unacknowledgedMessageSizes_.pop_front();
+    }
+
+    return socket_->state() == QAbstractSocket::ConnectedState;
+}
+
+bool DcSocket::readAcknowledgment(bool wait)
+{
+    while(socket_->bytesAvailable() < 3)
+    {
+        if(wait != true || socket_->waitForReadyRead() != true)
+        {
+            return false;
+        }
+    }
+
+    socket_->read(3);
+
+    return true;
+}
+
+void DcSocket::adaptQuality(int frameTime)
+{
+    QMutexLocker locker(&mutex_);
+
+    if(averageFrameTime_ < 0.)
+    {
+        averageFrameTime_ = frameTime;
+    }
+    else
+    {
+        averageFrameTime_ = 0.8 * averageFrameTime_ + 0.2 * frameTime;
+    }
+
+    float targetFrameTime = 1000. / std::max(encoderOptions_.targetFrameRate, 1.f);
+
+    int numQueuedFrames = getNumDroppableJobs();
+
+    if(averageFrameTime_ > targetFrameTime || numQueuedFrames >= maxQueuedFrames_)
+    {
+        adaptiveQuality_ -= DC_SOCKET_ADAPTIVE_QUALITY_DECREASE;
+    }
+    else if(averageFrameTime_ < DC_SOCKET_ADAPTIVE_HEADROOM * targetFrameTime && numQueuedFrames == 0)
+    {
+        adaptiveQuality_ += DC_SOCKET_ADAPTIVE_QUALITY_INCREASE;
+    }
+
+    adaptiveQuality_ = std::max(encoderOptions_.minQuality, std::min(adaptiveQuality_, encoderOptions_.quality));
+
+    put_flog(LOG_DEBUG, "frame time %i ms (average %f), %i queued frames: quality %i", frameTime, averageFrameTime_, numQueuedFrames, adaptiveQuality_);
+}
+
+void DcSocket::finishFrame(int frameId, bool success)
+{
+    QMutexLocker locker(&mutex_);
+
+    frameResults_[frameId] = success;
+
+    // forget old results
+    while(frameResults_.size() > 0 && frameResults_.begin()->first < nextFrameId_ - DC_SOCKET_MAX_FRAME_RESULTS)
+    {
+        frameResults_.erase(frameResults_.begin());
+    }
+
+    frameFinished_.wakeAll();
+}
+
+int DcSocket::getNumDroppableJobs()
+{
+    int count = 0;
+
+    for(unsigned int i=0; i<jobs_.size(); i++)
+    {
+        if(jobs_[i].droppable == true)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,226 @@
+/*********************************************************************/
+/* Copyright (c) 2011 - 2012, The University of Texas at Austin.     */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DC_SOCKET_H
+#define DC_SOCKET_H
+
+// port of the DisplayCluster network listener, unless the hostname is given as hostname:port
+#define DC_SOCKET_DEFAULT_PORT 1701
+
+// default number of queued frames before the queue policy applies
+#define DC_SOCKET_DEFAULT_MAX_QUEUED_FRAMES 2
+
+#include "dcStream.h"
+#include "../MessageHeader.h"
+#include "../ParallelPixelStreamSegmentParameters.h"
+#include "../ImageHash.h"
+#include <QtCore>
+#include <QtNetwork/QTcpSocket>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// bytes per pixel for each PIXEL_FORMAT
+extern int dcBytesPerPixel[];
+
+// adaptive quality: steps down when a frame is too slow, and up when it takes less than this fraction of the target frame time
+#define DC_SOCKET_ADAPTIVE_QUALITY_DECREASE 5
+#define DC_SOCKET_ADAPTIVE_QUALITY_INCREASE 1
+#define DC_SOCKET_ADAPTIVE_HEADROOM 0.75
+
+// unchanged segments are resent at least every this many frames
+#define DC_SOCKET_SEGMENT_REFRESH_INTERVAL 60
+
+// number of recent frame results kept for dcStreamWaitForFrame() / dcStreamFrameFinished()
+#define DC_SOCKET_MAX_FRAME_RESULTS 1024
+
+// stream name and source index of a segment
+typedef std::pair<std::string, int> DcSegmentKey;
+
+// what was last sent for a segment
+struct DcSegmentState {
+
+    DcSegmentState() : hash(0), codec(DC_STREAM_CODEC_JPEG), unchangedFrames(0) { }
+
+    // hash of the raw pixels, and the codec they were sent with
+    uint64_t hash;
+    DC_STREAM_CODEC codec;
+
+    // frames since the segment was last sent with image data
+    int unchangedFrames;
+};
+
+// a unit of work for the sender thread: messages to send, or an image to compress into segments and send
+struct DcSendJob {
+
+    DcSendJob() : frameId(0), droppable(false), imageBuffer(NULL), imageX(0), imageY(0), imageWidth(0), imagePitch(0), imageHeight(0), pixelFormat(RGBA) { }
+
+    int frameId;
+
+    // only asynchronous frames may be dropped by the queue policy
+    bool droppable;
+
+    // messages ready to send
+    std::vector<MessageHeader> headers;
+    std::vector<QByteArray> payloads;
+
+    // segments sent with caller-provided image data
+    std::vector<DcSegmentKey> invalidatedSegments;
+
+    // image to compress; imageBuffer points either to imageCopy or to a caller-owned buffer
+    const unsigned char * imageBuffer;
+    QByteArray imageCopy;
+    int imageX;
+    int imageY;
+    int imageWidth;
+    int imagePitch;
+    int imageHeight;
+    PIXEL_FORMAT pixelFormat;
+
+    // segments of the image, with the frame index at the time the job was queued
+    std::vector<DcStreamParameters> parameters;
+    int frameIndex;
+
+    // if set, the image is sent as a single JPEG image of this (non-parallel) pixel stream instead of in segments
+    std::string pixelStreamName;
+};
+
+// a connection to a DisplayCluster instance
+// all socket I/O happens in the sender thread, so the caller's thread only blocks when it waits for a job or the queue is full
+class DcSocket : public QThread {
+
+    public:
+
+        DcSocket(std::string hostname);
+        ~DcSocket();
+
+        // wait for the connection, handshake and protocol upgrade; returns false if any of them failed
+        bool waitForConnected();
+
+        // queue a job and return its frame id, or -1 if the connection was lost
+        int enqueue(DcSendJob job);
+
+        // wait for a job to be sent; returns false if it was dropped or sending failed
+        bool waitForFrame(int frameId);
+
+        // whether a job was sent (or dropped)
+        bool isFrameFinished(int frameId);
+
+        void setQueuePolicy(DC_STREAM_QUEUE_POLICY policy, int maxQueuedFrames);
+
+        void setEncoderOptions(DcStreamEncoderOptions options);
+
+        // the encoder options, with the current quality in adaptive mode
+        DcStreamEncoderOptions getEncoderOptions();
+
+        // add a parallel pixel stream segment message with JPEG image data to a job
+        void appendSegmentMessage(DcSendJob & job, const DcStreamParameters & parameters, int frameIndex, const char * jpegData, int jpegSize);
+
+    protected:
+
+        void run();
+
+    private:
+
+        std::string hostname_;
+        int port_;
+
+        // mutex and conditions for everything below that is shared with the caller's thread
+        QMutex mutex_;
+        QWaitCondition jobsChanged_;
+        QWaitCondition frameFinished_;
+
+        bool connected_;
+        bool connectFinished_;
+        bool stopping_;
+
+        std::deque<DcSendJob> jobs_;
+
+        DC_STREAM_QUEUE_POLICY queuePolicy_;
+        int maxQueuedFrames_;
+
+        int nextFrameId_;
+
+        DcStreamEncoderOptions encoderOptions_;
+
+        // adaptive mode: current quality and smoothed frame time (ms), or -1 before the first frame
+        int adaptiveQuality_;
+        float averageFrameTime_;
+
+        // results of the recently finished jobs (false if dropped or failed)
+        std::map<int, bool> frameResults_;
+
+        // sender thread only: compressed segment buffers, reused for each job
+        std::vector<std::vector<char> > segmentBuffers_;
+
+        // sender thread only: segments last sent on this connection
+        std::map<DcSegmentKey, DcSegmentState> segmentStates_;
+
+        // sender thread only: compressed pixel stream image buffer, and the dimensions last sent for each pixel stream
+        std::vector<char> pixelStreamBuffer_;
+        std::map<std::string, std::pair<int, int> > pixelStreamDimensions_;
+
+        // sender thread only: the socket and its flow control state
+        QTcpSocket * socket_;
+
+        int protocolVersion_;
+        int windowMessages_;
+        int windowBytes_;
+        std::deque<int> unacknowledgedMessageSizes_;
+        int unacknowledgedBytes_;
+
+        static MessageHeader getSegmentMessageHeader(const DcStreamParameters & parameters, int size);
+        static ParallelPixelStreamSegmentParameters getSegmentParameters(const DcStreamParameters & parameters, int frameIndex, DC_STREAM_CODEC codec);
+
+        // size of the parameters sent for the negotiated protocol version
+        int getSegmentParametersSize();
+
+        bool connectToHost();
+        void upgradeProtocol();
+        bool processJob(DcSendJob & job);
+        bool computeSegmentMessages(DcSendJob & job, DcStreamEncoderOptions encoderOptions);
+        bool computePixelStreamMessages(DcSendJob & job, DcStreamEncoderOptions encoderOptions);
+        void adaptQuality(int frameTime);
+        bool sendMessage(const MessageHeader & messageHeader, const QByteArray & payload);
+        bool readAcknowledgment(bool wait);
+        void finishFrame(int frameId, bool success);
+        int getNumDroppableJobs();
+};
+
+#endif
@@ -37,16 +37,17 @@
 /*********************************************************************/
 
 #include "dcStream.h"
+#include "DcSocket.h"
 #include "../NetworkProtocol.h"
 #include "../MessageHeader.h"
-#include "../ParallelPixelStreamSegmentParameters.h"
 #include "../log.h"
-#include <QtNetwork/QTcpSocket>
+#include "../JpegCompressor.h"
+#include "../LZ4Block.h"
 #include <QtCore>
 #include <cmath>
 #include <turbojpeg.h>
 #include <algorithm>
-#include <unistd.h>
+#include <cstring>
 
 // default to undefined frame index
 int g_dcStreamFrameIndex = FRAME_INDEX_UNDEFINED;
@@ -54,52 +55,23 @@ int g_dcStreamFrameIndex = FRAME_INDEX_UNDEFINED;
 // all current source indices for each stream name
 std::map<std::string, std::vector<int> > g_dcStreamSourceIndices;
 
-struct DcImage {
-    unsigned char * imageBuffer;
-    int width;
-    int pitch;
-    int height;
-    PIXEL_FORMAT pixelFormat;
-    char * jpegData;
-    int jpegSize;
-};
-
 // enum PIXEL_FORMAT { RGB, RGBA, ARGB, BGR, BGRA, ABGR };
 int dcBytesPerPixel[] = { 3, 4, 4, 3, 4, 4 };
 
-DcImage dcStreamComputeJpegMapped(const DcImage & dcImage);
+void dcStreamConvertToBGRA(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, unsigned char * bgraBuffer);
+void dcStreamAddSourceIndex(const DcStreamParameters & parameters);
+bool dcStreamSendMessages(DcSocket * socket, DcSendJob & job);
 
 
 DcSocket * dcStreamConnect(const char * hostname)
 {
-    DcSocket * socket = new QTcpSocket();
-
-    // open connection
-    socket->connectToHost(hostname, 1701);
+    // the connection is made by the socket's sender thread
+    DcSocket * socket = new DcSocket(hostname);
+    socket->start();
 
     if(socket->waitForConnected() != true)
     {
-        put_flog(LOG_ERROR, "could not connect to host %s", hostname);
-
-        return NULL;
-    }
-
-    // handshake
-    while(socket->waitForReadyRead() && socket->bytesAvailable() < (int)sizeof(int32_t))
-    {
-    #ifndef _WIN32
-        usleep(10);
-    #endif
-    }
-
-    int32_t protocolVersion = -1;
-    socket->read((char *)&protocolVersion, sizeof(int32_t));
-
-    if(protocolVersion != NETWORK_PROTOCOL_VERSION)
-    {
-        socket->disconnectFromHost();
-
-        put_flog(LOG_ERROR, "unsupported protocol version %i != %i", protocolVersion, NETWORK_PROTOCOL_VERSION);
+        delete socket;
 
         return NULL;
     }
@@ -109,6 +81,12 @@ DcSocket * dcStreamConnect(const char * hostname)
 
 void dcStreamDisconnect(DcSocket * socket)
 {
+    if(socket == NULL)
+    {
+        return;
+    }
+
+    // this waits for all queued frames to be sent and acknowledged
     delete socket;
 
     socket = NULL;
@@ -198,10 +176,11 @@ bool dcStreamSend(DcSocket * socket, unsigned char * imageBuffer, int imageX, in
     // compute JPEG from imageBuffer corresponding to parameters
     unsigned char * segmentImageBuffer = imageBuffer + (parameters.y - imageY)*imagePitch + (parameters.x - imageX)*dcBytesPerPixel[pixelFormat];
 
-    char * jpegData = NULL;
+    int jpegBufferSize = dcStreamGetMaxJpegSize(parameters.width, parameters.height);
+    char * jpegData = (char *)malloc(jpegBufferSize);
     int jpegSize = 0;
 
-    bool success = dcStreamComputeJpeg(segmentImageBuffer, parameters.width, imagePitch, parameters.height, pixelFormat, &jpegData, jpegSize);
+    bool success = dcStreamComputeJpeg(segmentImageBuffer, parameters.width, imagePitch, parameters.height, pixelFormat, jpegData, jpegBufferSize, jpegSize, dcStreamGetEncoderOptions(socket));
 
     if(success == false)
     {
@@ -223,148 +202,205 @@ bool dcStreamSend(DcSocket * socket, unsigned char * imageBuffer, int imageX, in
         imagePitch = imageWidth * dcBytesPerPixel[pixelFormat];
     }
 
-    // compute JPEGs from imageBuffer corresponding to parameters vector
-    std::vector<DcImage> dcImages;
+    // the sender thread compresses the segments in parallel directly from imageBuffer, while we wait
+    DcSendJob job;
+
+    job.imageBuffer = imageBuffer;
+    job.imageX = imageX;
+    job.imageY = imageY;
+    job.imageWidth = imageWidth;
+    job.imagePitch = imagePitch;
+    job.imageHeight = imageHeight;
+    job.pixelFormat = pixelFormat;
+    job.parameters = parameters;
+    job.frameIndex = g_dcStreamFrameIndex;
 
     for(unsigned int i=0; i<parameters.size(); i++)
     {
-        DcImage d;
-
-        // imageBuffer coordinates have the origin at the bottom-left corner.
-        // DisplayCluster's coordinates have the origin at the top-left.
-        // a transformation is needed to find the appropriate memory location within the full imageBuffer...
-        d.imageBuffer = imageBuffer + imageHeight*imagePitch - (parameters[i].y - imageY + parameters[i].height)*imagePitch + (parameters[i].x - imageX)*dcBytesPerPixel[pixelFormat];
+        dcStreamAddSourceIndex(parameters[i]);
+    }
 
-        d.width = parameters[i].width;
-        d.pitch = imagePitch;
-        d.height = parameters[i].height;
-        d.pixelFormat = pixelFormat;
-        d.jpegData = NULL;
-        d.jpegSize = 0;
+    return dcStreamSendMessages(socket, job);
+}
 
-        dcImages.push_back(d);
+bool dcStreamSendPixelStream(DcSocket * socket, std::string name, unsigned char * imageBuffer, int imageWidth, int imagePitch, int imageHeight, PIXEL_FORMAT pixelFormat)
+{
+    // compute imagePitch if necessary, assuming imageBuffer isn't padded
+    if(imagePitch == 0)
+    {
+        imagePitch = imageWidth * dcBytesPerPixel[pixelFormat];
     }
 
-    // create JPEGs for each segment, in parallel
+    // the sender thread compresses the image directly from imageBuffer, while we wait
+    DcSendJob job;
+
+    job.imageBuffer = imageBuffer;
+    job.imageWidth = imageWidth;
+    job.imagePitch = imagePitch;
+    job.imageHeight = imageHeight;
+    job.pixelFormat = pixelFormat;
+    job.pixelStreamName = name;
 
-    dcImages = QtConcurrent::blockingMapped<std::vector<DcImage> >(dcImages, &dcStreamComputeJpegMapped);
+    return dcStreamSendMessages(socket, job);
+}
 
-    // send each segment, and return true if we were successful for all segments
-    bool allSuccess = true;
+DcStreamEncoderOptions dcStreamGetDefaultEncoderOptions()
+{
+    DcStreamEncoderOptions options;
+
+    options.codec = DC_STREAM_CODEC_JPEG;
+    options.quality = 75;
+    options.subsampling = DC_STREAM_SUBSAMPLING_444;
+    options.fastDCT = false;
+    options.adaptive = false;
+    options.targetFrameRate = 30.;
+    options.minQuality = 30;
+    options.skipUnchangedSegments = true;
+
+    return options;
+}
 
-    for(unsigned int i=0; i<dcImages.size(); i++)
+void dcStreamSetEncoderOptions(DcSocket * socket, DcStreamEncoderOptions options)
+{
+    if(socket == NULL)
     {
-        // jpegSize == 0 indicates an error
-        if(dcImages[i].jpegSize == 0)
-        {
-            allSuccess = false;
-        }
-        else
-        {
-            bool sendSuccess = dcStreamSendJpeg(socket, parameters[i], dcImages[i].jpegData, dcImages[i].jpegSize);
+        return;
+    }
 
-            if(sendSuccess == false)
-            {
-                allSuccess = false;
-            }
-        }
+    socket->setEncoderOptions(options);
+}
 
-        free(dcImages[i].jpegData);
+DcStreamEncoderOptions dcStreamGetEncoderOptions(DcSocket * socket)
+{
+    if(socket == NULL)
+    {
+        return dcStreamGetDefaultEncoderOptions();
     }
 
-    return allSuccess;
+    return socket->getEncoderOptions();
 }
 
-bool dcStreamSendJpeg(DcSocket * socket, DcStreamParameters parameters, const char * jpegData, int jpegSize)
+int dcStreamSendAsync(DcSocket * socket, unsigned char * imageBuffer, int imageX, int imageY, int imageWidth, int imagePitch, int imageHeight, PIXEL_FORMAT pixelFormat, std::vector<DcStreamParameters> parameters, bool copyImageBuffer)
 {
     if(socket == NULL)
     {
         put_flog(LOG_ERROR, "socket is NULL");
 
-        return false;
+        return -1;
     }
 
-    if(socket->state() != QAbstractSocket::ConnectedState)
+    // compute imagePitch if necessary, assuming imageBuffer isn't padded
+    if(imagePitch == 0)
     {
-        put_flog(LOG_ERROR, "socket is not connected");
-
-        return false;
+        imagePitch = imageWidth * dcBytesPerPixel[pixelFormat];
     }
 
-    // send the parameters and image data
-    MessageHeader mh;
-    mh.size = sizeof(ParallelPixelStreamSegmentParameters) + jpegSize;
-    mh.type = MESSAGE_TYPE_PARALLEL_PIXELSTREAM;
+    DcSendJob job;
+    job.droppable = true;
 
-    // add the truncated URI to the header
-    size_t len = parameters.name.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
-    mh.uri[len] = '\0';
+    if(copyImageBuffer == true)
+    {
+        job.imageCopy = QByteArray((const char *)imageBuffer, imagePitch * imageHeight);
+        job.imageBuffer = (const unsigned char *)job.imageCopy.constData();
+    }
+    else
+    {
+        job.imageBuffer = imageBuffer;
+    }
 
-    // send the header
-    int sent = socket->write((const char *)&mh, sizeof(MessageHeader));
+    job.imageX = imageX;
+    job.imageY = imageY;
+    job.imageWidth = imageWidth;
+    job.imagePitch = imagePitch;
+    job.imageHeight = imageHeight;
+    job.pixelFormat = pixelFormat;
+    job.parameters = parameters;
+    job.frameIndex = g_dcStreamFrameIndex;
 
-    while(sent < (int)sizeof(MessageHeader))
+    for(unsigned int i=0; i<parameters.size(); i++)
     {
-        sent += socket->write((const char *)&mh + sent, sizeof(MessageHeader) - sent);
+        dcStreamAddSourceIndex(parameters[i]);
     }
 
-    // send the message
-
-    // part 1: parameters
-    ParallelPixelStreamSegmentParameters p;
+    int frameId = socket->enqueue(job);
 
-    p.sourceIndex = parameters.sourceIndex;
-    p.frameIndex = g_dcStreamFrameIndex;
-    p.x = parameters.x;
-    p.y = parameters.y;
-    p.width = parameters.width;
-    p.height = parameters.height;
-    p.totalWidth = parameters.totalWidth;
-    p.totalHeight = parameters.totalHeight;
+    if(frameId < 0)
+    {
+        put_flog(LOG_ERROR, "socket is not connected");
+    }
 
-    sent = socket->write((const char *)&(p), sizeof(ParallelPixelStreamSegmentParameters));
+    return frameId;
+}
 
-    while(sent < (int)sizeof(ParallelPixelStreamSegmentParameters))
+bool dcStreamWaitForFrame(DcSocket * socket, int frameId)
+{
+    if(socket == NULL || frameId < 0)
     {
-        sent += socket->write((const char *)&(p) + sent, sizeof(ParallelPixelStreamSegmentParameters) - sent);
+        return false;
     }
 
-    // part 2: image data
-    if(jpegSize > 0)
+    return socket->waitForFrame(frameId);
+}
+
+bool dcStreamFrameFinished(DcSocket * socket, int frameId)
+{
+    if(socket == NULL || frameId < 0)
     {
-        sent = socket->write(jpegData, jpegSize);
+        return true;
+    }
 
-        while(sent < jpegSize)
-        {
-            sent += socket->write(jpegData + sent, jpegSize - sent);
-        }
+    return socket->isFrameFinished(frameId);
+}
+
+void dcStreamSetQueuePolicy(DcSocket * socket, DC_STREAM_QUEUE_POLICY policy, int maxQueuedFrames)
+{
+    if(socket == NULL)
+    {
+        return;
     }
 
-    // wait for acknowledgment
-    while(socket->waitForReadyRead() && socket->bytesAvailable() < 3)
+    socket->setQueuePolicy(policy, maxQueuedFrames);
+}
+
+bool dcStreamSendJpeg(DcSocket * socket, DcStreamParameters parameters, const char * jpegData, int jpegSize)
+{
+    if(socket == NULL)
     {
-#ifndef _WIN32
-        usleep(10);
-#endif
+        put_flog(LOG_ERROR, "socket is NULL");
+
+        return false;
     }
 
-    socket->read(3);
+    DcSendJob job;
 
-    // make sure this sourceIndex is in the vector of current source indices for this stream name
-    if(count(g_dcStreamSourceIndices[parameters.name].begin(), g_dcStreamSourceIndices[parameters.name].end(), parameters.sourceIndex) == 0)
+    socket->appendSegmentMessage(job, parameters, g_dcStreamFrameIndex, jpegData, jpegSize);
+
+    if(dcStreamSendMessages(socket, job) != true)
     {
-        g_dcStreamSourceIndices[parameters.name].push_back(parameters.sourceIndex);
+        return false;
     }
 
+    // make sure this sourceIndex is in the vector of current source indices for this stream name
+    dcStreamAddSourceIndex(parameters);
+
     return true;
 }
 
 bool dcStreamComputeJpeg(unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char ** jpegData, int & jpegSize)
 {
-    // use libjpeg-turbo for JPEG conversion
+    // make room for the largest possible JPEG, and compress directly into it
+    int jpegBufferSize = dcStreamGetMaxJpegSize(width, height);
+
+    *jpegData = (char *)realloc((void *)*jpegData, jpegBufferSize);
+
+    return dcStreamComputeJpeg(imageBuffer, width, pitch, height, pixelFormat, *jpegData, jpegBufferSize, jpegSize);
+}
+
+bool dcStreamComputeJpeg(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char * jpegBuffer, int jpegBufferSize, int & jpegSize, DcStreamEncoderOptions encoderOptions)
+{
+    // use libjpeg-turbo for JPEG conversion, with a handle reused by this thread
 
-    // use a new handle each time for thread-safety
-    tjhandle tjHandle = tjInitCompress();
+    jpegSize = 0;
 
     // compute pitch if necessary, assuming imageBuffer isn't padded
     if(pitch == 0)
@@ -401,63 +437,150 @@ bool dcStreamComputeJpeg(unsigned char * imageBuffer, int width, int pitch, int
             return false;
     }
 
-    unsigned char ** tjJpegBuf;
-    unsigned char * tjJpegBufPtr = NULL;
-    tjJpegBuf = &tjJpegBufPtr;
-    unsigned long tjJpegSize = 0;
-    int tjJpegSubsamp = TJSAMP_444;
-    int tjJpegQual = 75;
-    int tjFlags = TJFLAG_BOTTOMUP;
+    // map subsampling to the libjpeg-turbo equivalent
+    int tjJpegSubsamp;
+
+    switch(encoderOptions.subsampling)
+    {
+        case DC_STREAM_SUBSAMPLING_422:
+            tjJpegSubsamp = TJSAMP_422;
+            break;
+        case DC_STREAM_SUBSAMPLING_420:
+            tjJpegSubsamp = TJSAMP_420;
+            break;
+        default:
+            tjJpegSubsamp = TJSAMP_444;
+            break;
+    }
 
-    int success = tjCompress2(tjHandle, imageBuffer, width, pitch, height, tjPixelFormat, tjJpegBuf, &tjJpegSize, tjJpegSubsamp, tjJpegQual, tjFlags);
+    int tjJpegQual = std::max(1, std::min(encoderOptions.quality, 100));
+    int tjFlags = TJFLAG_BOTTOMUP;
 
-    if(success != 0)
+    if(encoderOptions.fastDCT == true)
     {
-        put_flog(LOG_ERROR, "libjpeg-turbo image conversion failure");
+        tjFlags |= TJFLAG_FASTDCT;
+    }
 
-        jpegSize = 0;
+    jpegSize = JpegCompressor::getThreadCompressor()->compress(imageBuffer, width, pitch, height, tjPixelFormat, tjJpegSubsamp, tjJpegQual, tjFlags, (unsigned char *)jpegBuffer, jpegBufferSize);
 
-        // destroy libjpeg-turbo handle
-        tjDestroy(tjHandle);
+    return jpegSize > 0;
+}
+
+int dcStreamGetMaxJpegSize(int width, int height)
+{
+    // 4:4:4 is the largest for any subsampling
+    return JpegCompressor::getMaxSize(width, height, TJSAMP_444);
+}
+
+bool dcStreamComputeSegment(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char * buffer, int bufferSize, int & size, DcStreamEncoderOptions encoderOptions)
+{
+    size = 0;
 
+    if(encoderOptions.codec == DC_STREAM_CODEC_JPEG)
+    {
+        return dcStreamComputeJpeg(imageBuffer, width, pitch, height, pixelFormat, buffer, bufferSize, size, encoderOptions);
+    }
+
+    if(bufferSize < dcStreamGetMaxSegmentSize(width, height, encoderOptions.codec))
+    {
+        put_flog(LOG_ERROR, "buffer too small");
         return false;
     }
 
-    // move the JPEG buffer to our own memory and free the libjpeg-turbo allocated memory
-    *jpegData = (char *)realloc((void *)*jpegData, tjJpegSize);
-    memcpy(*jpegData, tjJpegBufPtr, tjJpegSize);
-    tjFree(tjJpegBufPtr);
+    // compute pitch if necessary, assuming imageBuffer isn't padded
+    if(pitch == 0)
+    {
+        pitch = width * dcBytesPerPixel[pixelFormat];
+    }
+
+    int rawSize = width * height * 4;
+
+    if(encoderOptions.codec == DC_STREAM_CODEC_RAW)
+    {
+        dcStreamConvertToBGRA(imageBuffer, width, pitch, height, pixelFormat, (unsigned char *)buffer);
 
-    jpegSize = tjJpegSize;
+        size = rawSize;
+    }
+    else if(encoderOptions.codec == DC_STREAM_CODEC_LZ4)
+    {
+        // convert into the end of the buffer, and compress into its beginning
+        int compressedBufferSize = bufferSize - rawSize;
+        char * rawData = buffer + compressedBufferSize;
 
-    // destroy libjpeg-turbo handle
-    tjDestroy(tjHandle);
+        dcStreamConvertToBGRA(imageBuffer, width, pitch, height, pixelFormat, (unsigned char *)rawData);
 
-    return true;
+        size = lz4CompressBlock(rawData, rawSize, buffer, compressedBufferSize);
+    }
+    else
+    {
+        put_flog(LOG_ERROR, "unknown codec %i", encoderOptions.codec);
+    }
+
+    return size > 0;
 }
 
-void dcStreamIncrementFrameIndex()
+int dcStreamGetMaxSegmentSize(int width, int height, DC_STREAM_CODEC codec)
 {
-    g_dcStreamFrameIndex++;
+    int rawSize = width * height * 4;
+
+    if(codec == DC_STREAM_CODEC_RAW)
+    {
+        return rawSize;
+    }
+    else if(codec == DC_STREAM_CODEC_LZ4)
+    {
+        // room for the raw pixels too, which are converted before they are compressed
+        return lz4GetMaxCompressedSize(rawSize) + rawSize;
+    }
+
+    return dcStreamGetMaxJpegSize(width, height);
 }
 
-bool dcStreamSendSVG(DcSocket * socket, std::string name, const char * svgData, int svgSize)
+void dcStreamConvertToBGRA(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, unsigned char * bgraBuffer)
 {
-    if(socket == NULL)
-    {
-        put_flog(LOG_ERROR, "socket is NULL");
+    // imageBuffer has the bottom row first, like for TJFLAG_BOTTOMUP; the BGRA rows are top row first
+    int bytesPerPixel = dcBytesPerPixel[pixelFormat];
 
-        return false;
-    }
+    // byte offsets of blue, green, red in a source pixel
+    // enum PIXEL_FORMAT { RGB, RGBA, ARGB, BGR, BGRA, ABGR };
+    int offsets[][3] = { {2,1,0}, {2,1,0}, {3,2,1}, {0,1,2}, {0,1,2}, {1,2,3} };
+
+    int b = offsets[pixelFormat][0];
+    int g = offsets[pixelFormat][1];
+    int r = offsets[pixelFormat][2];
 
-    if(socket->state() != QAbstractSocket::ConnectedState)
+    for(int y=0; y<height; y++)
     {
-        put_flog(LOG_ERROR, "socket is not connected");
+        const unsigned char * source = imageBuffer + (height - 1 - y) * pitch;
+        unsigned char * destination = bgraBuffer + y * width * 4;
 
-        return false;
+        if(pixelFormat == BGRA)
+        {
+            memcpy(destination, source, width * 4);
+        }
+        else
+        {
+            for(int x=0; x<width; x++)
+            {
+                destination[0] = source[b];
+                destination[1] = source[g];
+                destination[2] = source[r];
+                destination[3] = 255;
+
+                source += bytesPerPixel;
+                destination += 4;
+            }
+        }
     }
+}
+
+void dcStreamIncrementFrameIndex()
+{
+    g_dcStreamFrameIndex++;
+}
 
-    // send the parameters and image data
+bool dcStreamSendSVG(DcSocket * socket, std::string name, const char * svgData, int svgSize)
+{
     MessageHeader mh;
     mh.size = svgSize;
     mh.type = MESSAGE_TYPE_SVG_STREAM;
@@ -466,45 +589,39 @@ bool dcStreamSendSVG(DcSocket * socket, std::string name, const char * svgData,
     size_t len = name.copy(mh.uri, MESSAGE_HEADER_URI_LENGTH - 1);
     mh.uri[len] = '\0';
 
-    // send the header
-    int sent = socket->write((const char *)&mh, sizeof(MessageHeader));
+    DcSendJob job;
+    job.headers.push_back(mh);
+    job.payloads.push_back(QByteArray(svgData, svgSize));
 
-    while(sent < (int)sizeof(MessageHeader))
-    {
-        sent += socket->write((const char *)&mh + sent, sizeof(MessageHeader) - sent);
-    }
-
-    // send the message
+    return dcStreamSendMessages(socket, job);
+}
 
-    // part 1: image data
-    if(svgSize > 0)
+void dcStreamAddSourceIndex(const DcStreamParameters & parameters)
+{
+    if(count(g_dcStreamSourceIndices[parameters.name].begin(), g_dcStreamSourceIndices[parameters.name].end(), parameters.sourceIndex) == 0)
     {
-        sent = socket->write(svgData, svgSize);
-
-        while(sent < svgSize)
-        {
-            sent += socket->write(svgData + sent, svgSize - sent);
-        }
+        g_dcStreamSourceIndices[parameters.name].push_back(parameters.sourceIndex);
     }
+}
 
-    // wait for acknowledgment
-    while(socket->waitForReadyRead() && socket->bytesAvailable() < 3)
+bool dcStreamSendMessages(DcSocket * socket, DcSendJob & job)
+{
+    if(socket == NULL)
     {
-#ifndef _WIN32
-        usleep(10);
-#endif
-    }
+        put_flog(LOG_ERROR, "socket is NULL");
 
-    socket->read(3);
+        return false;
+    }
 
-    return true;
-}
+    // queue the job for the sender thread and wait for it
+    int frameId = socket->enqueue(job);
 
-DcImage dcStreamComputeJpegMapped(const DcImage & dcImage)
-{
-    DcImage newDcImage = dcImage;
+    if(frameId < 0)
+    {
+        put_flog(LOG_ERROR, "socket is not connected");
 
-    dcStreamComputeJpeg(newDcImage.imageBuffer, newDcImage.width, newDcImage.pitch, newDcImage.height, newDcImage.pixelFormat, &newDcImage.jpegData, newDcImage.jpegSize);
+        return false;
+    }
 
-    return newDcImage;
+    return socket->waitForFrame(frameId);
 }
@@ -42,8 +42,7 @@
 #include <string>
 #include <vector>
 
-class QTcpSocket;
-typedef QTcpSocket DcSocket;
+class DcSocket;
 
 struct DcStreamParameters  {
     std::string name;
@@ -58,9 +57,42 @@ struct DcStreamParameters  {
 
 enum PIXEL_FORMAT { RGB=0, RGBA=1, ARGB=2, BGR=3, BGRA=4, ABGR=5 };
 
+// chroma subsampling of compressed segments; 4:2:0 is about half the size of
+// 4:4:4 at the cost of color resolution.
+enum DC_STREAM_SUBSAMPLING { DC_STREAM_SUBSAMPLING_444=0, DC_STREAM_SUBSAMPLING_422=1, DC_STREAM_SUBSAMPLING_420=2 };
+
+// codec of segment image data. raw and LZ4 are lossless; raw needs no
+// compression at all, and LZ4 is fast enough for LAN links. they are only used
+// with DisplayCluster instances supporting them, otherwise JPEG is used.
+enum DC_STREAM_CODEC { DC_STREAM_CODEC_JPEG=0, DC_STREAM_CODEC_RAW=1, DC_STREAM_CODEC_LZ4=2 };
+
+// encoder settings for a connection. codec selects the codec, and the
+// remaining settings apply to JPEG. quality is from 1 to 100, and
+// fastDCT trades some accuracy for faster compression. in adaptive mode, the
+// quality is lowered (down to minQuality) when compressing and sending a frame
+// takes longer than 1 / targetFrameRate or frames are queuing up, and raised
+// again (up to quality) when there is time to spare. with
+// skipUnchangedSegments, segments whose pixels didn't change since they were
+// last sent are neither compressed nor sent again.
+struct DcStreamEncoderOptions {
+    DC_STREAM_CODEC codec;
+    int quality;
+    DC_STREAM_SUBSAMPLING subsampling;
+    bool fastDCT;
+    bool adaptive;
+    float targetFrameRate;
+    int minQuality;
+    bool skipUnchangedSegments;
+};
+
+// what dcStreamSendAsync() does when too many frames are already queued: block
+// until one has been sent, or drop the oldest queued frame.
+enum DC_STREAM_QUEUE_POLICY { DC_STREAM_QUEUE_BLOCK=0, DC_STREAM_QUEUE_DROP_OLDEST=1 };
+
 // make a new connection to the DisplayCluster instance on hostname, and
 // returns a DcSocket. the user is responsible for closing the socket using
-// dcStreamDisconnect().
+// dcStreamDisconnect(). hostname may be given as hostname:port to connect to
+// a port other than the default 1701.
 extern DcSocket * dcStreamConnect(const char * hostname);
 
 // closes a previously opened connection, deleting the socket.
@@ -92,14 +124,68 @@ extern bool dcStreamSend(DcSocket * socket, unsigned char * imageBuffer, int ima
 // given vector of parameters. compression of segment image data is parallel.
 extern bool dcStreamSend(DcSocket * socket, unsigned char * imageBuffer, int imageX, int imageY, int imageWidth, int imagePitch, int imageHeight, PIXEL_FORMAT pixelFormat, std::vector<DcStreamParameters> parameters);
 
+// compresses imageBuffer as a single JPEG image and sends it to a DisplayCluster
+// instance over socket as the (non-parallel) pixel stream <name>. the image
+// dimensions are sent too when they change. imagePitch is the bytes per line
+// in imageBuffer, which has the bottom row first. the encoder options of the
+// connection apply, except that the codec is always JPEG.
+extern bool dcStreamSendPixelStream(DcSocket * socket, std::string name, unsigned char * imageBuffer, int imageWidth, int imagePitch, int imageHeight, PIXEL_FORMAT pixelFormat);
+
+// returns the default encoder options: JPEG with quality 75, 4:4:4 subsampling, accurate
+// DCT, no adaptive quality, and skipping of unchanged segments.
+extern DcStreamEncoderOptions dcStreamGetDefaultEncoderOptions();
+
+// sets the encoder options used for all segments compressed for this
+// connection from now on.
+extern void dcStreamSetEncoderOptions(DcSocket * socket, DcStreamEncoderOptions options);
+
+// returns the encoder options of this connection. in adaptive mode, quality is
+// the current adapted quality, and codec is the codec actually used.
+extern DcStreamEncoderOptions dcStreamGetEncoderOptions(DcSocket * socket);
+
+// queues a group of segments for compression and sending by the connection's
+// sender thread, and returns immediately with a frame id (-1 on failure). if
+// copyImageBuffer is false, imageBuffer is leased to the sender thread and must
+// not be modified or freed until the frame is finished. the current frame index
+// is captured when the frame is queued.
+extern int dcStreamSendAsync(DcSocket * socket, unsigned char * imageBuffer, int imageX, int imageY, int imageWidth, int imagePitch, int imageHeight, PIXEL_FORMAT pixelFormat, std::vector<DcStreamParameters> parameters, bool copyImageBuffer=true);
+
+// waits until a frame queued with dcStreamSendAsync() is sent. returns false
+// if it was dropped or could not be sent.
+extern bool dcStreamWaitForFrame(DcSocket * socket, int frameId);
+
+// returns true if a frame queued with dcStreamSendAsync() was sent or dropped.
+extern bool dcStreamFrameFinished(DcSocket * socket, int frameId);
+
+// sets the policy applied when more than maxQueuedFrames frames are queued
+// by dcStreamSendAsync(). the default is to block with 2 queued frames.
+extern void dcStreamSetQueuePolicy(DcSocket * socket, DC_STREAM_QUEUE_POLICY policy, int maxQueuedFrames);
+
 // sends a compressed JPEG image corresponding to parameters and sends it to a
 // DisplayCluster instance over socket.
 extern bool dcStreamSendJpeg(DcSocket * socket, DcStreamParameters parameters, const char * jpegData, int jpegSize);
 
-// computes a compressed JPEG image corresponding to imageBuffer. results are
-// stored in jpegData and jpegSize.
+// computes a compressed JPEG image corresponding to imageBuffer with the
+// default encoder options. results are stored in jpegData and jpegSize.
 extern bool dcStreamComputeJpeg(unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char ** jpegData, int & jpegSize);
 
+// the same as above, except compresses into a caller-owned jpegBuffer of
+// jpegBufferSize bytes, which must be at least dcStreamGetMaxJpegSize(), with
+// the given encoder options. no memory is allocated, so buffers can be reused
+// across frames.
+extern bool dcStreamComputeJpeg(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char * jpegBuffer, int jpegBufferSize, int & jpegSize, DcStreamEncoderOptions encoderOptions = dcStreamGetDefaultEncoderOptions());
+
+// returns the maximum size of a compressed JPEG image of the given dimensions.
+extern int dcStreamGetMaxJpegSize(int width, int height);
+
+// computes a compressed segment corresponding to imageBuffer with the codec
+// and settings in encoderOptions, into a caller-owned buffer of bufferSize
+// bytes, which must be at least dcStreamGetMaxSegmentSize().
+extern bool dcStreamComputeSegment(const unsigned char * imageBuffer, int width, int pitch, int height, PIXEL_FORMAT pixelFormat, char * buffer, int bufferSize, int & size, DcStreamEncoderOptions encoderOptions);
+
+// returns the size of the buffer needed by dcStreamComputeSegment().
+extern int dcStreamGetMaxSegmentSize(int width, int height, DC_STREAM_CODEC codec);
+
 // increment the frame index for all segments sent by this process. this is
 // used for frame synchronization.
 extern void dcStreamIncrementFrameIndex();
@@ -44,6 +44,9 @@
 #include <stdlib.h>
 #include "SSaver.h"
 #include "Remote.h"
+#include "MessageReceiverThread.h"
+#include "PixelStream.h"
+#include "DynamicTextureScheduler.h"
 
 #if ENABLE_TUIO_TOUCH_LISTENER
     #include "TouchListener.h"
@@ -69,6 +72,8 @@ Configuration * g_configuration = NULL;
 boost::shared_ptr<DisplayGroupManager> g_displayGroupManager;
 MainWindow * g_mainWindow = NULL;
 NetworkListener * g_networkListener = NULL;
+FrameTelemetry * g_frameTelemetry = NULL;
+DecodedTileCache * g_decodedTileCache = NULL;
 Remote * g_Remote = NULL;
 long g_frameCount = 0;
 
@@ -92,7 +97,9 @@ int main(int argc, char * argv[])
     XInitThreads();
 #endif
 
-    MPI_Init(&argc, &argv);
+    // messages are received in a separate thread on the render processes if MPI supports it
+    int mpiThreadSupport;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpiThreadSupport);
     MPI_Comm_rank(MPI_COMM_WORLD, &g_mpiRank);
     MPI_Comm_size(MPI_COMM_WORLD, &g_mpiSize);
     MPI_Comm_split(MPI_COMM_WORLD, g_mpiRank != 0, g_mpiRank, &g_mpiRenderComm);
@@ -121,6 +128,9 @@ int main(int argc, char * argv[])
     g_configuration = new Configuration((std::string(g_displayClusterDir) + std::string("/configuration.xml")).c_str());
 		setenv("DISPLAY", g_configuration->getMyDisplay().c_str(), 1);
 
+    // decoded image pyramid tiles, shared by all windows
+    g_decodedTileCache = new DecodedTileCache((size_t)g_configuration->getDecodedTileCacheSize() * 1024 * 1024);
+
     boost::shared_ptr<DisplayGroupManager> dgm(new DisplayGroupManager);
     g_displayGroupManager = dgm;
 
@@ -177,16 +187,61 @@ int main(int argc, char * argv[])
         g_Remote = new Remote();
     }
 
+    // collects frame times from the render processes at rank 0
+    g_frameTelemetry = new FrameTelemetry();
+
     g_mainWindow = new MainWindow();
 
+    // start receiving messages for the next frames while rendering the current frame
+    // all render processes must agree, since the messages are then applied differently
+    if(g_mpiRank != 0)
+    {
+        int pipelined = (mpiThreadSupport == MPI_THREAD_MULTIPLE);
+        MPI_Allreduce(MPI_IN_PLACE, (void *)&pipelined, 1, MPI_INT, MPI_MIN, g_mpiRenderComm);
+
+        if(pipelined != 0)
+        {
+            g_messageReceiverThread = new MessageReceiverThread();
+            g_messageReceiverThread->start();
+        }
+        else
+        {
+            put_flog(LOG_WARN, "MPI_THREAD_MULTIPLE not supported, receiving messages in the main thread");
+        }
+    }
+
     // enter Qt event loop
     g_app->exec();
 
     put_flog(LOG_DEBUG, "quitting");
 
+    // the message receiver thread starts decode tasks and uses the main window, and must not be in MPI calls during
+    // MPI_Finalize(); it has normally stopped already after receiving the quit message
+    if(g_messageReceiverThread != NULL)
+    {
+        g_messageReceiverThread->stop();
+
+        if(g_messageReceiverThread->wait(MESSAGE_RECEIVER_THREAD_STOP_TIMEOUT) != true)
+        {
+            // finalizing would hang or fail with the thread still in a collective; exit without it
+            put_flog(LOG_ERROR, "message receiver thread did not stop, exiting without finalizing MPI");
+
+            return 1;
+        }
+
+        delete g_messageReceiverThread;
+        g_messageReceiverThread = NULL;
+    }
+
     // wait for all threads to finish
     QThreadPool::globalInstance()->waitForDone();
 
+    // decode tasks release textures through the main window's GLWindow, so they must finish before it is deleted
+    PixelStreamDecodeTask::getThreadPool()->waitForDone();
+
+    // the same for DynamicTexture tile loads
+    g_dynamicTextureScheduler.shutdown();
+
     // call finalize cleanup actions
     g_mainWindow->finalize();
 
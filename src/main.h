@@ -43,6 +43,8 @@
 #include "MainWindow.h"
 #include "DisplayGroupManager.h"
 #include "NetworkListener.h"
+#include "FrameTelemetry.h"
+#include "DecodedTileCache.h"
 #include "config.h"
 #include <boost/shared_ptr.hpp>
 #include <mpi.h>
@@ -111,6 +113,8 @@ extern Configuration * g_configuration;
 extern boost::shared_ptr<DisplayGroupManager> g_displayGroupManager;
 extern MainWindow * g_mainWindow;
 extern NetworkListener * g_networkListener;
+extern FrameTelemetry * g_frameTelemetry;
+extern DecodedTileCache * g_decodedTileCache;
 extern long g_frameCount;
 
 #if ENABLE_SKELETON_SUPPORT